@@ -0,0 +1,156 @@
+/**
+ * @file cuckooFilterBench.cpp
+ * @brief Pantry membership with and without a CuckooFilter in front of the index.
+ *
+ * For pantries of growing size, mostly-negative lookups (as in availability
+ * matching, where most required ingredients are not in stock) are answered
+ * by the pantry index alone and by the filter followed by the index. The
+ * measured false-positive rate and the filter size are reported, before and
+ * after half of the pantry is consumed (erased).
+ *
+ * Usage: cuckooFilterBench [hit percent]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "cuckooFilter.hpp"
+#include "flatHashMap.hpp"
+
+namespace
+{
+  constexpr size_t queryCount = 1 << 22;
+
+  constexpr size_t runsPerLookup = 3;
+
+  /**
+   * @brief Runs the queries several times and returns the best nanoseconds per lookup.
+   */
+  template <typename F>
+  double measure(F &&lookup, const std::vector<std::uint32_t> &queries, size_t &sink)
+  {
+    double best = 0;
+    for (size_t run = 0; run < runsPerLookup; ++run)
+    {
+      auto start = std::chrono::steady_clock::now();
+      for (std::uint32_t key : queries)
+      {
+        sink += lookup(key);
+      }
+      std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+      double ns = elapsed.count() / static_cast<double>(queries.size());
+      best = run == 0 ? ns : std::min(best, ns);
+    }
+    return best;
+  }
+
+  /**
+   * @brief Times both lookups and measures the false-positive rate for one pantry.
+   *
+   * @param [in] present Keys currently in the pantry
+   * @param [in] absent Keys known not to be in the pantry
+   */
+  void report(const char *label, const FlatHashMap<std::uint32_t, std::uint32_t> &index,
+              const CuckooFilter &filter, const std::vector<std::uint32_t> &present,
+              const std::vector<std::uint32_t> &absent, unsigned hitPercent, std::mt19937 &rng)
+  {
+    for (std::uint32_t key : present)
+    {
+      if (!filter.contains(key))
+      {
+        std::cerr << "False negative for key " << key << "." << std::endl;
+        return;
+      }
+    }
+    size_t falsePositives = 0;
+    for (std::uint32_t key : absent)
+    {
+      falsePositives += filter.contains(key);
+    }
+
+    std::vector<std::uint32_t> queries(queryCount);
+    for (auto &query : queries)
+    {
+      bool hit = !present.empty() && rng() % 100 < hitPercent;
+      query = hit ? present[rng() % present.size()] : absent[rng() % absent.size()];
+    }
+
+    size_t sink = 0;
+    double indexOnly = measure([&](std::uint32_t key)
+                               { return index.contains(key); }, queries, sink);
+    double filtered = measure([&](std::uint32_t key)
+                              { return filter.contains(key) && index.contains(key); }, queries, sink);
+    std::cout << "  " << std::left << std::setw(16) << label << std::right << std::setw(9) << present.size()
+              << std::setw(10) << filter.slotCount() * sizeof(std::uint16_t) / 1024 << " KiB"
+              << std::fixed << std::setprecision(4) << std::setw(10)
+              << 100.0 * static_cast<double>(falsePositives) / static_cast<double>(absent.size()) << " %"
+              << std::setprecision(2) << std::setw(10) << indexOnly << " ns" << std::setw(10) << filtered << " ns"
+              << std::setw(8) << indexOnly / filtered << "x  (checksum " << sink << ")" << std::endl;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  unsigned hitPercent = argc > 1 ? static_cast<unsigned>(std::stoul(argv[1])) : 10;
+  if (hitPercent > 100)
+  {
+    std::cerr << "Usage: cuckooFilterBench [hit percent]" << std::endl;
+    return 1;
+  }
+
+  std::cout << hitPercent << "% of lookups hit the pantry\n"
+            << "  " << std::left << std::setw(16) << "pantry" << std::right << std::setw(9) << "keys"
+            << std::setw(14) << "filter" << std::setw(12) << "false pos" << std::setw(13) << "index"
+            << std::setw(13) << "filtered" << std::setw(9) << "speedup" << std::endl;
+
+  std::mt19937 rng(42);
+  for (size_t size : {size_t(1000), size_t(10000), size_t(100000), size_t(300000), size_t(1000000)})
+  {
+    std::unordered_set<std::uint32_t> used;
+    std::vector<std::uint32_t> present;
+    std::vector<std::uint32_t> absent;
+    while (present.size() < size)
+    {
+      std::uint32_t key = static_cast<std::uint32_t>(rng());
+      if (used.insert(key).second)
+        present.push_back(key);
+    }
+    while (absent.size() < 1000000)
+    {
+      std::uint32_t key = static_cast<std::uint32_t>(rng());
+      if (used.insert(key).second)
+        absent.push_back(key);
+    }
+
+    FlatHashMap<std::uint32_t, std::uint32_t> index;
+    CuckooFilter filter(size);
+    for (std::uint32_t key : present)
+    {
+      index.tryEmplace(key, key);
+      if (!filter.insert(key))
+      {
+        std::cerr << "Filter full at " << filter.size() << " keys." << std::endl;
+        return 1;
+      }
+    }
+    report("full", index, filter, present, absent, hitPercent, rng);
+
+    // Consume half the pantry: erased keys become negatives.
+    size_t half = present.size() / 2;
+    for (size_t i = half; i < present.size(); ++i)
+    {
+      index.erase(present[i]);
+      filter.erase(present[i]);
+    }
+    absent.insert(absent.end(), present.begin() + static_cast<std::ptrdiff_t>(half), present.end());
+    present.resize(half);
+    report("half consumed", index, filter, present, absent, hitPercent, rng);
+  }
+  return 0;
+}
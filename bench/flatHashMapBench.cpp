@@ -0,0 +1,194 @@
+/**
+ * @file flatHashMapBench.cpp
+ * @brief Microbenchmark of FlatHashMap against std::unordered_map.
+ *
+ * Keys are the ingredient names of a recipes file, and lookups follow how
+ * often each name appears in the recipes, so a few staples ("salt",
+ * "olive oil") dominate as they do in real catalogs. The catalog is then
+ * scaled up with suffixed copies of every name, to see what happens once
+ * the table no longer fits in the L1 cache.
+ *
+ * Usage: flatHashMapBench [recipes.json]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "../imports/nlohmann/json.hpp"
+#include "flatHashMap.hpp"
+
+namespace
+{
+  constexpr size_t lookupsPerRun = 2000000;
+
+  /**
+   * @brief Runs a lookup loop and returns nanoseconds per lookup.
+   */
+  template <typename F>
+  double measure(F &&lookup, size_t &sink)
+  {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < lookupsPerRun; ++i)
+    {
+      sink += lookup(i);
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / static_cast<double>(lookupsPerRun);
+  }
+
+  void report(const char *label, double ns)
+  {
+    std::cout << "  " << std::left << std::setw(44) << label << std::right << std::setw(8)
+              << std::fixed << std::setprecision(2) << ns << " ns/lookup" << std::endl;
+  }
+
+  /**
+   * @brief Benchmarks name -> id lookups for one catalog.
+   *
+   * @param [in] names Distinct names; the id of a name is its index
+   * @param [in] queries Indexes into names, in lookup order (hits)
+   * @param [in] misses Names that are not in the table
+   */
+  void runNames(const std::vector<std::string> &names, const std::vector<std::uint32_t> &queries,
+                const std::vector<std::string> &misses)
+  {
+    std::unordered_map<std::string, std::uint32_t> stdMap;
+    FlatHashMap<std::string, std::uint32_t, StringHash> flatMap;
+    for (std::uint32_t id = 0; id < names.size(); ++id)
+    {
+      stdMap.emplace(names[id], id);
+      flatMap.tryEmplace(names[id], id);
+    }
+
+    // Queries arrive as views into a parsed buffer, as in the loaders.
+    std::vector<std::string_view> views;
+    std::vector<size_t> hashes;
+    for (std::uint32_t query : queries)
+    {
+      views.push_back(names[query]);
+      hashes.push_back(flatMap.hashOf(views.back()));
+    }
+    size_t mask = views.size() - 1;
+    size_t sink = 0;
+
+    std::cout << names.size() << " names, " << views.size() << " queries in the stream\n";
+    report("std::unordered_map, std::string key", measure([&](size_t i)
+                                                           { return stdMap.find(names[queries[i & mask]])->second; }, sink));
+    report("std::unordered_map, string_view -> string", measure([&](size_t i)
+                                                                 { return stdMap.find(std::string(views[i & mask]))->second; }, sink));
+    report("FlatHashMap, string_view", measure([&](size_t i)
+                                               { return *flatMap.find(views[i & mask]); }, sink));
+    report("FlatHashMap, string_view + precomputed hash", measure([&](size_t i)
+                                                                   { return *flatMap.find(views[i & mask], hashes[i & mask]); }, sink));
+
+    size_t missMask = misses.size() - 1;
+    report("std::unordered_map, miss", measure([&](size_t i)
+                                               { return stdMap.count(misses[i & missMask]); }, sink));
+    report("FlatHashMap, miss", measure([&](size_t i)
+                                        { return static_cast<size_t>(flatMap.contains(std::string_view(misses[i & missMask]))); }, sink));
+
+    // The pantry index maps the interned ids themselves.
+    std::unordered_map<std::uint32_t, std::uint32_t> stdIds;
+    FlatHashMap<std::uint32_t, std::uint32_t> flatIds;
+    for (std::uint32_t id = 0; id < names.size(); ++id)
+    {
+      stdIds.emplace(id, id);
+      flatIds.tryEmplace(id, id);
+    }
+    report("std::unordered_map, uint32 id", measure([&](size_t i)
+                                                    { return stdIds.find(queries[i & mask])->second; }, sink));
+    report("FlatHashMap, uint32 id", measure([&](size_t i)
+                                             { return *flatIds.find(queries[i & mask]); }, sink));
+    std::cout << "  (checksum " << sink << ")\n"
+              << std::endl;
+  }
+
+  /**
+   * @brief Returns the smallest power of two that is at least n.
+   */
+  size_t roundUp(size_t n)
+  {
+    size_t p = 1;
+    while (p < n)
+      p *= 2;
+    return p;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  std::string path = argc > 1 ? argv[1] : "../data/recipes.json";
+  std::ifstream file(path);
+  if (!file.is_open())
+  {
+    std::cerr << "File " << path << " not found or cannot be opened." << std::endl;
+    return 1;
+  }
+  nlohmann::json recipes;
+  try
+  {
+    file >> recipes;
+  }
+  catch (const nlohmann::json::exception &e)
+  {
+    std::cerr << "File " << path << " is not valid JSON: " << e.what() << std::endl;
+    return 1;
+  }
+
+  // Distinct names, and one entry per occurrence to draw queries from.
+  std::vector<std::string> baseNames;
+  std::unordered_map<std::string, std::uint32_t> ids;
+  std::vector<std::uint32_t> occurrences;
+  for (const auto &recipe : recipes)
+  {
+    for (const auto &ingredient : recipe["ingredients"])
+    {
+      std::string name = ingredient.value("name", "");
+      auto inserted = ids.emplace(name, static_cast<std::uint32_t>(baseNames.size()));
+      if (inserted.second)
+        baseNames.push_back(name);
+      occurrences.push_back(inserted.first->second);
+    }
+  }
+  if (baseNames.empty())
+  {
+    std::cerr << "No ingredients found in " << path << "." << std::endl;
+    return 1;
+  }
+
+  std::mt19937 rng(42);
+  for (size_t copies : {size_t(1), size_t(100), size_t(1000)})
+  {
+    std::vector<std::string> names;
+    for (size_t copy = 0; copy < copies; ++copy)
+    {
+      for (const auto &name : baseNames)
+      {
+        names.push_back(copy == 0 ? name : name + " #" + std::to_string(copy));
+      }
+    }
+
+    size_t queryCount = roundUp(std::max<size_t>(occurrences.size() * copies, 1024));
+    std::vector<std::uint32_t> queries(queryCount);
+    for (auto &query : queries)
+    {
+      size_t copy = rng() % copies;
+      query = static_cast<std::uint32_t>(copy * baseNames.size() + occurrences[rng() % occurrences.size()]);
+    }
+    std::vector<std::string> misses(1024);
+    for (size_t i = 0; i < misses.size(); ++i)
+    {
+      misses[i] = baseNames[rng() % baseNames.size()] + " (missing " + std::to_string(i) + ")";
+    }
+    runNames(names, queries, misses);
+  }
+  return 0;
+}
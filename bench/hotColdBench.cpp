@@ -0,0 +1,285 @@
+/**
+ * @file hotColdBench.cpp
+ * @brief Cache behaviour of availability scans over different recipe layouts.
+ *
+ * A synthetic catalog (realistic name and instruction lengths, ingredients
+ * drawn from a skewed distribution, a pantry holding the common staples) is
+ * scanned the way showAvailableRecipes() scans it, in three layouts:
+ *
+ * - std::vector<Recipe>: each recipe holds its strings and a heap-allocated
+ *   ingredient vector, so every recipe scanned costs a pointer chase;
+ * - RecipeStore, reading every recipe's ingredient records;
+ * - RecipeStore, testing the signature column first and reading ingredient
+ *   records only for recipes it cannot rule out.
+ *
+ * Where the kernel allows it (perf_event_open, see perf_event_paranoid),
+ * hardware counters report cache misses per recipe scanned; otherwise only
+ * the time per recipe is shown.
+ *
+ * Usage: hotColdBench [recipes]
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory_resource>
+#include <random>
+#include <string>
+#include <vector>
+#include "ingredientDictionary.hpp"
+#include "recipeStore.hpp"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+  constexpr std::uint32_t distinctIngredients = 5000;
+  constexpr std::uint32_t pantrySize = 40;
+  constexpr size_t runsPerLayout = 5;
+
+  /**
+   * @brief One hardware counter of the calling thread, or nothing if unavailable.
+   */
+  class PerfCounter
+  {
+  public:
+    PerfCounter(std::uint32_t type, std::uint64_t config)
+    {
+#ifdef __linux__
+      perf_event_attr attr;
+      std::memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = type;
+      attr.config = config;
+      attr.disabled = 1;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#else
+      (void)type;
+      (void)config;
+#endif
+    }
+    PerfCounter(const PerfCounter &) = delete;
+    PerfCounter &operator=(const PerfCounter &) = delete;
+    ~PerfCounter()
+    {
+#ifdef __linux__
+      if (fd >= 0)
+        close(fd);
+#endif
+    }
+
+    bool available() const { return fd >= 0; }
+
+    void start()
+    {
+#ifdef __linux__
+      if (fd >= 0)
+      {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+      }
+#endif
+    }
+
+    std::uint64_t stop()
+    {
+      std::uint64_t value = 0;
+#ifdef __linux__
+      if (fd >= 0)
+      {
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(fd, &value, sizeof(value)) != static_cast<ssize_t>(sizeof(value)))
+          value = 0;
+      }
+#endif
+      return value;
+    }
+
+  private:
+    int fd = -1;
+  };
+
+  struct Counters
+  {
+#ifdef __linux__
+    PerfCounter llcMisses{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES};
+    PerfCounter l1dMisses{PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)};
+#else
+    PerfCounter llcMisses{0, 0};
+    PerfCounter l1dMisses{0, 0};
+#endif
+  };
+
+  /**
+   * @brief Times a scan, keeping the fastest of several runs and its counter values.
+   */
+  template <typename F>
+  void measure(const char *label, size_t recipes, Counters &counters, F &&scan)
+  {
+    double best = 0;
+    std::uint64_t llc = 0;
+    std::uint64_t l1d = 0;
+    size_t found = 0;
+    for (size_t run = 0; run < runsPerLayout; ++run)
+    {
+      counters.llcMisses.start();
+      counters.l1dMisses.start();
+      auto start = std::chrono::steady_clock::now();
+      found = scan();
+      std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+      std::uint64_t runLlc = counters.llcMisses.stop();
+      std::uint64_t runL1d = counters.l1dMisses.stop();
+      if (run == 0 || elapsed.count() < best)
+      {
+        best = elapsed.count();
+        llc = runLlc;
+        l1d = runL1d;
+      }
+    }
+
+    double perRecipe = static_cast<double>(recipes);
+    std::cout << "  " << std::left << std::setw(34) << label << std::right << std::fixed << std::setprecision(2)
+              << std::setw(8) << best / perRecipe << " ns";
+    if (counters.l1dMisses.available())
+      std::cout << std::setw(10) << static_cast<double>(l1d) / perRecipe << " L1D";
+    if (counters.llcMisses.available())
+      std::cout << std::setw(10) << static_cast<double>(llc) / perRecipe << " LLC";
+    std::cout << "   per recipe (" << found << " available)" << std::endl;
+  }
+
+  std::string text(std::mt19937 &rng, size_t length)
+  {
+    static const char *words[] = {"mix ", "the ", "until ", "golden ", "add ", "salt ", "stir ", "and ", "bake ", "serve "};
+    std::string out;
+    while (out.size() < length)
+      out += words[rng() % 10];
+    return out;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  size_t count = argc > 1 ? std::stoul(argv[1]) : 200000;
+  if (count == 0)
+  {
+    std::cerr << "Usage: hotColdBench [recipes]" << std::endl;
+    return 1;
+  }
+
+  // Ids 0..distinctIngredients-1, interned in order; low ids are the staples.
+  std::vector<Ingredient> catalogIngredients;
+  for (std::uint32_t i = 0; i < distinctIngredients; ++i)
+  {
+    catalogIngredients.emplace_back("ingredient " + std::to_string(i), 100, Unit::Grams);
+  }
+
+  std::mt19937 rng(42);
+  std::vector<Recipe> recipes;
+  recipes.reserve(count);
+  for (size_t r = 0; r < count; ++r)
+  {
+    std::vector<Ingredient> needed;
+    size_t ingredientCount = 4 + rng() % 9;
+    for (size_t i = 0; i < ingredientCount; ++i)
+    {
+      // Skewed draw: half the ingredients come from the 64 most common ones.
+      std::uint32_t id = (rng() % 2) ? rng() % 64 : rng() % distinctIngredients;
+      needed.push_back(catalogIngredients[id]);
+    }
+    recipes.emplace_back(static_cast<int>(r), text(rng, 16 + rng() % 24), needed, text(rng, 200 + rng() % 400));
+  }
+
+  RecipeStore store(std::pmr::new_delete_resource());
+  for (const Recipe &recipe : recipes)
+  {
+    store.append(recipe);
+  }
+
+  std::vector<char> inPantry(IngredientDictionary::shared().size(), 0);
+  std::uint64_t pantrySignature = 0;
+  for (std::uint32_t id = 0; id < pantrySize; ++id)
+  {
+    inPantry[id] = 1;
+    pantrySignature |= signatureBit(id);
+  }
+
+  std::cout << count << " recipes, " << distinctIngredients << " distinct ingredients, "
+            << pantrySize << " in the pantry" << std::endl;
+  Counters counters;
+  if (!counters.llcMisses.available() && !counters.l1dMisses.available())
+    std::cout << "  (hardware counters unavailable, timing only)" << std::endl;
+
+  measure("std::vector<Recipe>", count, counters, [&]()
+          {
+            size_t found = 0;
+            for (const Recipe &recipe : recipes)
+            {
+              bool possible = true;
+              for (const Ingredient &ingredient : recipe.ingredients)
+              {
+                if (!inPantry[ingredient.nameId])
+                {
+                  possible = false;
+                  break;
+                }
+              }
+              found += possible;
+            }
+            return found; });
+  measure("RecipeStore, ingredient records", count, counters, [&]()
+          {
+            size_t found = 0;
+            for (std::uint32_t slot = 0; slot < store.size();)
+            {
+              const RecipeStore::Columns &page = store.pageOf(slot);
+              for (std::uint32_t end = slot + page.size; slot < end; ++slot)
+              {
+                bool possible = true;
+                for (const Ingredient &ingredient : RecipeView(page, slot).ingredients())
+                {
+                  if (!inPantry[ingredient.nameId])
+                  {
+                    possible = false;
+                    break;
+                  }
+                }
+                found += possible;
+              }
+            }
+            return found; });
+  measure("RecipeStore, signature first", count, counters, [&]()
+          {
+            size_t found = 0;
+            for (std::uint32_t slot = 0; slot < store.size();)
+            {
+              const RecipeStore::Columns &page = store.pageOf(slot);
+              for (std::uint32_t end = slot + page.size; slot < end; ++slot)
+              {
+                RecipeView recipe(page, slot);
+                if (recipe.signature() & ~pantrySignature)
+                  continue;
+                bool possible = true;
+                for (const Ingredient &ingredient : recipe.ingredients())
+                {
+                  if (!inPantry[ingredient.nameId])
+                  {
+                    possible = false;
+                    break;
+                  }
+                }
+                found += possible;
+              }
+            }
+            return found; });
+  return 0;
+}
@@ -0,0 +1,172 @@
+/**
+ * @file hugePageBench.cpp
+ * @brief Availability queries on a large synthetic catalog, with and without huge pages.
+ *
+ * The catalog is laid out like RecipeStore (offset and count columns over a
+ * flat array of packed Ingredient records) and allocated through a monotonic
+ * arena, as in RecipeManager. The query is the one behind "Show available
+ * recipes": mark the pantry in a table indexed by ingredient id, then check
+ * every required ingredient of every recipe against it. Lookups into the
+ * table are random, and so are the recipe visits of the second query, so
+ * with 4 KiB pages most of them miss the TLB.
+ *
+ * Each query runs once with the arena on the heap and once on a
+ * HugePageResource, which reports whether it got reserved or transparent
+ * huge pages. Without either, both runs use normal pages and should match.
+ *
+ * Usage: hugePageBench [recipes] [distinct ingredients]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory_resource>
+#include <random>
+#include <string>
+#include <vector>
+#include "hugePageResource.hpp"
+#include "ingredient.hpp"
+
+namespace
+{
+  constexpr size_t runsPerQuery = 5;
+  constexpr size_t randomVisits = 1 << 20;
+
+  struct Catalog
+  {
+    std::pmr::vector<std::uint32_t> ingredientOffsets;
+    std::pmr::vector<std::uint32_t> ingredientCounts;
+    std::pmr::vector<Ingredient> ingredients;
+    std::pmr::vector<char> inPantry;
+
+    explicit Catalog(std::pmr::memory_resource *resource)
+        : ingredientOffsets(resource), ingredientCounts(resource), ingredients(resource), inPantry(resource)
+    {
+    }
+  };
+
+  /**
+   * @brief Fills a catalog; the same seed gives the same catalog on every resource.
+   */
+  void build(Catalog &catalog, size_t recipes, std::uint32_t names)
+  {
+    std::mt19937 rng(42);
+    catalog.ingredientOffsets.reserve(recipes);
+    catalog.ingredientCounts.reserve(recipes);
+    catalog.ingredients.reserve(recipes * 8);
+    for (size_t r = 0; r < recipes; ++r)
+    {
+      std::uint32_t count = 4 + rng() % 9;
+      catalog.ingredientOffsets.push_back(static_cast<std::uint32_t>(catalog.ingredients.size()));
+      catalog.ingredientCounts.push_back(count);
+      for (std::uint32_t i = 0; i < count; ++i)
+      {
+        Ingredient ingredient;
+        ingredient.nameId = rng() % names;
+        ingredient.quantity = 100;
+        ingredient.unit = Unit::Grams;
+        catalog.ingredients.push_back(ingredient);
+      }
+    }
+    // Most ingredients are in stock, so most recipes are checked in full.
+    catalog.inPantry.assign(names, 0);
+    for (auto &present : catalog.inPantry)
+    {
+      present = rng() % 64 != 0;
+    }
+  }
+
+  bool available(const Catalog &catalog, std::uint32_t slot)
+  {
+    const Ingredient *first = catalog.ingredients.data() + catalog.ingredientOffsets[slot];
+    const Ingredient *last = first + catalog.ingredientCounts[slot];
+    for (const Ingredient *ingredient = first; ingredient != last; ++ingredient)
+    {
+      if (!catalog.inPantry[ingredient->nameId])
+        return false;
+    }
+    return true;
+  }
+
+  /**
+   * @brief Runs a query several times and returns the best time in milliseconds.
+   */
+  template <typename F>
+  double measure(F &&query, size_t &sink)
+  {
+    double best = 0;
+    for (size_t run = 0; run < runsPerQuery; ++run)
+    {
+      auto start = std::chrono::steady_clock::now();
+      sink += query();
+      std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+      best = run == 0 ? elapsed.count() : std::min(best, elapsed.count());
+    }
+    return best;
+  }
+
+  /**
+   * @brief Builds a catalog on a resource and times both queries.
+   *
+   * @param [in] hugePages The resource, if it is a HugePageResource, to report its backing
+   */
+  void run(const char *label, std::pmr::memory_resource *upstream, size_t recipes, std::uint32_t names,
+           const std::vector<std::uint32_t> &visits, const HugePageResource *hugePages = nullptr)
+  {
+    std::pmr::monotonic_buffer_resource arena(64 * 1024, upstream);
+    Catalog catalog(&arena);
+    build(catalog, recipes, names);
+    if (hugePages != nullptr)
+    {
+      HugePageStats stats = hugePages->stats();
+      std::cout << "  backing: " << stats.explicitBytes << " bytes reserved (MAP_HUGETLB), "
+                << stats.transparentBytes << " bytes transparent (MADV_HUGEPAGE), " << stats.upstreamBytes
+                << " bytes on normal pages" << std::endl;
+    }
+
+    size_t sink = 0;
+    double scan = measure([&]()
+                          {
+                            size_t count = 0;
+                            for (std::uint32_t slot = 0; slot < recipes; ++slot)
+                              count += available(catalog, slot);
+                            return count; }, sink);
+    double random = measure([&]()
+                            {
+                              size_t count = 0;
+                              for (std::uint32_t slot : visits)
+                                count += available(catalog, slot);
+                              return count; }, sink);
+    std::cout << "  " << std::left << std::setw(22) << label << std::right << std::fixed << std::setprecision(2)
+              << std::setw(10) << scan << " ms full scan" << std::setw(10) << random << " ms random visits"
+              << "  (checksum " << sink << ")" << std::endl;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  size_t recipes = argc > 1 ? std::stoul(argv[1]) : 2000000;
+  std::uint32_t names = argc > 2 ? static_cast<std::uint32_t>(std::stoul(argv[2])) : 16000000;
+  if (recipes == 0 || names == 0)
+  {
+    std::cerr << "Usage: hugePageBench [recipes] [distinct ingredients]" << std::endl;
+    return 1;
+  }
+
+  std::mt19937 rng(7);
+  std::vector<std::uint32_t> visits(randomVisits);
+  for (auto &slot : visits)
+  {
+    slot = static_cast<std::uint32_t>(rng() % recipes);
+  }
+
+  std::cout << recipes << " recipes, ~" << recipes * 8 << " ingredient entries, " << names
+            << " distinct ingredients, " << visits.size() << " random visits" << std::endl;
+  run("4 KiB pages (heap)", std::pmr::new_delete_resource(), recipes, names, visits);
+
+  HugePageResource hugePages;
+  run("2 MiB pages", &hugePages, recipes, names, visits, &hugePages);
+  return 0;
+}
@@ -0,0 +1,158 @@
+/**
+ * @file mpscQueueBench.cpp
+ * @brief Throughput of MpscQueue against a mutex-protected deque under contention.
+ *
+ * P producer threads each push a fixed number of (producer, sequence)
+ * records while one consumer pops them, as the pantry update applier does.
+ * Reported per producer count: millions of records per second through each
+ * queue, and the slowest single push seen by a producer. The consumer checks
+ * that every record arrives once and in order per producer.
+ *
+ * Usage: mpscQueueBench [records per producer]
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "mpscQueue.hpp"
+
+namespace
+{
+  using Clock = std::chrono::steady_clock;
+
+  struct Record
+  {
+    std::uint32_t producer = 0;
+    std::uint64_t sequence = 0;
+  };
+
+  /**
+   * @brief The queue a lock-based applier would use: one mutex around a deque.
+   */
+  class LockedQueue
+  {
+  public:
+    void push(Record value)
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      items.push_back(value);
+    }
+
+    bool pop(Record &out)
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (items.empty())
+      {
+        return false;
+      }
+      out = items.front();
+      items.pop_front();
+      return true;
+    }
+
+  private:
+    std::mutex mutex;
+    std::deque<Record> items;
+  };
+
+  struct Result
+  {
+    double millionsPerSecond = 0;
+    double slowestPushMicroseconds = 0;
+    bool ordered = true;
+  };
+
+  template <typename Queue>
+  Result run(size_t producers, std::uint64_t perProducer)
+  {
+    Queue queue;
+    std::atomic<size_t> ready{0};
+    std::atomic<bool> go{false};
+    std::vector<double> slowest(producers, 0);
+    std::vector<std::thread> threads;
+    for (size_t p = 0; p < producers; ++p)
+    {
+      threads.emplace_back(
+          [&, p]()
+          {
+            ready.fetch_add(1);
+            while (!go.load())
+            {
+              std::this_thread::yield();
+            }
+            Clock::duration worst{};
+            for (std::uint64_t i = 0; i < perProducer; ++i)
+            {
+              auto start = Clock::now();
+              queue.push(Record{static_cast<std::uint32_t>(p), i});
+              worst = std::max(worst, Clock::now() - start);
+            }
+            slowest[p] = std::chrono::duration<double, std::micro>(worst).count();
+          });
+    }
+    while (ready.load() < producers)
+    {
+      std::this_thread::yield();
+    }
+
+    Result result;
+    std::vector<std::uint64_t> next(producers, 0);
+    std::uint64_t total = perProducer * producers;
+    std::uint64_t received = 0;
+    Record record;
+    auto start = Clock::now();
+    go.store(true);
+    while (received < total)
+    {
+      if (!queue.pop(record))
+      {
+        std::this_thread::yield();
+        continue;
+      }
+      result.ordered = result.ordered && record.sequence == next[record.producer];
+      next[record.producer] = record.sequence + 1;
+      ++received;
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    for (auto &thread : threads)
+    {
+      thread.join();
+    }
+    result.millionsPerSecond = static_cast<double>(total) / seconds / 1e6;
+    result.slowestPushMicroseconds = *std::max_element(slowest.begin(), slowest.end());
+    return result;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  std::uint64_t perProducer = argc > 1 ? std::stoull(argv[1]) : 1000000;
+  std::cout << std::fixed << std::setprecision(2);
+  std::cout << perProducer << " records per producer, "
+            << std::max(1u, std::thread::hardware_concurrency()) << " hardware threads\n"
+            << std::endl;
+  std::cout << "producers   MpscQueue Mops/s (slowest push)   mutex+deque Mops/s (slowest push)" << std::endl;
+  for (size_t producers : {1, 2, 4, 8})
+  {
+    Result lockFree = run<MpscQueue<Record>>(producers, perProducer);
+    Result locked = run<LockedQueue>(producers, perProducer);
+    if (!lockFree.ordered || !locked.ordered)
+    {
+      std::cerr << "Records arrived out of order with " << producers << " producers." << std::endl;
+      return 1;
+    }
+    std::cout << std::setw(9) << producers << "   " << std::setw(16) << lockFree.millionsPerSecond << " ("
+              << std::setw(9) << lockFree.slowestPushMicroseconds << " us)   " << std::setw(18)
+              << locked.millionsPerSecond << " (" << std::setw(9) << locked.slowestPushMicroseconds << " us)"
+              << std::endl;
+  }
+  return 0;
+}
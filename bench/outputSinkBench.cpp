@@ -0,0 +1,121 @@
+/**
+ * @file outputSinkBench.cpp
+ * @brief Throughput of a catalog listing through std::endl, '\n' and OutputSink.
+ *
+ * Writes the "id. name" lines of a synthetic catalog to a file, as option 1
+ * of the menu does, three ways: a std::ofstream ended with std::endl (one
+ * flush, so one write call, per line), the same stream ended with '\n', and
+ * an OutputSink over the stream. Reported per variant: milliseconds, lines
+ * per second and megabytes per second. Writing to /dev/null measures the
+ * formatting and the system calls without the disk.
+ *
+ * Usage: outputSinkBench [lines] [output file]
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "outputSink.hpp"
+
+namespace
+{
+  using Clock = std::chrono::steady_clock;
+
+  struct Result
+  {
+    double milliseconds = 0;
+    std::uint64_t bytes = 0;
+  };
+
+  /**
+   * @brief Runs one variant on a fresh stream and times it, closing the file included.
+   */
+  Result run(const std::string &path, const std::function<void(std::ofstream &)> &write)
+  {
+    auto start = Clock::now();
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    write(file);
+    file.flush();
+    Result result;
+    result.bytes = static_cast<std::uint64_t>(file.tellp());
+    file.close();
+    result.milliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    return result;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  size_t lines = argc > 1 ? std::stoull(argv[1]) : 1000000;
+  std::string path = argc > 2 ? argv[2] : "/dev/null";
+
+  std::vector<std::string> names;
+  for (const char *dish : {"Tomato soup", "Garlic bread with herbs", "Chicken curry", "Lemon tart",
+                           "Mushroom risotto", "Spicy bean chili", "Pancakes", "Roasted vegetables"})
+  {
+    names.emplace_back(dish);
+  }
+
+  std::uint64_t bytes = 0;
+  for (size_t i = 0; i < lines; ++i)
+  {
+    bytes += std::to_string(i + 1).size() + 2 + names[i % names.size()].size() + 1;
+  }
+
+  std::vector<std::pair<const char *, std::function<void(std::ofstream &)>>> variants;
+  variants.emplace_back(
+      "ofstream + std::endl",
+      [&](std::ofstream &file)
+      {
+        for (size_t i = 0; i < lines; ++i)
+        {
+          file << i + 1 << ". " << names[i % names.size()] << std::endl;
+        }
+      });
+  variants.emplace_back(
+      "ofstream + '\\n'",
+      [&](std::ofstream &file)
+      {
+        for (size_t i = 0; i < lines; ++i)
+        {
+          file << i + 1 << ". " << names[i % names.size()] << '\n';
+        }
+      });
+  variants.emplace_back(
+      "OutputSink",
+      [&](std::ofstream &file)
+      {
+        OutputSink out(file);
+        for (size_t i = 0; i < lines; ++i)
+        {
+          out << i + 1 << ". " << names[i % names.size()] << '\n';
+        }
+        out.flush();
+      });
+
+  std::cout << std::fixed << std::setprecision(1);
+  std::cout << lines << " lines to " << path << "\n"
+            << std::endl;
+  std::cout << "variant                       ms      Mlines/s      MB/s" << std::endl;
+  for (const auto &variant : variants)
+  {
+    Result result = run(path, variant.second);
+    // /dev/null does not keep a file position, so only real files are checked.
+    if (path != "/dev/null" && result.bytes != bytes)
+    {
+      std::cerr << variant.first << " wrote " << result.bytes << " bytes instead of " << bytes << "." << std::endl;
+      return 1;
+    }
+    double seconds = result.milliseconds / 1e3;
+    std::cout << std::left << std::setw(22) << variant.first << std::right << std::setw(10) << result.milliseconds
+              << std::setw(14) << std::setprecision(2) << static_cast<double>(lines) / seconds / 1e6
+              << std::setw(10) << std::setprecision(1) << static_cast<double>(bytes) / seconds / 1e6
+              << std::endl;
+  }
+  return 0;
+}
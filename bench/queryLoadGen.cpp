@@ -0,0 +1,356 @@
+/**
+ * @file queryLoadGen.cpp
+ * @brief Load generator for the query server (main --serve).
+ *
+ * Opens several connections to the server's Unix domain socket; each one is
+ * driven by its own thread, which keeps a fixed number of requests in flight
+ * (pipelining) and sends the next request as soon as a reply comes back.
+ * Every request is tagged with a slot, which holds its send time, so
+ * replies may come back in any order. At the end the throughput and the
+ * p50, p99 and p999 latencies over all connections are reported.
+ *
+ * The recipe names and ids used for search and detail requests are fetched
+ * from the server with one empty search first.
+ *
+ * Usage: queryLoadGen <socket> [connections] [pipeline depth] [seconds] [available|search|detail|mix]
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "queryProtocol.hpp"
+
+#ifdef __linux__
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+  using Clock = std::chrono::steady_clock;
+
+  struct Recipe
+  {
+    std::int32_t id;
+    std::string name;
+  };
+
+  struct Result
+  {
+    std::vector<std::uint64_t> latencies; ///< Nanoseconds per request
+    size_t errors = 0;
+    size_t replyBytes = 0;
+    bool failed = false;
+  };
+
+  int connectTo(const std::string &path)
+  {
+#ifdef __linux__
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path))
+      return -1;
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd >= 0 && ::connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0)
+    {
+      ::close(fd);
+      fd = -1;
+    }
+    return fd;
+#else
+    (void)path;
+    return -1;
+#endif
+  }
+
+  bool sendAll(int fd, const std::string &bytes)
+  {
+#ifdef __linux__
+    size_t sent = 0;
+    while (sent < bytes.size())
+    {
+      ssize_t n = ::send(fd, bytes.data() + sent, bytes.size() - sent, MSG_NOSIGNAL);
+      if (n < 0 && errno == EINTR)
+        continue;
+      if (n <= 0)
+        return false;
+      sent += static_cast<size_t>(n);
+    }
+    return true;
+#else
+    (void)fd;
+    (void)bytes;
+    return false;
+#endif
+  }
+
+  /**
+   * @brief Reads more bytes into a buffer; returns false on error or end of stream.
+   */
+  bool receive(int fd, std::string &buffer)
+  {
+#ifdef __linux__
+    char chunk[64 * 1024];
+    while (true)
+    {
+      ssize_t n = ::read(fd, chunk, sizeof(chunk));
+      if (n < 0 && errno == EINTR)
+        continue;
+      if (n <= 0)
+        return false;
+      buffer.append(chunk, static_cast<size_t>(n));
+      return true;
+    }
+#else
+    (void)fd;
+    (void)buffer;
+    return false;
+#endif
+  }
+
+  /**
+   * @brief Cuts the complete frames at the start of a buffer.
+   *
+   * @return Offsets of the frames found; consumed is set past the last one
+   */
+  std::vector<size_t> frames(const std::string &buffer, size_t &consumed)
+  {
+    std::vector<size_t> found;
+    consumed = 0;
+    while (buffer.size() - consumed >= 4)
+    {
+      std::uint32_t size = QueryProtocol::getU32(buffer.data() + consumed);
+      if (buffer.size() - consumed < 4 + size)
+        break;
+      found.push_back(consumed);
+      consumed += 4 + size;
+    }
+    return found;
+  }
+
+  void appendRequest(std::string &out, std::uint32_t tag, const std::string &mode, std::mt19937 &rng,
+                     const std::vector<Recipe> &recipes)
+  {
+    using namespace QueryProtocol;
+    std::string op = mode;
+    if (op == "mix")
+    {
+      static const char *ops[] = {"available", "search", "detail"};
+      op = ops[rng() % 3];
+    }
+    if (op == "available" || recipes.empty())
+    {
+      endFrame(out, beginFrame(out, tag, static_cast<std::uint8_t>(Op::Available)));
+    }
+    else if (op == "search")
+    {
+      // Search for the start of a random name, like a user typing it.
+      size_t start = beginFrame(out, tag, static_cast<std::uint8_t>(Op::Search));
+      out += recipes[rng() % recipes.size()].name.substr(0, 4);
+      endFrame(out, start);
+    }
+    else
+    {
+      size_t start = beginFrame(out, tag, static_cast<std::uint8_t>(Op::Detail));
+      putI32(out, recipes[rng() % recipes.size()].id);
+      endFrame(out, start);
+    }
+  }
+
+  /**
+   * @brief Drives one connection for the given time, keeping depth requests in flight.
+   */
+  void drive(const std::string &path, size_t depth, Clock::time_point end, const std::string &mode,
+             const std::vector<Recipe> &recipes, unsigned seed, Result &result)
+  {
+    int fd = connectTo(path);
+    if (fd < 0)
+    {
+      result.failed = true;
+      return;
+    }
+    std::mt19937 rng(seed);
+    std::vector<Clock::time_point> sentAt(depth);
+    std::string outgoing;
+    for (std::uint32_t tag = 0; tag < depth; ++tag)
+    {
+      appendRequest(outgoing, tag, mode, rng, recipes);
+      sentAt[tag] = Clock::now();
+    }
+    size_t inFlight = depth;
+    std::string incoming;
+    bool ok = sendAll(fd, outgoing);
+    while (ok && inFlight > 0)
+    {
+      if (!receive(fd, incoming))
+      {
+        ok = false;
+        break;
+      }
+      size_t consumed;
+      std::vector<size_t> replies = frames(incoming, consumed);
+      Clock::time_point now = Clock::now();
+      bool more = now < end;
+      outgoing.clear();
+      for (size_t offset : replies)
+      {
+        std::uint32_t size = QueryProtocol::getU32(incoming.data() + offset);
+        std::uint32_t tag = QueryProtocol::getU32(incoming.data() + offset + 4);
+        if (tag >= depth)
+        {
+          ok = false;
+          break;
+        }
+        result.latencies.push_back(static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(now - sentAt[tag]).count()));
+        result.errors += incoming[offset + 8] != static_cast<char>(QueryProtocol::Status::Ok);
+        result.replyBytes += 4 + size;
+        if (more)
+        {
+          appendRequest(outgoing, tag, mode, rng, recipes);
+          sentAt[tag] = now;
+        }
+        else
+        {
+          --inFlight;
+        }
+      }
+      incoming.erase(0, consumed);
+      if (ok && !outgoing.empty())
+      {
+        ok = sendAll(fd, outgoing);
+      }
+    }
+    result.failed = !ok;
+#ifdef __linux__
+    ::close(fd);
+#endif
+  }
+
+  /**
+   * @brief Fetches every recipe id and name with one empty search.
+   */
+  bool fetchRecipes(const std::string &path, std::vector<Recipe> &recipes)
+  {
+    int fd = connectTo(path);
+    if (fd < 0)
+      return false;
+    std::string request;
+    QueryProtocol::endFrame(request, QueryProtocol::beginFrame(request, 0, static_cast<std::uint8_t>(QueryProtocol::Op::Search)));
+    std::string reply;
+    size_t consumed = 0;
+    bool ok = sendAll(fd, request);
+    while (ok && frames(reply, consumed).empty())
+    {
+      ok = receive(fd, reply);
+    }
+#ifdef __linux__
+    ::close(fd);
+#endif
+    if (!ok || reply[8] != static_cast<char>(QueryProtocol::Status::Ok))
+      return false;
+
+    const char *p = reply.data() + QueryProtocol::headerBytes;
+    std::uint32_t count = QueryProtocol::getU32(p);
+    p += 4;
+    for (std::uint32_t i = 0; i < count; ++i)
+    {
+      std::int32_t id = QueryProtocol::getI32(p);
+      std::uint16_t length = QueryProtocol::getU16(p + 4);
+      recipes.push_back({id, std::string(p + 6, length)});
+      p += 6 + length;
+    }
+    return true;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  if (argc < 2)
+  {
+    std::cerr << "Usage: queryLoadGen <socket> [connections] [pipeline depth] [seconds] [available|search|detail|mix]" << std::endl;
+    return 1;
+  }
+  std::string path = argv[1];
+  size_t connections = argc > 2 ? std::stoul(argv[2]) : 4;
+  size_t depth = argc > 3 ? std::stoul(argv[3]) : 16;
+  double seconds = argc > 4 ? std::stod(argv[4]) : 5.0;
+  std::string mode = argc > 5 ? argv[5] : "mix";
+  if (connections == 0 || depth == 0 || seconds <= 0 ||
+      (mode != "available" && mode != "search" && mode != "detail" && mode != "mix"))
+  {
+    std::cerr << "Usage: queryLoadGen <socket> [connections] [pipeline depth] [seconds] [available|search|detail|mix]" << std::endl;
+    return 1;
+  }
+
+  std::vector<Recipe> recipes;
+  if (!fetchRecipes(path, recipes))
+  {
+    std::cerr << "Cannot query the server on " << path << "." << std::endl;
+    return 1;
+  }
+
+  std::vector<Result> results(connections);
+  std::vector<std::thread> threads;
+  Clock::time_point start = Clock::now();
+  Clock::time_point end = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+  for (size_t i = 0; i < connections; ++i)
+  {
+    threads.emplace_back(drive, std::cref(path), depth, end, std::cref(mode), std::cref(recipes),
+                         static_cast<unsigned>(i + 1), std::ref(results[i]));
+  }
+  for (auto &thread : threads)
+  {
+    thread.join();
+  }
+  double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+  std::vector<std::uint64_t> latencies;
+  size_t errors = 0;
+  size_t replyBytes = 0;
+  size_t failed = 0;
+  for (auto &result : results)
+  {
+    latencies.insert(latencies.end(), result.latencies.begin(), result.latencies.end());
+    errors += result.errors;
+    replyBytes += result.replyBytes;
+    failed += result.failed;
+  }
+  if (latencies.empty())
+  {
+    std::cerr << "No replies received." << std::endl;
+    return 1;
+  }
+  std::sort(latencies.begin(), latencies.end());
+  auto percentile = [&](double p)
+  {
+    size_t index = std::min(latencies.size() - 1, static_cast<size_t>(p * static_cast<double>(latencies.size())));
+    return static_cast<double>(latencies[index]) / 1000.0;
+  };
+
+  std::cout << recipes.size() << " recipes, " << connections << " connections x " << depth << " in flight, "
+            << mode << " requests" << std::endl;
+  std::cout << std::fixed << std::setprecision(1);
+  std::cout << "  " << latencies.size() << " replies in " << elapsed << " s: "
+            << static_cast<double>(latencies.size()) / elapsed << " QPS, "
+            << static_cast<double>(replyBytes) / elapsed / (1024 * 1024) << " MiB/s" << std::endl;
+  std::cout << "  latency p50 " << percentile(0.50) << " us, p99 " << percentile(0.99) << " us, p999 "
+            << percentile(0.999) << " us, max " << static_cast<double>(latencies.back()) / 1000.0 << " us" << std::endl;
+  if (errors > 0 || failed > 0)
+  {
+    std::cout << "  " << errors << " error replies, " << failed << " connections failed" << std::endl;
+  }
+  return failed > 0 ? 1 : 0;
+}
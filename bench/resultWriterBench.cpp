@@ -0,0 +1,181 @@
+/**
+ * @file resultWriterBench.cpp
+ * @brief Throughput of ResultWriter against building nlohmann::json documents.
+ *
+ * A synthetic catalog is serialized twice per variant: as one recipe list
+ * holding every recipe (an "available" reply on a well-stocked pantry) and
+ * as one detail reply per recipe (a stream of "recipe <id>" queries). The
+ * ResultWriter variants write text, JSON and CSV straight into an
+ * OutputSink; the nlohmann variant builds the same JSON objects and dumps
+ * them, as a DOM-based serializer would. Output goes to a stream buffer that
+ * only counts bytes, so the numbers are the cost of serializing. Reported
+ * per variant: milliseconds, recipes per second and megabytes per second.
+ *
+ * Usage: resultWriterBench [recipes]
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory_resource>
+#include <random>
+#include <string>
+#include <vector>
+#include "../imports/nlohmann/json.hpp"
+#include "recipeStore.hpp"
+#include "resultWriter.hpp"
+
+namespace
+{
+  using Clock = std::chrono::steady_clock;
+
+  std::string text(std::mt19937 &rng, size_t length)
+  {
+    // Commas and quotes make CSV and JSON escape some fields.
+    static const char *words[] = {"mix ", "the ", "until ", "golden ", "add ",
+                                  "salt, ", "stir ", "\"and\" ", "bake ", "serve "};
+    std::string out;
+    while (out.size() < length)
+      out += words[rng() % 10];
+    return out;
+  }
+
+  /**
+   * @brief Counts the bytes written to it and drops them.
+   */
+  class CountingBuffer : public std::streambuf
+  {
+  public:
+    std::uint64_t bytes = 0;
+
+  protected:
+    std::streamsize xsputn(const char *, std::streamsize count) override
+    {
+      bytes += static_cast<std::uint64_t>(count);
+      return count;
+    }
+
+    int_type overflow(int_type c) override
+    {
+      ++bytes;
+      return traits_type::not_eof(c);
+    }
+  };
+
+  nlohmann::json recipeJson(RecipeView recipe, const TextCodec &codec)
+  {
+    nlohmann::json ingredients = nlohmann::json::array();
+    for (const Ingredient &item : recipe.ingredients())
+    {
+      ingredients.push_back({{"name", item.name()},
+                             {"quantity", static_cast<double>(item.quantity) / Ingredient::quantityScale},
+                             {"unit", unitName(item.unit)}});
+    }
+    return {{"id", recipe.id()},
+            {"name", recipe.name()},
+            {"ingredients", ingredients},
+            {"instructions", codec.decode(recipe.instructions())}};
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  size_t count = argc > 1 ? std::stoul(argv[1]) : 100000;
+
+  std::vector<Ingredient> catalogIngredients;
+  for (std::uint32_t i = 0; i < 500; ++i)
+  {
+    catalogIngredients.emplace_back("ingredient " + std::to_string(i), 100, Unit::Grams);
+  }
+  std::mt19937 rng(42);
+  RecipeStore store(std::pmr::new_delete_resource());
+  for (size_t r = 0; r < count; ++r)
+  {
+    std::vector<Ingredient> needed;
+    size_t ingredientCount = 4 + rng() % 9;
+    for (size_t i = 0; i < ingredientCount; ++i)
+    {
+      Ingredient item = catalogIngredients[rng() % catalogIngredients.size()];
+      item.quantity = static_cast<std::int32_t>(rng() % 100000);
+      needed.push_back(item);
+    }
+    store.append(Recipe(static_cast<int>(r), text(rng, 16 + rng() % 24), needed, text(rng, 200 + rng() % 400)));
+  }
+  TextCodec codec;
+  std::vector<std::uint32_t> slots(store.size());
+  for (std::uint32_t slot = 0; slot < store.size(); ++slot)
+  {
+    slots[slot] = slot;
+  }
+
+  auto writerList = [&](ResultFormat format)
+  {
+    return [&, format](std::ostream &stream)
+    {
+      OutputSink out(stream);
+      ResultWriter(out, format).recipes(store, slots);
+    };
+  };
+  auto writerDetails = [&](ResultFormat format)
+  {
+    return [&, format](std::ostream &stream)
+    {
+      OutputSink out(stream);
+      ResultWriter writer(out, format);
+      for (std::uint32_t slot : slots)
+      {
+        writer.recipe(store.view(slot), codec);
+      }
+    };
+  };
+
+  std::vector<std::pair<const char *, std::function<void(std::ostream &)>>> variants;
+  variants.emplace_back("list     text", writerList(ResultFormat::Text));
+  variants.emplace_back("list     json", writerList(ResultFormat::Json));
+  variants.emplace_back("list     csv", writerList(ResultFormat::Csv));
+  variants.emplace_back(
+      "list     nlohmann",
+      [&](std::ostream &stream)
+      {
+        nlohmann::json recipes = nlohmann::json::array();
+        for (std::uint32_t slot : slots)
+        {
+          RecipeView recipe = store.view(slot);
+          recipes.push_back({{"id", recipe.id()}, {"name", recipe.name()}});
+        }
+        nlohmann::json reply = {{"ok", true}, {"count", slots.size()}, {"recipes", recipes}};
+        stream << reply.dump() << '\n';
+      });
+  variants.emplace_back("details  text", writerDetails(ResultFormat::Text));
+  variants.emplace_back("details  json", writerDetails(ResultFormat::Json));
+  variants.emplace_back("details  csv", writerDetails(ResultFormat::Csv));
+  variants.emplace_back(
+      "details  nlohmann",
+      [&](std::ostream &stream)
+      {
+        for (std::uint32_t slot : slots)
+        {
+          nlohmann::json reply = {{"ok", true}, {"recipe", recipeJson(store.view(slot), codec)}};
+          stream << reply.dump() << '\n';
+        }
+      });
+
+  std::cout << std::fixed;
+  std::cout << count << " recipes\n"
+            << std::endl;
+  std::cout << "variant                   ms   Krecipes/s      MB/s" << std::endl;
+  for (const auto &variant : variants)
+  {
+    CountingBuffer counter;
+    std::ostream stream(&counter);
+    auto start = Clock::now();
+    variant.second(stream);
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    std::cout << std::left << std::setw(18) << variant.first << std::right << std::setprecision(1)
+              << std::setw(10) << seconds * 1e3 << std::setw(13) << static_cast<double>(count) / seconds / 1e3
+              << std::setw(10) << static_cast<double>(counter.bytes) / seconds / 1e6 << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,194 @@
+/**
+ * @file schedulerBench.cpp
+ * @brief Scheduling overhead of the TaskScheduler on fine-grained tasks.
+ *
+ * - fork/join: a naive recursive Fibonacci where every call forks, the usual
+ *   worst case for a fork/join scheduler (a few nanoseconds of work per
+ *   task). Reported as time per forked task against the sequential recursion.
+ * - parallelFor: a cheap loop body over 2^24 indices with chunks of growing
+ *   grain, reported as nanoseconds per chunk and speedup over a plain loop.
+ * - parallelReduce: a sum over the same range.
+ * - round trip: a two-chunk parallelFor issued from a non-worker thread, as
+ *   a query does, against starting and joining a std::thread per call as
+ *   the manifest loader used to.
+ *
+ * Usage: schedulerBench [workers]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+#include "taskScheduler.hpp"
+
+namespace
+{
+  using Clock = std::chrono::steady_clock;
+
+  constexpr size_t loopSize = 1 << 24;
+  constexpr int fibArgument = 30;
+  constexpr size_t roundTrips = 20000;
+
+  double millisecondsSince(Clock::time_point start)
+  {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+  }
+
+  /**
+   * @brief Runs a measurement three times and returns the best milliseconds.
+   */
+  template <typename F>
+  double best(F &&run)
+  {
+    double fastest = 0;
+    for (int i = 0; i < 3; ++i)
+    {
+      auto start = Clock::now();
+      run();
+      double ms = millisecondsSince(start);
+      fastest = i == 0 ? ms : std::min(fastest, ms);
+    }
+    return fastest;
+  }
+
+  std::uint64_t fibSequential(int n)
+  {
+    return n < 2 ? static_cast<std::uint64_t>(n) : fibSequential(n - 1) + fibSequential(n - 2);
+  }
+
+  std::uint64_t fibForked(TaskScheduler &scheduler, int n)
+  {
+    if (n < 2)
+    {
+      return static_cast<std::uint64_t>(n);
+    }
+    std::uint64_t a = 0;
+    std::uint64_t b = 0;
+    scheduler.join([&]()
+                   { a = fibForked(scheduler, n - 1); },
+                   [&]()
+                   { b = fibForked(scheduler, n - 2); });
+    return a + b;
+  }
+
+  /**
+   * @brief Cheap, non-foldable work per index.
+   */
+  inline std::uint64_t work(size_t i)
+  {
+    std::uint64_t x = i * 0x9E3779B97F4A7C15ull;
+    return x ^ (x >> 29);
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  size_t workers = argc > 1 ? std::stoul(argv[1]) : std::max(1u, std::thread::hardware_concurrency());
+  TaskScheduler scheduler(workers);
+  std::cout << std::fixed << std::setprecision(2);
+  std::cout << scheduler.workerCount() << " workers\n"
+            << std::endl;
+
+  // fork/join
+  std::uint64_t expected = 0;
+  double sequential = best([&]()
+                           { expected = fibSequential(fibArgument); });
+  std::uint64_t forkedResult = 0;
+  double forked = best([&]()
+                       { forkedResult = fibForked(scheduler, fibArgument); });
+  if (forkedResult != expected)
+  {
+    std::cerr << "fib(" << fibArgument << ") mismatch: " << forkedResult << " != " << expected << std::endl;
+    return 1;
+  }
+  double forks = static_cast<double>(expected) - 1; // fib(n) - 1 calls with n >= 2
+  forks = std::max(forks, 1.0);
+  std::cout << "fork/join fib(" << fibArgument << "): " << sequential << " ms sequential, " << forked
+            << " ms forked, " << forked * 1e6 / forks << " ns per fork (" << sequential / forked << "x)" << std::endl;
+
+  // parallelFor
+  std::vector<std::uint64_t> out(loopSize);
+  double plain = best([&]()
+                      {
+                        for (size_t i = 0; i < loopSize; ++i)
+                        {
+                          out[i] = work(i);
+                        } });
+  std::cout << "\nparallelFor over " << loopSize << " indices (plain loop " << plain << " ms)" << std::endl;
+  for (size_t grain : {16, 256, 4096, 65536})
+  {
+    double ms = best([&]()
+                     { scheduler.parallelFor(0, loopSize, grain, [&](size_t begin, size_t end)
+                                             {
+                                               for (size_t i = begin; i < end; ++i)
+                                               {
+                                                 out[i] = work(i);
+                                               } }); });
+    double chunks = static_cast<double>((loopSize + grain - 1) / grain);
+    std::cout << "  grain " << std::setw(6) << grain << ": " << std::setw(8) << ms << " ms, "
+              << std::setw(7) << ms * 1e6 / chunks << " ns per chunk, " << plain / ms << "x" << std::endl;
+  }
+
+  // parallelReduce
+  std::uint64_t sequentialSum = 0;
+  double plainSum = best([&]()
+                         {
+                           sequentialSum = 0;
+                           for (size_t i = 0; i < loopSize; ++i)
+                           {
+                             sequentialSum += work(i);
+                           } });
+  std::uint64_t parallelSum = 0;
+  double reduceSum = best([&]()
+                          { parallelSum = scheduler.parallelReduce<std::uint64_t>(
+                                0, loopSize, 4096,
+                                [](size_t begin, size_t end)
+                                {
+                                  std::uint64_t sum = 0;
+                                  for (size_t i = begin; i < end; ++i)
+                                  {
+                                    sum += work(i);
+                                  }
+                                  return sum;
+                                },
+                                [](std::uint64_t a, std::uint64_t b)
+                                { return a + b; }); });
+  if (parallelSum != sequentialSum)
+  {
+    std::cerr << "parallelReduce mismatch." << std::endl;
+    return 1;
+  }
+  std::cout << "\nparallelReduce sum, grain 4096: " << reduceSum << " ms (plain loop " << plainSum << " ms, "
+            << plainSum / reduceSum << "x)" << std::endl;
+
+  // round trip from a non-worker thread
+  std::uint64_t sink = 0;
+  auto start = Clock::now();
+  for (size_t i = 0; i < roundTrips; ++i)
+  {
+    scheduler.parallelFor(0, 2, 1, [&](size_t begin, size_t)
+                          { out[begin] = work(begin + i); });
+    sink += out[0];
+  }
+  double handOff = millisecondsSince(start);
+  start = Clock::now();
+  size_t threadTrips = roundTrips / 10;
+  for (size_t i = 0; i < threadTrips; ++i)
+  {
+    std::thread helper([&]()
+                       { out[1] = work(i + 1); });
+    out[0] = work(i);
+    helper.join();
+    sink += out[0];
+  }
+  double spawned = millisecondsSince(start);
+  std::cout << "\nround trip from a non-worker thread: " << handOff * 1e3 / static_cast<double>(roundTrips)
+            << " us via the scheduler, " << spawned * 1e3 / static_cast<double>(threadTrips)
+            << " us with a new std::thread" << (sink == 42 ? " " : "") << std::endl;
+  return 0;
+}
@@ -0,0 +1,298 @@
+/**
+ * @file asyncTask.hpp
+ * @brief Definition of the AsyncTask, Spawned and AsyncJob coroutine types.
+ *
+ * This file contains the C++20 coroutine types used to run multi-stage
+ * pipelines (such as recipe loading) on the TaskScheduler without tying up a
+ * worker while a stage waits for another.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include "taskScheduler.hpp"
+
+/**
+ * @struct AsyncResult
+ * @brief Holds the value a coroutine returns until its awaiter takes it.
+ */
+template <typename T>
+struct AsyncResult
+{
+  std::optional<T> value;
+
+  void return_value(T result) { value.emplace(std::move(result)); }
+  T take() { return std::move(*value); }
+};
+
+template <>
+struct AsyncResult<void>
+{
+  void return_void() {}
+  void take() {}
+};
+
+/**
+ * @class AsyncTask
+ * @brief Lazy coroutine returning a T, started by co_await.
+ *
+ * Awaiting a task transfers control to it directly, and the task transfers
+ * back to its awaiter when it finishes (symmetric transfer): a chain of
+ * awaits costs no allocation besides the frames and no stack growth. A task
+ * runs on whatever thread resumes it; co_await resumeOn(scheduler) moves it
+ * to a worker.
+ *
+ * Tasks must not throw, like scheduler tasks: an escaping exception
+ * terminates the program.
+ *
+ * @tparam T Result type, or void
+ */
+template <typename T = void>
+class AsyncTask
+{
+public:
+  struct promise_type : AsyncResult<T>
+  {
+    std::coroutine_handle<> continuation = std::noop_coroutine(); ///< Awaiter resumed when the task finishes
+
+    AsyncTask get_return_object() { return AsyncTask(std::coroutine_handle<promise_type>::from_promise(*this)); }
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    struct FinalAwaiter
+    {
+      bool await_ready() noexcept { return false; }
+      std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> self) noexcept
+      {
+        return self.promise().continuation;
+      }
+      void await_resume() noexcept {}
+    };
+
+    FinalAwaiter final_suspend() noexcept { return {}; }
+    void unhandled_exception() noexcept { std::terminate(); }
+  };
+
+  AsyncTask(AsyncTask &&other) noexcept : handle(std::exchange(other.handle, {})) {}
+
+  AsyncTask &operator=(AsyncTask &&other) noexcept
+  {
+    if (this != &other)
+    {
+      if (handle)
+      {
+        handle.destroy();
+      }
+      handle = std::exchange(other.handle, {});
+    }
+    return *this;
+  }
+
+  ~AsyncTask()
+  {
+    if (handle)
+    {
+      handle.destroy();
+    }
+  }
+
+  bool await_ready() const noexcept { return false; }
+
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+  {
+    handle.promise().continuation = awaiting;
+    return handle;
+  }
+
+  T await_resume() { return handle.promise().take(); }
+
+private:
+  explicit AsyncTask(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+
+  std::coroutine_handle<promise_type> handle;
+};
+
+/**
+ * @brief Awaitable that resumes the awaiting coroutine on a scheduler worker.
+ */
+struct ResumeOn
+{
+  TaskScheduler &scheduler;
+
+  bool await_ready() const noexcept { return false; }
+  // The coroutine may run, and free this awaiter, before resume() returns.
+  void await_suspend(std::coroutine_handle<> awaiting) { scheduler.resume(awaiting); }
+  void await_resume() const noexcept {}
+};
+
+inline ResumeOn resumeOn(TaskScheduler &scheduler) { return ResumeOn{scheduler}; }
+
+/**
+ * @struct DetachedCoroutine
+ * @brief Fire-and-forget coroutine: starts at once and frees itself when done.
+ */
+struct DetachedCoroutine
+{
+  struct promise_type
+  {
+    DetachedCoroutine get_return_object() { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() noexcept { std::terminate(); }
+  };
+};
+
+/**
+ * @class Spawned
+ * @brief Handle to an AsyncTask started on the scheduler, awaited later.
+ *
+ * spawn() starts the task on a worker at once, so it runs while the spawning
+ * coroutine does something else; co_await on the handle then waits for its
+ * result without blocking a thread. Whichever of the two comes second, the
+ * end of the task or the await, resumes the awaiter: they agree through one
+ * exchange on the waiter word.
+ *
+ * A handle must be awaited exactly once, before anything the task refers to
+ * goes away.
+ *
+ * @tparam T Result type, or void
+ */
+template <typename T = void>
+class Spawned
+{
+  struct State : AsyncResult<T>
+  {
+    std::atomic<void *> waiter{nullptr}; ///< Null, the awaiting coroutine, or the state itself once done
+  };
+
+public:
+  Spawned() = default;
+
+  bool valid() const { return state != nullptr; } ///< true until awaited
+
+  bool await_ready() const noexcept { return state->waiter.load(std::memory_order_acquire) == state.get(); }
+
+  bool await_suspend(std::coroutine_handle<> awaiting) noexcept
+  {
+    void *expected = nullptr;
+    return state->waiter.compare_exchange_strong(expected, awaiting.address(), std::memory_order_acq_rel,
+                                                 std::memory_order_acquire);
+  }
+
+  T await_resume()
+  {
+    std::shared_ptr<State> done = std::move(state);
+    return done->take();
+  }
+
+  template <typename U>
+  friend Spawned<U> spawn(TaskScheduler &scheduler, AsyncTask<U> task);
+
+private:
+  std::shared_ptr<State> state;
+
+  static DetachedCoroutine run(TaskScheduler &scheduler, AsyncTask<T> task, std::shared_ptr<State> state)
+  {
+    co_await resumeOn(scheduler);
+    if constexpr (std::is_void_v<T>)
+    {
+      co_await task;
+    }
+    else
+    {
+      state->return_value(co_await task);
+    }
+    void *waiter = state->waiter.exchange(state.get(), std::memory_order_acq_rel);
+    if (waiter != nullptr)
+    {
+      std::coroutine_handle<>::from_address(waiter).resume();
+    }
+  }
+};
+
+/**
+ * @brief Starts a task on a scheduler worker and returns a handle to await its result.
+ *
+ * @param [in] scheduler Scheduler that runs the task
+ * @param [in] task Task to run
+ */
+template <typename T>
+Spawned<T> spawn(TaskScheduler &scheduler, AsyncTask<T> task)
+{
+  Spawned<T> handle;
+  handle.state = std::make_shared<typename Spawned<T>::State>();
+  Spawned<T>::run(scheduler, std::move(task), handle.state);
+  return handle;
+}
+
+/**
+ * @class AsyncJob
+ * @brief Runs one AsyncTask<> in the background and lets plain threads wait for it.
+ *
+ * The bridge between coroutines and the rest of the program: start()
+ * returns at once, wait() blocks the calling thread until the task is done.
+ * wait() must not be called from a scheduler worker, which could be the one
+ * needed to finish the task.
+ */
+class AsyncJob
+{
+public:
+  AsyncJob() = default;
+  AsyncJob(const AsyncJob &) = delete;
+  AsyncJob &operator=(const AsyncJob &) = delete;
+
+  /**
+   * @brief Waits for the previous task, then starts this one on a scheduler worker.
+   *
+   * @param [in] scheduler Scheduler that runs the task
+   * @param [in] task Task to run
+   */
+  void start(TaskScheduler &scheduler, AsyncTask<> task)
+  {
+    wait();
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      running = true;
+    }
+    run(scheduler, std::move(task), *this);
+  }
+
+  /**
+   * @brief Blocks until the task started last is done; returns at once if none is running.
+   */
+  void wait()
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [&]()
+                  { return !running; });
+  }
+
+  bool busy() const
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return running;
+  }
+
+private:
+  mutable std::mutex mutex;
+  std::condition_variable finished;
+  bool running = false;
+
+  static DetachedCoroutine run(TaskScheduler &scheduler, AsyncTask<> task, AsyncJob &job)
+  {
+    co_await resumeOn(scheduler);
+    co_await task;
+    // Notified under the lock: a waiter may destroy the job as soon as it is released.
+    std::lock_guard<std::mutex> lock(job.mutex);
+    job.running = false;
+    job.finished.notify_all();
+  }
+};
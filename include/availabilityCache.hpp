@@ -0,0 +1,148 @@
+/**
+ * @file availabilityCache.hpp
+ * @brief Definition of the AvailabilityCache class.
+ *
+ * This file contains the bounded cache of "which recipes can be made"
+ * results, keyed by pantry fingerprint and catalog version.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "epochDomain.hpp"
+#include "memoryUsage.hpp"
+#include "pantry.hpp"
+
+/**
+ * @struct AvailabilityCacheStats
+ * @brief Counters collected by an AvailabilityCache.
+ */
+struct AvailabilityCacheStats
+{
+  size_t hits = 0;      ///< Lookups answered from the cache
+  size_t misses = 0;    ///< Lookups that had to scan the catalog
+  size_t evictions = 0; ///< Entries dropped to make room
+  size_t entries = 0;   ///< Entries currently held
+};
+
+/**
+ * @class AvailabilityCache
+ * @brief Remembers availability results for recently seen pantries.
+ *
+ * A result is a bitmap with one bit per catalog slot, set if the recipe in
+ * that slot can be made: 1 bit per recipe instead of a 4-byte slot per
+ * available recipe, whatever the pantry. Results are keyed by the pantry's
+ * fingerprint and the catalog version, so a result computed on an old
+ * catalog is never returned for a new one even if it is inserted after the
+ * reload; RecipeManager also clears the cache when it publishes a catalog.
+ *
+ * The cache is set associative: a key maps to one set of `ways` entries,
+ * and replacement is CLOCK within the set: a hit sets the entry's reference
+ * bit, and the set's hand evicts the first entry whose bit is clear,
+ * clearing bits as it passes.
+ *
+ * Lookups take no lock. Entries are immutable once published behind an
+ * atomic pointer per slot; find() pins an EpochDomain, compares the entries
+ * of one set and copies the result's shared pointer, and an entry swapped
+ * out by insert() or clear() is freed once no lookup can still read it. The
+ * mutex only serializes insert() and clear(), which run after a catalog
+ * scan or a reload anyway.
+ */
+
+class AvailabilityCache
+{
+public:
+  using Bitmap = std::vector<std::uint64_t>; ///< Bit slot % 64 of word slot / 64 is set if the recipe is available
+
+  /**
+   * @brief Creates an empty cache.
+   *
+   * @param [in] capacity Maximum number of results held, rounded up to whole sets
+   */
+  explicit AvailabilityCache(size_t capacity);
+
+  /**
+   * @brief Frees the entries still held.
+   */
+  ~AvailabilityCache();
+
+  AvailabilityCache(const AvailabilityCache &) = delete;
+  AvailabilityCache &operator=(const AvailabilityCache &) = delete;
+
+  /**
+   * @brief Returns the result for a pantry on a catalog version, or null; never blocks.
+   *
+   * @param [in] version Catalog version the result must have been computed on
+   * @param [in] pantry Fingerprint of the pantry
+   */
+  std::shared_ptr<const Bitmap> find(std::uint64_t version, const PantryFingerprint &pantry);
+
+  /**
+   * @brief Stores a result, evicting the CLOCK victim if the cache is full.
+   *
+   * @param [in] version Catalog version the result was computed on
+   * @param [in] pantry Fingerprint of the pantry
+   * @param [in] result Availability bitmap
+   */
+  void insert(std::uint64_t version, const PantryFingerprint &pantry, std::shared_ptr<const Bitmap> result);
+
+  /**
+   * @brief Drops every result; the counters are kept.
+   */
+  void clear();
+
+  /**
+   * @brief Returns a copy of the counters.
+   */
+  AvailabilityCacheStats stats() const;
+
+  /**
+   * @brief Returns the bytes of the entries and their bitmaps.
+   */
+  MemoryUsage memoryUsage() const;
+
+  static constexpr size_t ways = 8; ///< Entries per set
+
+private:
+  /**
+   * @brief One cached result; never modified once published.
+   */
+  struct Entry
+  {
+    std::uint64_t version;
+    PantryFingerprint pantry;
+    std::shared_ptr<const Bitmap> result;
+  };
+
+  struct Slot
+  {
+    std::atomic<const Entry *> entry{nullptr}; ///< Null for a free slot
+    std::atomic<bool> referenced{false};       ///< CLOCK reference bit
+  };
+
+  size_t sets;                          ///< Number of sets of ways slots
+  std::unique_ptr<Slot[]> slots;        ///< sets * ways slots, set by set
+  mutable EpochDomain epochs;           ///< Frees entries once no find() reads them
+  std::atomic<size_t> hits{0};          ///< Counted without the mutex
+  std::atomic<size_t> misses{0};        ///< Counted without the mutex
+  mutable std::mutex mutex;             ///< Serializes writers and guards the members below
+  std::vector<std::uint8_t> hands;      ///< Next way the CLOCK hand of each set looks at
+  size_t evictions = 0;
+  size_t entries = 0;
+
+  /**
+   * @brief Folds the 128-bit fingerprint and the version into a set key.
+   *
+   * Different keys folding to the same value only share a set; the full key
+   * is compared before a result is returned.
+   */
+  static std::uint64_t keyOf(std::uint64_t version, const PantryFingerprint &pantry)
+  {
+    return pantry.low ^ (pantry.high * 0x9E3779B97F4A7C15ull) ^ (version * 0xC2B2AE3D27D4EB4Full);
+  }
+};
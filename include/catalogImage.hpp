@@ -0,0 +1,89 @@
+/**
+ * @file catalogImage.hpp
+ * @brief Definition of the CatalogImage class.
+ *
+ * This file contains the read-only, position-independent image of a recipe
+ * catalog that one process publishes in POSIX shared memory and others map.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "recipeStore.hpp"
+#include "textCodec.hpp"
+
+/**
+ * @class CatalogImage
+ * @brief Maps a published catalog image and exposes it as RecipeStore columns.
+ *
+ * The image is one contiguous block: a header followed by the recipe columns,
+ * the packed ingredient records, the text pool, the ingredient names in id
+ * order and the instruction codec phrases. Every reference inside the block
+ * is an offset from its start, so each process can map it at any address.
+ *
+ * Ingredient records hold dictionary ids, so an attaching process must intern
+ * names() in order before anything else, and get back the same ids.
+ *
+ * Images are immutable: publish() replaces an image by unlinking it and
+ * creating a new one, and processes that attached the old one keep it until
+ * they detach. Only POSIX systems are supported.
+ */
+class CatalogImage
+{
+public:
+  CatalogImage() = default;
+  CatalogImage(const CatalogImage &) = delete;
+  CatalogImage &operator=(const CatalogImage &) = delete;
+  ~CatalogImage();
+
+  /**
+   * @brief Writes a compacted image of a catalog to shared memory.
+   *
+   * @param [in] name Shared memory object name (e.g. "/virtualchef")
+   * @param [in] store Catalog to publish
+   * @param [in] codec Codec the instructions in the store are encoded with
+   * @return true if the image was published
+   */
+  static bool publish(const std::string &name, const RecipeStore &store, const TextCodec &codec);
+
+  /**
+   * @brief Maps a published image read-only, detaching any previous one.
+   *
+   * @param [in] name Shared memory object name given to publish()
+   * @return true if the image was mapped and is well formed
+   */
+  bool attach(const std::string &name);
+
+  /**
+   * @brief Unmaps the image; columns obtained from it become invalid.
+   */
+  void detach();
+
+  bool attached() const { return base != nullptr; } ///< True while an image is mapped
+  size_t bytes() const { return length; }           ///< Size of the mapping
+
+  /**
+   * @brief Returns the recipe columns, pointing into the mapping.
+   */
+  RecipeStore::Columns columns() const;
+
+  /**
+   * @brief Returns the ingredient names, index i being dictionary id i.
+   */
+  std::vector<std::string_view> names() const;
+
+  /**
+   * @brief Returns the instruction codec phrases in code order.
+   */
+  std::vector<std::string_view> phrases() const;
+
+private:
+  const unsigned char *base = nullptr; ///< Start of the mapping
+  size_t length = 0;                   ///< Bytes mapped
+
+  std::vector<std::string_view> strings(std::uint64_t offset, std::uint32_t count) const;
+};
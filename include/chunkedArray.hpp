@@ -0,0 +1,131 @@
+/**
+ * @file chunkedArray.hpp
+ * @brief Definition of the ChunkedArray class template.
+ *
+ * This file contains an array split into fixed-size chunks that copies of
+ * the array share until one of them writes, used by IdIndex so that catalog
+ * versions share the unchanged parts of their id index.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/**
+ * @class ChunkedArray
+ * @brief Array of trivially copyable values stored in shared chunks.
+ *
+ * Element i lives at offset i % chunkSize of chunk i / chunkSize, so a read
+ * is two loads. Copying the array copies one pointer per chunk; a write to a
+ * chunk another array still holds copies that chunk first. Copies may be
+ * read and destroyed on other threads, but copying and writing must be
+ * serialized by the caller, as the catalog writer lock does.
+ *
+ * @tparam T Element type
+ */
+template <typename T>
+class ChunkedArray
+{
+public:
+  static constexpr size_t chunkSize = 1024; ///< Elements per chunk
+
+  size_t size() const { return length; }                                             ///< Number of elements
+  bool empty() const { return length == 0; }                                         ///< True if there are no elements
+  size_t capacity() const { return chunks.size() * chunkSize; }                      ///< Elements the chunks can hold
+  const T &operator[](size_t i) const { return chunks[i / chunkSize]->items[i % chunkSize]; } ///< Element i
+
+  /**
+   * @brief Overwrites one element, copying its chunk first if it is shared.
+   *
+   * @param [in] i Index, below size()
+   * @param [in] value New value
+   */
+  void set(size_t i, const T &value) { writable(i / chunkSize)[i % chunkSize] = value; }
+
+  /**
+   * @brief Replaces the contents with n copies of a value, in chunks of its own.
+   */
+  void assign(size_t n, const T &value)
+  {
+    clear();
+    resize(n, value);
+  }
+
+  /**
+   * @brief Grows or shrinks the array at the end; new elements are set to value.
+   */
+  void resize(size_t n, const T &value)
+  {
+    chunks.resize((n + chunkSize - 1) / chunkSize);
+    for (size_t i = length; i < n;)
+    {
+      size_t chunk = i / chunkSize;
+      if (!chunks[chunk])
+        chunks[chunk] = std::make_shared<Chunk>();
+      T *items = writable(chunk);
+      for (size_t end = std::min(n, (chunk + 1) * chunkSize); i < end; ++i)
+      {
+        items[i % chunkSize] = value;
+      }
+    }
+    length = n;
+  }
+
+  /**
+   * @brief Inserts whole chunks set to value at the front, shifting every index.
+   *
+   * @param [in] count Chunks to insert
+   * @param [in] value Value of the new elements
+   */
+  void prependChunks(size_t count, const T &value)
+  {
+    std::vector<std::shared_ptr<Chunk>> front(count);
+    for (auto &chunk : front)
+    {
+      chunk = std::make_shared<Chunk>();
+      std::fill(chunk->items, chunk->items + chunkSize, value);
+    }
+    chunks.insert(chunks.begin(), front.begin(), front.end());
+    length += count * chunkSize;
+  }
+
+  /**
+   * @brief Removes every element and lets go of every chunk.
+   */
+  void clear()
+  {
+    std::vector<std::shared_ptr<Chunk>>().swap(chunks);
+    length = 0;
+  }
+
+private:
+  struct Chunk
+  {
+    T items[chunkSize];
+  };
+
+  std::vector<std::shared_ptr<Chunk>> chunks;
+  size_t length = 0;
+
+  /**
+   * @brief Returns the elements of a chunk held by no other array, copying it if needed.
+   */
+  T *writable(size_t chunk)
+  {
+    std::shared_ptr<Chunk> &held = chunks[chunk];
+    if (held.use_count() != 1)
+    {
+      held = std::make_shared<Chunk>(*held);
+    }
+    else
+    {
+      // Order the write after the reads of any copy released on another thread.
+      std::atomic_thread_fence(std::memory_order_acquire);
+    }
+    return held->items;
+  }
+};
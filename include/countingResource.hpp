@@ -0,0 +1,64 @@
+/**
+ * @file countingResource.hpp
+ * @brief Definition of the CountingResource class.
+ *
+ * This file contains a std::pmr memory resource adaptor that counts the
+ * allocations passing through it, used to measure allocator overhead.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory_resource>
+
+/**
+ * @struct AllocationStats
+ * @brief Counters collected by a CountingResource.
+ */
+struct AllocationStats
+{
+  size_t allocations = 0;    ///< Number of allocate() calls
+  size_t deallocations = 0;  ///< Number of deallocate() calls
+  size_t bytesAllocated = 0; ///< Total bytes requested by allocate()
+  size_t bytesLive = 0;      ///< Bytes allocated and not yet deallocated
+};
+
+/**
+ * @class CountingResource
+ * @brief Memory resource that forwards to an upstream resource and counts.
+ *
+ * The counters are atomic, so a CountingResource is as thread-safe as its
+ * upstream: catalog pages are released on whichever thread drops them last.
+ */
+class CountingResource : public std::pmr::memory_resource
+{
+public:
+  /**
+   * @brief Constructs a counter in front of the given resource.
+   *
+   * @param [in] upstream Resource that performs the actual allocations
+   */
+  explicit CountingResource(std::pmr::memory_resource *upstream = std::pmr::new_delete_resource());
+
+  /**
+   * @brief Returns the counters collected since construction or the last reset().
+   */
+  AllocationStats stats() const;
+
+  /**
+   * @brief Clears every counter.
+   */
+  void reset();
+
+private:
+  std::pmr::memory_resource *upstream;
+  std::atomic<size_t> allocations{0};
+  std::atomic<size_t> deallocations{0};
+  std::atomic<size_t> bytesAllocated{0};
+  std::atomic<size_t> bytesLive{0};
+
+  void *do_allocate(size_t bytes, size_t alignment) override;
+  void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+  bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+};
@@ -0,0 +1,136 @@
+/**
+ * @file epochDomain.hpp
+ * @brief Definition of the EpochDomain class.
+ *
+ * This file contains the epoch-based reclamation scheme that lets readers use
+ * a published snapshot without locks or reference counting while writers
+ * replace it.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+/**
+ * @class EpochDomain
+ * @brief Frees retired objects once no reader can still be using them.
+ *
+ * A reader pins the domain for the length of a query: it announces the
+ * current global epoch in one of maxReaders slots, then loads the pointers it
+ * wants to read. A writer that swaps an object out retires it, tagged with
+ * the epoch at the time of the swap, and advances the global epoch.
+ * collect() frees a retired object once every pinned reader has announced a
+ * later epoch, because such readers loaded their pointers after the swap.
+ *
+ * Pinning claims a free slot with one compare-and-swap and unpinning is one
+ * store, each on the slot's own cache line; readers never wait for writers.
+ * retire() and collect() are for writers and serialize among themselves.
+ */
+
+class EpochDomain
+{
+public:
+  static constexpr size_t maxReaders = 64; ///< Readers that can be pinned at the same time
+
+  /**
+   * @class Guard
+   * @brief Keeps the domain pinned until it goes out of scope.
+   */
+  class Guard
+  {
+  public:
+    Guard(Guard &&other) noexcept : slot(other.slot) { other.slot = nullptr; }
+    Guard(const Guard &) = delete;
+    Guard &operator=(const Guard &) = delete;
+    Guard &operator=(Guard &&) = delete;
+    ~Guard()
+    {
+      if (slot != nullptr)
+      {
+        slot->store(0, std::memory_order_release);
+      }
+    }
+
+  private:
+    friend class EpochDomain;
+    explicit Guard(std::atomic<std::uint64_t> *slot) : slot(slot) {}
+
+    std::atomic<std::uint64_t> *slot; ///< Announced epoch, reset to 0 on release
+  };
+
+  EpochDomain() = default;
+  EpochDomain(const EpochDomain &) = delete;
+  EpochDomain &operator=(const EpochDomain &) = delete;
+
+  /**
+   * @brief Frees every retired object; no reader may still be pinned.
+   */
+  ~EpochDomain();
+
+  /**
+   * @brief Pins the domain for the calling reader.
+   *
+   * Pointers loaded (with sequentially consistent loads) after this call stay
+   * valid until the guard is destroyed. If all maxReaders slots are taken,
+   * waits for another reader to unpin, never for a writer.
+   *
+   * @return Guard that unpins on destruction
+   */
+  Guard pin();
+
+  /**
+   * @brief Hands over an object that was just swapped out of a shared pointer.
+   *
+   * The object is deleted by a later collect(), or by the destructor.
+   *
+   * @param [in] object Object no longer reachable by new readers, may be null
+   */
+  template <typename T>
+  void retire(const T *object)
+  {
+    if (object != nullptr)
+    {
+      retire(const_cast<T *>(object), [](void *p)
+             { delete static_cast<T *>(p); });
+    }
+  }
+
+  /**
+   * @brief Deletes the retired objects that no pinned reader can reach.
+   *
+   * @return Number of objects deleted
+   */
+  size_t collect();
+
+  /**
+   * @brief Returns the number of retired objects not deleted yet.
+   */
+  size_t pending() const;
+
+private:
+  /**
+   * @brief One reader slot, alone on its cache line; epoch 0 means free.
+   */
+  struct alignas(64) Slot
+  {
+    std::atomic<std::uint64_t> epoch{0};
+  };
+
+  struct Retired
+  {
+    std::uint64_t epoch;      ///< Global epoch when the object was swapped out
+    void *object;             ///< Object to delete
+    void (*destroy)(void *);  ///< Deletes the object with its real type
+  };
+
+  std::atomic<std::uint64_t> globalEpoch{1}; ///< Starts at 1 so 0 can mark free slots
+  Slot slots[maxReaders];
+  mutable std::mutex retiredMutex;           ///< Guards retired
+  std::vector<Retired> retired;
+
+  void retire(void *object, void (*destroy)(void *));
+};
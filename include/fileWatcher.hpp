@@ -0,0 +1,73 @@
+/**
+ * @file fileWatcher.hpp
+ * @brief Definition of the FileWatcher class.
+ *
+ * This file contains a small background watcher that notifies a callback
+ * whenever one of the watched data files changes on disk.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @class FileWatcher
+ * @brief Watches a set of files and reports changes from a background thread.
+ *
+ * On Linux the watcher uses inotify on the parent directory of every file, so
+ * editors that save by writing a temporary file and renaming it are detected too.
+ * On other platforms it falls back to polling the last write time once per second.
+ */
+
+class FileWatcher
+{
+public:
+  using Callback = std::function<void(const std::string &path)>; ///< Called with the path that changed
+
+  /**
+   * @brief Constructs a watcher for the given files.
+   *
+   * The watcher does not start until start() is called.
+   *
+   * @param [in] paths Files to watch
+   * @param [in] onChange Callback invoked from the watcher thread for every changed file
+   */
+  FileWatcher(const std::vector<std::string> &paths, Callback onChange);
+
+  /**
+   * @brief Stops the watcher thread if it is still running.
+   */
+  ~FileWatcher();
+
+  FileWatcher(const FileWatcher &) = delete;
+  FileWatcher &operator=(const FileWatcher &) = delete;
+
+  /**
+   * @brief Starts the background thread.
+   *
+   * @return true if the watcher is running, false if it could not be initialized
+   */
+  bool start();
+
+  /**
+   * @brief Stops the background thread and waits for it to finish.
+   */
+  void stop();
+
+private:
+  std::vector<std::string> paths; ///< Files being watched
+  Callback onChange;              ///< Change notification callback
+  std::atomic<bool> running{false};
+  std::thread worker;
+  int inotifyFd = -1; ///< inotify descriptor (Linux only)
+  std::vector<int> watches; ///< Watch descriptor of the directory of each path, or -1 (Linux only)
+
+  /**
+   * @brief Main loop of the watcher thread.
+   */
+  void run();
+};
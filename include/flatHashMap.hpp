@@ -0,0 +1,464 @@
+/**
+ * @file flatHashMap.hpp
+ * @brief Definition of the FlatHashMap class template.
+ *
+ * This file contains an open-addressing hash map in the style of Swiss
+ * tables, used for the name and id lookups of the pantry and the ingredient
+ * dictionary.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <utility>
+#include "memoryUsage.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VIRTUALCHEF_FLAT_HASH_SSE2 1
+#include <emmintrin.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/**
+ * @struct StringHash
+ * @brief Transparent string hash, so std::string keys can be found with a std::string_view.
+ */
+struct StringHash
+{
+  using is_transparent = void;
+
+  size_t operator()(std::string_view text) const noexcept { return std::hash<std::string_view>{}(text); }
+};
+
+/**
+ * @class FlatHashMap
+ * @brief Open-addressing hash map with SIMD group probing.
+ *
+ * Keys and values live in one flat slot array, next to a control byte per
+ * slot: empty, deleted, or the low 7 bits of the key's hash (H2). Slots are
+ * probed sixteen at a time: one SSE2 compare of the group's control bytes
+ * against H2 yields every candidate slot, so a lookup usually touches one
+ * cache line of control bytes and the one slot that matches. Without SSE2 the
+ * same bit masks are computed one byte at a time.
+ *
+ * Lookups are heterogeneous: any key type the hash and equality accept can be
+ * used (a std::string_view for std::string keys with StringHash). Every
+ * operation also has an overload taking a hash from hashOf(), so a hash
+ * computed once can be reused across several tables.
+ *
+ * Pointers to values are invalidated by insertion (which may rehash) and by
+ * erasing that key.
+ *
+ * @tparam Key Key type
+ * @tparam Value Mapped type
+ * @tparam Hash Hash function
+ * @tparam Equal Key equality, transparent by default
+ */
+template <typename Key, typename Value, typename Hash = std::hash<Key>, typename Equal = std::equal_to<>>
+class FlatHashMap
+{
+public:
+  FlatHashMap() = default;
+
+  FlatHashMap(const FlatHashMap &other)
+  {
+    reserve(other.count);
+    other.forEach([this](const Key &key, const Value &value)
+                  { tryEmplace(key, value); });
+  }
+
+  FlatHashMap(FlatHashMap &&other) noexcept { swap(other); }
+
+  FlatHashMap &operator=(FlatHashMap other) noexcept
+  {
+    swap(other);
+    return *this;
+  }
+
+  ~FlatHashMap() { release(); }
+
+  void swap(FlatHashMap &other) noexcept
+  {
+    std::swap(ctrl, other.ctrl);
+    std::swap(slots, other.slots);
+    std::swap(cap, other.cap);
+    std::swap(count, other.count);
+    std::swap(growthLeft, other.growthLeft);
+  }
+
+  size_t size() const { return count; }           ///< Number of entries
+  bool empty() const { return count == 0; }       ///< True if there are no entries
+  size_t capacity() const { return cap; }         ///< Number of slots
+
+  /**
+   * @brief Returns the bytes of the slots and control bytes.
+   *
+   * Memory owned by the keys and values themselves (e.g. long strings) is not included.
+   */
+  MemoryUsage memoryUsage() const { return {count * (sizeof(Slot) + 1), cap * (sizeof(Slot) + 1)}; }
+
+  /**
+   * @brief Returns the hash the table uses for a key.
+   *
+   * @param [in] key Key, or any type the hash accepts
+   * @return Mixed hash, to pass to the overloads that take one
+   */
+  template <typename K>
+  size_t hashOf(const K &key) const
+  {
+    std::uint64_t x = static_cast<std::uint64_t>(Hash{}(key));
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    return static_cast<size_t>(x);
+  }
+
+  /**
+   * @brief Looks a key up.
+   *
+   * @param [in] key Key to find
+   * @return Pointer to the value, or nullptr if the key is not present
+   */
+  template <typename K>
+  Value *find(const K &key) { return find(key, hashOf(key)); }
+
+  template <typename K>
+  const Value *find(const K &key) const { return find(key, hashOf(key)); }
+
+  template <typename K>
+  Value *find(const K &key, size_t hash)
+  {
+    size_t index = findIndex(key, hash);
+    return index == npos ? nullptr : &slots[index].value;
+  }
+
+  template <typename K>
+  const Value *find(const K &key, size_t hash) const
+  {
+    size_t index = findIndex(key, hash);
+    return index == npos ? nullptr : &slots[index].value;
+  }
+
+  template <typename K>
+  bool contains(const K &key) const { return findIndex(key, hashOf(key)) != npos; }
+
+  /**
+   * @brief Inserts a key if it is not present yet.
+   *
+   * @param [in] key Key; converted to Key only when it is inserted
+   * @param [in] args Arguments for the value's constructor
+   * @return Pointer to the value and true if it was inserted, false if the key existed
+   */
+  template <typename K, typename... Args>
+  std::pair<Value *, bool> tryEmplace(K &&key, Args &&...args)
+  {
+    size_t hash = hashOf(key);
+    return tryEmplaceHashed(hash, std::forward<K>(key), std::forward<Args>(args)...);
+  }
+
+  template <typename K, typename... Args>
+  std::pair<Value *, bool> tryEmplaceHashed(size_t hash, K &&key, Args &&...args)
+  {
+    size_t index = findIndex(key, hash);
+    if (index != npos)
+    {
+      return {&slots[index].value, false};
+    }
+    if (growthLeft == 0)
+    {
+      // Grow when the table is really full; otherwise the slots are held by
+      // tombstones and a rehash at the same size reclaims them.
+      rehash(cap == 0 ? groupWidth : (count * 2 >= maxLoad(cap) ? cap * 2 : cap));
+    }
+    index = findInsertIndex(hash);
+    if (ctrl[index] == emptyCtrl)
+    {
+      --growthLeft;
+    }
+    ctrl[index] = h2(hash);
+    ::new (static_cast<void *>(&slots[index])) Slot{Key(std::forward<K>(key)), Value(std::forward<Args>(args)...)};
+    ++count;
+    return {&slots[index].value, true};
+  }
+
+  /**
+   * @brief Returns the value of a key, inserting a default one if needed.
+   */
+  template <typename K>
+  Value &operator[](K &&key) { return *tryEmplace(std::forward<K>(key)).first; }
+
+  /**
+   * @brief Removes a key.
+   *
+   * @param [in] key Key to remove
+   * @return true if the key was present
+   */
+  template <typename K>
+  bool erase(const K &key)
+  {
+    size_t index = findIndex(key, hashOf(key));
+    if (index == npos)
+    {
+      return false;
+    }
+    slots[index].~Slot();
+    --count;
+    // A group that still has an empty slot never let a probe continue past
+    // it, so the erased slot can become empty instead of a tombstone.
+    if (Group(ctrl + (index & ~(groupWidth - 1))).matchEmpty() != 0)
+    {
+      ctrl[index] = emptyCtrl;
+      ++growthLeft;
+    }
+    else
+    {
+      ctrl[index] = deletedCtrl;
+    }
+    return true;
+  }
+
+  /**
+   * @brief Removes every entry, keeping the slots.
+   */
+  void clear()
+  {
+    for (size_t i = 0; i < cap; ++i)
+    {
+      if (ctrl[i] >= 0)
+        slots[i].~Slot();
+    }
+    if (cap > 0)
+    {
+      std::memset(ctrl, emptyCtrl, cap);
+    }
+    count = 0;
+    growthLeft = maxLoad(cap);
+  }
+
+  /**
+   * @brief Makes room for a number of entries without rehashing.
+   *
+   * @param [in] entries Number of entries
+   */
+  void reserve(size_t entries)
+  {
+    size_t wanted = groupWidth;
+    while (maxLoad(wanted) < entries)
+    {
+      wanted *= 2;
+    }
+    if (wanted > cap)
+    {
+      rehash(wanted);
+    }
+  }
+
+  /**
+   * @brief Calls f(key, value) for every entry, in table order.
+   */
+  template <typename F>
+  void forEach(F &&f) const
+  {
+    for (size_t i = 0; i < cap; ++i)
+    {
+      if (ctrl[i] >= 0)
+        f(static_cast<const Key &>(slots[i].key), static_cast<const Value &>(slots[i].value));
+    }
+  }
+
+  template <typename F>
+  void forEach(F &&f)
+  {
+    for (size_t i = 0; i < cap; ++i)
+    {
+      if (ctrl[i] >= 0)
+        f(static_cast<const Key &>(slots[i].key), slots[i].value);
+    }
+  }
+
+private:
+  static constexpr size_t groupWidth = 16;
+  static constexpr size_t npos = static_cast<size_t>(-1);
+  static constexpr std::int8_t emptyCtrl = -128;
+  static constexpr std::int8_t deletedCtrl = -2;
+
+  struct Slot
+  {
+    Key key;
+    Value value;
+  };
+
+  /**
+   * @brief Sixteen control bytes and the bit masks computed from them.
+   */
+  class Group
+  {
+  public:
+    explicit Group(const std::int8_t *bytes)
+    {
+#ifdef VIRTUALCHEF_FLAT_HASH_SSE2
+      data = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bytes));
+#else
+      std::memcpy(data, bytes, groupWidth);
+#endif
+    }
+
+    /// Bit i is set if control byte i equals h.
+    std::uint32_t match(std::int8_t h) const
+    {
+#ifdef VIRTUALCHEF_FLAT_HASH_SSE2
+      return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h), data)));
+#else
+      std::uint32_t mask = 0;
+      for (size_t i = 0; i < groupWidth; ++i)
+        mask |= static_cast<std::uint32_t>(data[i] == h) << i;
+      return mask;
+#endif
+    }
+
+    /// Bit i is set if slot i is empty.
+    std::uint32_t matchEmpty() const { return match(emptyCtrl); }
+
+    /// Bit i is set if slot i is empty or deleted (control byte has its sign bit set).
+    std::uint32_t matchFree() const
+    {
+#ifdef VIRTUALCHEF_FLAT_HASH_SSE2
+      return static_cast<std::uint32_t>(_mm_movemask_epi8(data));
+#else
+      std::uint32_t mask = 0;
+      for (size_t i = 0; i < groupWidth; ++i)
+        mask |= static_cast<std::uint32_t>(data[i] < 0) << i;
+      return mask;
+#endif
+    }
+
+  private:
+#ifdef VIRTUALCHEF_FLAT_HASH_SSE2
+    __m128i data;
+#else
+    std::int8_t data[groupWidth];
+#endif
+  };
+
+  std::int8_t *ctrl = nullptr; ///< One control byte per slot
+  Slot *slots = nullptr;       ///< Slot storage, constructed where ctrl >= 0
+  size_t cap = 0;              ///< Number of slots, zero or a power of two >= groupWidth
+  size_t count = 0;            ///< Live entries
+  size_t growthLeft = 0;       ///< Empty slots that may still be filled before a rehash
+
+  static size_t maxLoad(size_t slotCount) { return slotCount - slotCount / 8; }
+  static std::int8_t h2(size_t hash) { return static_cast<std::int8_t>(hash & 0x7F); }
+  static size_t h1(size_t hash) { return hash >> 7; }
+
+  static unsigned lowestBit(std::uint32_t mask)
+  {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+  }
+
+  /**
+   * @brief Visits groups in triangular order, which reaches every group of a power-of-two table.
+   */
+  template <typename K>
+  size_t findIndex(const K &key, size_t hash) const
+  {
+    if (cap == 0)
+    {
+      return npos;
+    }
+    size_t groupMask = cap / groupWidth - 1;
+    size_t group = h1(hash) & groupMask;
+    for (size_t step = 1;; ++step)
+    {
+      size_t base = group * groupWidth;
+      Group bytes(ctrl + base);
+      for (std::uint32_t mask = bytes.match(h2(hash)); mask != 0; mask &= mask - 1)
+      {
+        size_t index = base + lowestBit(mask);
+        if (Equal{}(slots[index].key, key))
+          return index;
+      }
+      if (bytes.matchEmpty() != 0 || step > groupMask)
+      {
+        return npos;
+      }
+      group = (group + step) & groupMask;
+    }
+  }
+
+  size_t findInsertIndex(size_t hash) const
+  {
+    size_t groupMask = cap / groupWidth - 1;
+    size_t group = h1(hash) & groupMask;
+    for (size_t step = 1;; ++step)
+    {
+      size_t base = group * groupWidth;
+      std::uint32_t mask = Group(ctrl + base).matchFree();
+      if (mask != 0)
+      {
+        return base + lowestBit(mask);
+      }
+      group = (group + step) & groupMask;
+    }
+  }
+
+  void rehash(size_t newCap)
+  {
+    std::int8_t *oldCtrl = ctrl;
+    Slot *oldSlots = slots;
+    size_t oldCap = cap;
+
+    ctrl = new std::int8_t[newCap];
+    std::memset(ctrl, emptyCtrl, newCap);
+    slots = std::allocator<Slot>().allocate(newCap);
+    cap = newCap;
+    growthLeft = maxLoad(newCap) - count;
+
+    for (size_t i = 0; i < oldCap; ++i)
+    {
+      if (oldCtrl[i] < 0)
+        continue;
+      size_t hash = hashOf(oldSlots[i].key);
+      size_t index = findInsertIndex(hash);
+      ctrl[index] = h2(hash);
+      ::new (static_cast<void *>(&slots[index])) Slot{std::move(oldSlots[i])};
+      oldSlots[i].~Slot();
+    }
+    delete[] oldCtrl;
+    if (oldSlots != nullptr)
+    {
+      std::allocator<Slot>().deallocate(oldSlots, oldCap);
+    }
+  }
+
+  void release()
+  {
+    for (size_t i = 0; i < cap; ++i)
+    {
+      if (ctrl[i] >= 0)
+        slots[i].~Slot();
+    }
+    delete[] ctrl;
+    if (slots != nullptr)
+    {
+      std::allocator<Slot>().deallocate(slots, cap);
+    }
+    ctrl = nullptr;
+    slots = nullptr;
+    cap = count = growthLeft = 0;
+  }
+};
@@ -0,0 +1,82 @@
+/**
+ * @file hugePageResource.hpp
+ * @brief Definition of the HugePageResource class.
+ *
+ * This file contains a std::pmr memory resource that backs large blocks with
+ * 2 MiB pages, to cut TLB misses when scanning big catalogs.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <mutex>
+#include <unordered_map>
+
+/**
+ * @struct HugePageStats
+ * @brief Live bytes held by a HugePageResource, by kind of backing.
+ */
+struct HugePageStats
+{
+  size_t explicitBytes = 0;    ///< Bytes mapped with MAP_HUGETLB (reserved huge pages)
+  size_t transparentBytes = 0; ///< Bytes mapped normally and advised with MADV_HUGEPAGE
+  size_t upstreamBytes = 0;    ///< Bytes served by the upstream resource
+};
+
+/**
+ * @class HugePageResource
+ * @brief Memory resource that maps large allocations on huge pages.
+ *
+ * Requests of at least minBytes are rounded up to whole huge pages and mapped
+ * with MAP_HUGETLB. When the system has no reserved huge pages, the block is
+ * mapped normally, aligned to a huge page boundary, and madvise(MADV_HUGEPAGE)
+ * asks for transparent huge pages instead. Smaller requests, and any request
+ * that cannot be mapped, go to the upstream resource, so the resource never
+ * fails where the upstream would not. Outside Linux every request goes
+ * upstream.
+ *
+ * Meant as the upstream of an arena, which asks for a few large blocks.
+ * Thread-safe: an arena may be freed by whichever thread drops the last
+ * reference to its catalog while a writer allocates from another one, so
+ * the block table is guarded by a mutex, taken once per large block.
+ */
+class HugePageResource : public std::pmr::memory_resource
+{
+public:
+  static constexpr size_t hugePageSize = size_t(2) << 20; ///< 2 MiB, the x86-64 and arm64 default
+
+  /**
+   * @brief Constructs the resource.
+   *
+   * @param [in] minBytes Smallest request mapped on huge pages
+   * @param [in] upstream Resource for smaller requests and fallbacks
+   */
+  explicit HugePageResource(size_t minBytes = hugePageSize,
+                            std::pmr::memory_resource *upstream = std::pmr::new_delete_resource());
+  HugePageResource(const HugePageResource &) = delete;
+  HugePageResource &operator=(const HugePageResource &) = delete;
+  ~HugePageResource() override;
+
+  /**
+   * @brief Returns a copy of the live bytes held, by kind of backing.
+   */
+  HugePageStats stats() const;
+
+private:
+  struct Mapping
+  {
+    size_t length;      ///< Bytes mapped, a multiple of hugePageSize
+    bool explicitPages; ///< True if mapped with MAP_HUGETLB
+  };
+
+  size_t minBytes;
+  std::pmr::memory_resource *upstream;
+  mutable std::mutex mutex;                     ///< Guards counters and mappings
+  HugePageStats counters;
+  std::unordered_map<void *, Mapping> mappings; ///< Blocks mapped by this resource
+
+  void *do_allocate(size_t bytes, size_t alignment) override;
+  void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+  bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+};
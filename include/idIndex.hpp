@@ -0,0 +1,104 @@
+/**
+ * @file idIndex.hpp
+ * @brief Definition of the IdIndex class.
+ *
+ * This file contains the map from external recipe ids to their slot in the
+ * RecipeStore, used to find a recipe by id in constant time.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "chunkedArray.hpp"
+#include "memoryUsage.hpp"
+
+/**
+ * @class IdIndex
+ * @brief Maps integer ids to 32-bit slots in O(1).
+ *
+ * Recipe ids are usually small and nearly consecutive, so the index starts as
+ * a direct-mapped array covering [base, base + size): a lookup is one
+ * subtraction and two loads. The array grows geometrically at both ends, so
+ * ids inserted in ascending or descending order cost amortized O(1) each.
+ * When an id would stretch the array to more than
+ * a few times the number of entries, the index switches to an open-addressing
+ * hash table with linear probing. A later rehash switches back to the array
+ * if the ids have become compact again.
+ *
+ * Both layouts are ChunkedArrays, so copying an index shares its chunks and
+ * a catalog version that changes a few ids copies only the chunks it writes.
+ */
+
+class IdIndex
+{
+public:
+  static constexpr std::uint32_t npos = 0xFFFFFFFFu; ///< Returned by find() for unknown ids
+
+  /**
+   * @brief Returns the slot of an id.
+   *
+   * @param [in] id External id
+   * @return Slot, or npos if the id is not in the index
+   */
+  std::uint32_t find(int id) const;
+
+  /**
+   * @brief Returns true if the id is in the index.
+   */
+  bool contains(int id) const { return find(id) != npos; }
+
+  /**
+   * @brief Inserts an id or changes its slot.
+   *
+   * @param [in] id External id
+   * @param [in] slot Slot to store, must not be npos
+   */
+  void assign(int id, std::uint32_t slot);
+
+  /**
+   * @brief Removes an id; does nothing if it is not in the index.
+   *
+   * @param [in] id External id
+   */
+  void erase(int id);
+
+  /**
+   * @brief Returns the number of ids in the index.
+   */
+  size_t size() const { return count; }
+
+  /**
+   * @brief Returns true while the index is a direct-mapped array.
+   */
+  bool dense() const { return isDense; }
+
+  /**
+   * @brief Returns the bytes of the array or the hash table.
+   */
+  MemoryUsage memoryUsage() const;
+
+private:
+  static constexpr std::uint32_t tombstone = npos - 1; ///< Slot of an erased hash table entry
+  static constexpr size_t maxSpread = 4;              ///< Array length allowed per entry
+  static constexpr size_t minSpan = 64;               ///< Array length always allowed
+
+  struct Entry
+  {
+    int id;             ///< External id
+    std::uint32_t slot; ///< Slot, npos if empty or tombstone if erased
+  };
+
+  bool isDense = true;
+  long long base = 0;                ///< Id stored at slots[0]
+  size_t room = 0;                   ///< Leading slots kept free for ids below base + room, the lowest id
+  ChunkedArray<std::uint32_t> slots; ///< Direct-mapped array, npos where there is no id
+  ChunkedArray<Entry> table;         ///< Hash table, a power of two in size
+  size_t count = 0;                  ///< Ids in the index
+  size_t used = 0;                   ///< Hash table entries that are live or tombstones
+
+  static bool compact(long long lo, long long hi, size_t entries);
+  static size_t bucket(int id, size_t mask);
+  void rebuild(int pending, bool allowDense);
+  void insertHashed(int id, std::uint32_t slot);
+};
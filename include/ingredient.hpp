@@ -8,23 +8,132 @@
 
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include "ingredientDictionary.hpp"
+
+/**
+ * @enum Unit
+ * @brief Units of measurement used by recipes and the pantry.
+ *
+ * Stored in a single byte; use parseUnit() and unitName() to convert
+ * from and to the text used in the data files.
+ */
+enum class Unit : std::uint8_t
+{
+  Unknown,     ///< Missing or unrecognized unit
+  Grams,       ///< "grams"
+  Milliliters, ///< "milliliters"
+  Units,       ///< "units"
+  Cloves,      ///< "cloves"
+  Slices,      ///< "slices"
+  Pieces,      ///< "pieces"
+  Stalks       ///< "stalks"; keep last, CatalogImage::attach() range-checks against it
+};
+
+/**
+ * @brief Parses a unit name as written in the data files.
+ *
+ * Matching is case-insensitive and accepts singular forms and the usual
+ * abbreviations ("g", "ml").
+ *
+ * @param [in] text Unit name, already trimmed
+ * @param [out] out Parsed unit
+ * @return true if the text names a known unit
+ */
+bool parseUnit(std::string_view text, Unit &out);
+
+/**
+ * @brief Returns the canonical (plural) name of a unit.
+ *
+ * @param [in] unit Unit to convert
+ * @return Unit name, or an empty string for Unit::Unknown
+ */
+const char *unitName(Unit unit);
+
+/**
+ * @brief Parses a decimal quantity into hundredths of a unit.
+ *
+ * Accepts whole numbers and up to two decimals ("2", "0.5", "12.25").
+ *
+ * @param [in] text Quantity, already trimmed
+ * @param [out] out Quantity in hundredths
+ * @return true if the text is a non-negative number in range
+ */
+bool parseQuantity(std::string_view text, std::int32_t &out);
+
+/**
+ * @brief Converts a quantity read as a number (e.g. from JSON) to hundredths.
+ *
+ * @param [in] value Quantity in whole units
+ * @return Quantity in hundredths, rounded to the nearest hundredth
+ */
+std::int32_t quantityFromDouble(double value);
+
+/**
+ * @brief Formats a quantity in hundredths for display ("2", "0.5", "12.25").
+ *
+ * @param [in] quantity Quantity in hundredths
+ * @return Decimal text without trailing zeros
+ */
+std::string formatQuantity(std::int32_t quantity);
 
 /**
  * @struct Ingredient
  * @brief Represents an ingredient with name, quantity, and unit.
  *
  * This structure is used to store basic information about an ingredient.
+ * It is a packed, trivially copyable record: the name is interned in the
+ * shared IngredientDictionary and stored as its id, the quantity is fixed
+ * point in hundredths of a unit and the unit takes one byte. Five records fit
+ * in a cache line, and comparing two ingredients never touches a string.
  */
 
 struct Ingredient
 {
-  std::string name; ///< Name of the ingredient (e.g., "Flour")
-  int quantity;     ///< Quantity available or required
-  std::string unit; ///< Unit of measurement (e.g., "grams", "ml", "units")
+  static constexpr std::int32_t quantityScale = 100; ///< Stored quantity units per whole unit
+
+  std::uint32_t nameId = IngredientDictionary::npos; ///< Id of the name in IngredientDictionary::shared()
+  std::int32_t quantity = 0;                         ///< Quantity available or required, in hundredths
+  Unit unit = Unit::Unknown;                         ///< Unit of measurement (e.g., grams, milliliters, units)
+
+  Ingredient() = default;
+
+  /**
+   * @brief Constructs an ingredient, interning its name.
+   *
+   * @param [in] name Name of the ingredient (e.g., "Flour")
+   * @param [in] quantity Quantity in hundredths (see quantityScale)
+   * @param [in] unit Unit of measurement
+   */
+  Ingredient(std::string_view name, std::int32_t quantity, Unit unit)
+      : nameId(IngredientDictionary::shared().intern(name)), quantity(quantity), unit(unit)
+  {
+  }
+
+  /**
+   * @brief Returns the name of the ingredient, or "" for a default-constructed one.
+   */
+  std::string_view name() const
+  {
+    return nameId == IngredientDictionary::npos ? std::string_view() : IngredientDictionary::shared().name(nameId);
+  }
 };
 
-struct SimpleIngredient
+static_assert(sizeof(Ingredient) <= 16, "Ingredient must stay a compact record");
+static_assert(std::is_trivially_copyable<Ingredient>::value, "Ingredient must stay trivially copyable");
+
+/**
+ * @brief Compares two ingredients field by field.
+ */
+inline bool operator==(const Ingredient &a, const Ingredient &b)
+{
+  return a.nameId == b.nameId && a.quantity == b.quantity && a.unit == b.unit;
+}
+
+inline bool operator!=(const Ingredient &a, const Ingredient &b)
 {
-  std::string name;
-};
\ No newline at end of file
+  return !(a == b);
+}
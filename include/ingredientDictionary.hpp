@@ -0,0 +1,105 @@
+/**
+ * @file ingredientDictionary.hpp
+ * @brief Definition of the IngredientDictionary class.
+ *
+ * This file contains the table that interns ingredient names into small
+ * integer ids, so recipes and the pantry can be matched by id.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include "flatHashMap.hpp"
+#include "memoryUsage.hpp"
+
+/**
+ * @class IngredientDictionary
+ * @brief Interns ingredient names into dense 32-bit ids.
+ *
+ * Ids are assigned in insertion order starting at 0 and are never reused or
+ * invalidated, so they can be stored anywhere and compared directly.
+ *
+ * Names are kept in fixed-size chunks that never move. intern() and find()
+ * take a lock; name() does not, so any thread holding an id can read its name
+ * while another thread is interning.
+ */
+
+class IngredientDictionary
+{
+public:
+  static constexpr std::uint32_t npos = 0xFFFFFFFFu; ///< Returned by find() for unknown names
+
+  IngredientDictionary() = default;
+  IngredientDictionary(const IngredientDictionary &) = delete;
+  IngredientDictionary &operator=(const IngredientDictionary &) = delete;
+  ~IngredientDictionary();
+
+  /**
+   * @brief Returns the dictionary shared by every Ingredient of the process.
+   */
+  static IngredientDictionary &shared();
+
+  /**
+   * @brief Returns the id of a name, adding it to the dictionary if needed.
+   *
+   * Aborts the process if the dictionary is full; names from untrusted
+   * sources go through tryIntern() instead.
+   *
+   * @param [in] name Ingredient name
+   * @return Id of the name
+   */
+  std::uint32_t intern(std::string_view name);
+
+  /**
+   * @brief Returns the id of a name, adding it if needed and if there is room.
+   *
+   * @param [in] name Ingredient name
+   * @param [out] id Id of the name, set only on success
+   * @return false if the name is new and the dictionary is full
+   */
+  bool tryIntern(std::string_view name, std::uint32_t &id);
+
+  /**
+   * @brief Looks a name up without adding it.
+   *
+   * @param [in] name Ingredient name
+   * @return Id of the name, or npos if it was never interned
+   */
+  std::uint32_t find(std::string_view name) const;
+
+  /**
+   * @brief Returns the name of an id.
+   *
+   * @param [in] id Id returned by intern()
+   * @return The interned name; the view stays valid for the dictionary's lifetime
+   */
+  std::string_view name(std::uint32_t id) const
+  {
+    return chunks[id >> chunkBits].load(std::memory_order_acquire)[id & (chunkSize - 1)];
+  }
+
+  /**
+   * @brief Returns the number of interned names.
+   */
+  std::uint32_t size() const { return count.load(std::memory_order_acquire); }
+
+  /**
+   * @brief Returns the bytes of the names and the lookup table.
+   */
+  MemoryUsage memoryUsage() const;
+
+private:
+  static constexpr std::uint32_t chunkBits = 10;
+  static constexpr std::uint32_t chunkSize = 1u << chunkBits;
+  static constexpr std::uint32_t maxChunks = 4096; ///< Room for four million names
+
+  std::array<std::atomic<std::string *>, maxChunks> chunks{}; ///< Id -> name, chunkSize names per chunk
+  std::atomic<std::uint32_t> count{0};                        ///< Number of names
+  FlatHashMap<std::string_view, std::uint32_t, StringHash> lookup; ///< Name -> id, views into chunks
+  mutable std::mutex mutex;                                   ///< Guards lookup and interning
+};
@@ -0,0 +1,85 @@
+/**
+ * @file jsonArrayReader.hpp
+ * @brief Definition of the JsonArrayReader class.
+ *
+ * This file contains the chunked reader that splits a JSON array file into
+ * its top-level elements as it streams in, so they can be parsed before the
+ * whole file has been read.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @struct JsonChunk
+ * @brief Whole top-level elements of a JSON array, as read from the file.
+ */
+struct JsonChunk
+{
+  std::string text;                                ///< Elements back to back, with the separators between them
+  std::vector<std::pair<size_t, size_t>> elements; ///< [begin, end) of each element in text
+};
+
+/**
+ * @class JsonArrayReader
+ * @brief Reads a file holding one JSON array in chunks of whole elements.
+ *
+ * Each call to next() reads about chunkBytes more of the file and returns
+ * the elements it completes; the start of an element cut by the chunk
+ * boundary is kept for the next call. Only the structure is checked: the
+ * opening bracket, matching brackets and braces outside strings, exactly
+ * one comma between elements (none leading, doubled or trailing), and the
+ * closing bracket. The elements themselves are left to a JSON parser.
+ */
+
+class JsonArrayReader
+{
+public:
+  /**
+   * @brief Opens a file; check isOpen() before reading.
+   *
+   * @param [in] filename Path to the JSON file
+   * @param [in] chunkBytes Bytes read from the file per call to next()
+   */
+  JsonArrayReader(const std::string &filename, size_t chunkBytes);
+
+  bool isOpen() const { return file.is_open(); }
+
+  /**
+   * @brief Reads until at least one more element is complete.
+   *
+   * @param [out] out Completed elements, replacing its contents
+   * @return false at the end of the array, or on an error (see error())
+   */
+  bool next(JsonChunk &out);
+
+  const std::string &error() const { return failure; } ///< Why next() stopped early, or empty
+
+private:
+  std::ifstream file;
+  size_t chunkBytes;
+  std::string pending;    ///< Text read but not returned yet
+  size_t scanned = 0;     ///< Bytes of pending already scanned
+  size_t elementStart = 0; ///< Start of the element being scanned, when depth > 0
+  int depth = 0;          ///< Nesting depth inside the current element
+  bool started = false;   ///< Opening bracket seen
+  bool finished = false;  ///< Closing bracket seen
+  char last = 0;          ///< Last character between elements: '[', ',', or '}' for the end of an element
+  bool inString = false;
+  bool escaped = false;
+  size_t consumed = 0;    ///< File offset of pending[0], for error messages
+  std::string failure;
+
+  /**
+   * @brief Scans pending up to its end, recording completed elements.
+   *
+   * @param [out] out Receives the [begin, end) of each completed element
+   * @return false on a structural error
+   */
+  bool scan(std::vector<std::pair<size_t, size_t>> &out);
+};
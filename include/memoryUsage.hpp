@@ -0,0 +1,91 @@
+/**
+ * @file memoryUsage.hpp
+ * @brief Definition of the MemoryUsage struct and the MemoryReport class.
+ *
+ * This file contains the types used to account for the memory held by the
+ * catalog, its indexes and the pantry.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+class OutputSink;
+
+/**
+ * @struct MemoryUsage
+ * @brief Bytes held by one component.
+ *
+ * used counts the bytes that hold live data; reserved counts every byte the
+ * component has allocated, including spare capacity and garbage, and is never
+ * smaller than used.
+ */
+struct MemoryUsage
+{
+  size_t used = 0;     ///< Bytes holding live data
+  size_t reserved = 0; ///< Bytes allocated, live or not
+
+  MemoryUsage &operator+=(const MemoryUsage &other)
+  {
+    used += other.used;
+    reserved += other.reserved;
+    return *this;
+  }
+};
+
+/**
+ * @brief Returns the heap bytes owned by a string (zero while it fits in the small string buffer).
+ */
+inline size_t stringHeapBytes(const std::string &text)
+{
+  return text.capacity() > std::string().capacity() ? text.capacity() + 1 : 0;
+}
+
+/**
+ * @class MemoryReport
+ * @brief Named list of MemoryUsage entries, printable as a table or as JSON.
+ */
+class MemoryReport
+{
+public:
+  /**
+   * @brief Adds a component to the report.
+   *
+   * @param [in] component Name of the component (e.g. "instructions")
+   * @param [in] usage Bytes held by the component
+   */
+  void add(const std::string &component, const MemoryUsage &usage) { entries.emplace_back(component, usage); }
+
+  /**
+   * @brief Returns every component, in the order they were added.
+   */
+  const std::vector<std::pair<std::string, MemoryUsage>> &components() const { return entries; }
+
+  /**
+   * @brief Returns the sum of every component.
+   */
+  MemoryUsage total() const;
+
+  /**
+   * @brief Prints one line per component and the total.
+   *
+   * @param [in] out Sink to print to; it is not flushed
+   */
+  void print(OutputSink &out) const;
+
+  /**
+   * @brief Returns the report as a JSON document.
+   *
+   * Layout: {"components": [{"name", "usedBytes", "reservedBytes"}...],
+   * "total": {"usedBytes", "reservedBytes"}}.
+   *
+   * @return Indented JSON text
+   */
+  std::string toJson() const;
+
+private:
+  std::vector<std::pair<std::string, MemoryUsage>> entries;
+};
@@ -0,0 +1,102 @@
+/**
+ * @file mpscQueue.hpp
+ * @brief Definition of the MpscQueue class template.
+ *
+ * This file contains the unbounded lock-free queue that carries work from
+ * any number of producer threads to a single consumer thread.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+/**
+ * @class MpscQueue
+ * @brief Multi-producer, single-consumer FIFO queue (Vyukov).
+ *
+ * The queue is a singly linked list that producers append to by swapping
+ * themselves in as the head with one atomic exchange, then linking the
+ * previous head to their node. push() is therefore wait-free: it never
+ * retries and never waits for another thread, however many producers
+ * contend. The consumer pops from the tail without any atomic
+ * read-modify-write.
+ *
+ * Between a producer's exchange and its link, nodes pushed after it are not
+ * reachable yet, so the consumer may briefly see the queue as empty; it sees
+ * them once the link is stored. The link is stored sequentially consistent,
+ * so a consumer that announces it is going idle and then finds the queue
+ * empty cannot miss a producer that checks the announcement after pushing.
+ *
+ * Nodes are heap allocated, one per element.
+ *
+ * @tparam T Element type, default constructible and movable
+ */
+template <typename T>
+class MpscQueue
+{
+public:
+  MpscQueue()
+  {
+    Node *stub = new Node();
+    head.store(stub, std::memory_order_relaxed);
+    tail = stub;
+  }
+
+  ~MpscQueue()
+  {
+    T value;
+    while (pop(value))
+    {
+    }
+    delete tail;
+  }
+
+  MpscQueue(const MpscQueue &) = delete;
+  MpscQueue &operator=(const MpscQueue &) = delete;
+
+  /**
+   * @brief Appends an element; safe from any number of threads.
+   */
+  void push(T value)
+  {
+    Node *node = new Node();
+    node->value = std::move(value);
+    Node *previous = head.exchange(node, std::memory_order_acq_rel);
+    previous->next.store(node, std::memory_order_seq_cst);
+  }
+
+  /**
+   * @brief Removes the oldest element; consumer thread only.
+   *
+   * @param [out] out Element removed
+   * @return false if the queue is (momentarily) empty
+   */
+  bool pop(T &out)
+  {
+    Node *next = tail->next.load(std::memory_order_acquire);
+    if (next == nullptr)
+    {
+      return false;
+    }
+    out = std::move(next->value);
+    delete tail;
+    tail = next; // next becomes the stub; its value has been moved out
+    return true;
+  }
+
+  /**
+   * @brief Returns true if no element is reachable; consumer thread only.
+   */
+  bool empty() const { return tail->next.load(std::memory_order_seq_cst) == nullptr; }
+
+private:
+  struct Node
+  {
+    std::atomic<Node *> next{nullptr};
+    T value{};
+  };
+
+  alignas(64) std::atomic<Node *> head; ///< Last node pushed, swapped by producers
+  alignas(64) Node *tail;               ///< Stub before the oldest element, owned by the consumer
+};
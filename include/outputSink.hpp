@@ -0,0 +1,145 @@
+/**
+ * @file outputSink.hpp
+ * @brief Definition of the OutputSink class.
+ *
+ * This file contains the buffered writer used for console listings and
+ * query replies, which hands text to its stream in large blocks instead of
+ * one line at a time.
+ */
+
+#pragma once
+
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+/**
+ * @class OutputSink
+ * @brief Collects text in a large buffer and writes it to a stream in blocks.
+ *
+ * Text and numbers are appended with operator<< as on a std::ostream, but
+ * without a flush per line: the buffer goes to the stream when it is full
+ * and at explicit flush points (before reading input, at the end of a
+ * listing). Listing a million recipes then costs a few dozen writes instead
+ * of a million. Numbers are formatted with std::to_chars, with no locale or
+ * stream state; doubles print like a default std::ostream (6 significant
+ * digits).
+ *
+ * A sink is not thread-safe: one thread writes to it. Anything else writing
+ * to the same stream must wait for a flush, or its text may come out first.
+ */
+
+class OutputSink
+{
+public:
+  static constexpr size_t defaultCapacity = 1 << 16; ///< Bytes buffered between two writes to the stream
+
+  /**
+   * @brief Creates a sink that writes to a stream.
+   *
+   * @param [in] target Stream the text goes to; must outlive the sink
+   * @param [in] capacity Buffer size in bytes
+   */
+  explicit OutputSink(std::ostream &target, size_t capacity = defaultCapacity);
+
+  /**
+   * @brief Flushes what is left.
+   */
+  ~OutputSink();
+
+  OutputSink(const OutputSink &) = delete;
+  OutputSink &operator=(const OutputSink &) = delete;
+
+  /**
+   * @brief Returns the sink of std::cout used by the interactive menu.
+   *
+   * getIntegerInput() flushes it before reading, so prompts show up.
+   */
+  static OutputSink &console();
+
+  void write(const char *data, size_t size)
+  {
+    if (size > capacity - used)
+    {
+      writeLarge(data, size);
+      return;
+    }
+    std::memcpy(buffer.get() + used, data, size);
+    used += size;
+  }
+
+  OutputSink &operator<<(std::string_view text)
+  {
+    write(text.data(), text.size());
+    return *this;
+  }
+
+  OutputSink &operator<<(const char *text) { return *this << std::string_view(text); }
+  OutputSink &operator<<(const std::string &text) { return *this << std::string_view(text); }
+
+  OutputSink &operator<<(char c)
+  {
+    if (used == capacity)
+    {
+      drain();
+    }
+    buffer[used++] = c;
+    return *this;
+  }
+
+  template <typename T>
+    requires(std::is_integral_v<T> && !std::is_same_v<T, char> && !std::is_same_v<T, bool>)
+  OutputSink &operator<<(T value)
+  {
+    reserve(24);
+    used = static_cast<size_t>(std::to_chars(buffer.get() + used, buffer.get() + capacity, value).ptr - buffer.get());
+    return *this;
+  }
+
+  OutputSink &operator<<(double value);
+
+  /**
+   * @brief Appends text padded with spaces to a width.
+   *
+   * @param [in] text Text to append
+   * @param [in] width Minimum width
+   * @param [in] alignRight true to put the spaces first
+   */
+  void pad(std::string_view text, size_t width, bool alignRight);
+
+  /**
+   * @brief Writes the buffer to the stream and flushes the stream.
+   */
+  void flush();
+
+  size_t size() const { return used; } ///< Bytes buffered and not written yet
+
+private:
+  std::ostream &target;
+  size_t capacity;
+  std::unique_ptr<char[]> buffer;
+  size_t used = 0;
+
+  void reserve(size_t bytes)
+  {
+    if (capacity - used < bytes)
+    {
+      drain();
+    }
+  }
+
+  /**
+   * @brief Writes the buffer to the stream, without flushing the stream.
+   */
+  void drain();
+
+  /**
+   * @brief Writes text that does not fit in the buffer's free space.
+   */
+  void writeLarge(const char *data, size_t size);
+};
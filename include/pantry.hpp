@@ -0,0 +1,130 @@
+/**
+ * @file pantry.hpp
+ * @brief Definition of the Pantry class.
+ *
+ * This file contains the set of ingredients in stock, one per name, with the
+ * index and filter used to test whether an ingredient is in stock.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "cuckooFilter.hpp"
+#include "flatHashMap.hpp"
+#include "ingredient.hpp"
+#include "memoryUsage.hpp"
+
+/**
+ * @struct PantryFingerprint
+ * @brief 128-bit hash of the set of ingredient names in a pantry.
+ *
+ * The hash of a set is the sum of two independent 64-bit hashes of each
+ * name id, so it does not depend on insertion order and is updated in O(1)
+ * when a name is added or removed. Quantities and units are not part of it.
+ */
+struct PantryFingerprint
+{
+  std::uint64_t low = 0;
+  std::uint64_t high = 0;
+
+  bool operator==(const PantryFingerprint &other) const { return low == other.low && high == other.high; }
+  bool operator!=(const PantryFingerprint &other) const { return !(*this == other); }
+
+  void add(std::uint32_t nameId)
+  {
+    low += mix(nameId);
+    high += mix(nameId ^ 0x5BD1E995A3B8C4D7ull);
+  }
+
+  void remove(std::uint32_t nameId)
+  {
+    low -= mix(nameId);
+    high -= mix(nameId ^ 0x5BD1E995A3B8C4D7ull);
+  }
+
+private:
+  /**
+   * @brief splitmix64 finalizer.
+   */
+  static std::uint64_t mix(std::uint64_t x)
+  {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+  }
+};
+
+/**
+ * @class Pantry
+ * @brief Ingredients in stock, keyed by name id.
+ *
+ * RecipeManager publishes pantries as immutable versions: a change is made
+ * on a copy, which then replaces the published pantry.
+ */
+
+class Pantry
+{
+public:
+  /**
+   * @brief Makes room for a number of ingredients.
+   */
+  void reserve(size_t count);
+
+  /**
+   * @brief Inserts an ingredient or replaces the one with the same name.
+   *
+   * @param [in] ingredient Ingredient to store
+   * @return true if the ingredient was new, false if an existing one was replaced
+   */
+  bool put(const Ingredient &ingredient);
+
+  /**
+   * @brief Removes an ingredient in O(1).
+   *
+   * The last ingredient is moved into the freed position and the index is patched.
+   *
+   * @param [in] nameId Name id of the ingredient to remove
+   * @return true if the ingredient was in the pantry
+   */
+  bool remove(std::uint32_t nameId);
+
+  /**
+   * @brief Returns true if an ingredient is in the pantry.
+   *
+   * The filter answers most misses without touching the index. Once the
+   * filter outgrows maxFilterBytes it misses the cache as often as the index
+   * does and is skipped (see bench/cuckooFilterBench).
+   *
+   * @param [in] nameId Name id of the ingredient
+   */
+  bool contains(std::uint32_t nameId) const
+  {
+    bool useFilter = filter.slotCount() * sizeof(std::uint16_t) <= maxFilterBytes;
+    return (!useFilter || filter.contains(nameId)) && index.contains(nameId);
+  }
+
+  const std::vector<Ingredient> &items() const { return ingredients; } ///< Every ingredient, in no particular order
+  size_t size() const { return ingredients.size(); }                   ///< Number of ingredients
+  const PantryFingerprint &fingerprint() const { return names; }       ///< Hash of the set of names in the pantry
+
+  /**
+   * @brief Returns the bytes of the ingredients, the index and the filter.
+   */
+  MemoryUsage memoryUsage() const;
+
+private:
+  static constexpr size_t maxFilterBytes = 256 * 1024; ///< Largest filter worth consulting (about L2)
+
+  std::vector<Ingredient> ingredients;                 ///< The ingredients
+  FlatHashMap<std::uint32_t, std::uint32_t> index;     ///< Name id -> position in ingredients
+  CuckooFilter filter;                                 ///< Name ids in the pantry, checked before index
+  PantryFingerprint names;                             ///< Kept up to date by put() and remove()
+
+  /**
+   * @brief Refills the filter from the ingredients, with room for them to double.
+   */
+  void rebuildFilter();
+};
@@ -0,0 +1,125 @@
+/**
+ * @file pantryLog.hpp
+ * @brief Definition of the PantryLog class.
+ *
+ * This file contains the append-only write-ahead log used to persist the
+ * ingredients that are added to the pantry while the program runs.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "ingredient.hpp"
+#include "flatHashMap.hpp"
+
+/**
+ * @class PantryLog
+ * @brief Durable, append-only log of pantry mutations.
+ *
+ * Mutations are encoded as checksummed binary records and handed to a writer
+ * thread. The writer drains everything queued since its last pass with one
+ * write and one fsync (group commit), so callers never wait for the disk.
+ *
+ * On open() the last compacted snapshot is loaded and the log is replayed on
+ * top of it; a torn record at the end of the log (crash during a write) ends
+ * the replay. A batch that cannot be written or synced is cut off again by
+ * truncating the log back to the end of the previous batch, and the failure
+ * sticks: sync() returns false from then on. Once the log grows past the compaction threshold the writer
+ * thread writes a new snapshot, atomically renames it into place and
+ * truncates the log.
+ */
+
+class PantryLog
+{
+public:
+  /**
+   * @brief Kind of pantry mutation stored in a record.
+   */
+  enum class Op : std::uint8_t
+  {
+    Put = 1,   ///< Insert or replace an ingredient by name
+    Remove = 2 ///< Remove an ingredient by name
+  };
+
+  /**
+   * @brief Constructs a log over the given files.
+   *
+   * Nothing is read or written until open() is called.
+   *
+   * @param [in] logPath Path of the write-ahead log
+   * @param [in] snapshotPath Path of the compacted snapshot
+   * @param [in] compactThreshold Log size in bytes that triggers a compaction
+   */
+  PantryLog(const std::string &logPath,
+            const std::string &snapshotPath,
+            size_t compactThreshold = 64 * 1024);
+
+  /**
+   * @brief Flushes pending records and stops the writer thread.
+   */
+  ~PantryLog();
+
+  PantryLog(const PantryLog &) = delete;
+  PantryLog &operator=(const PantryLog &) = delete;
+
+  /**
+   * @brief Replays snapshot and log, then starts the writer thread.
+   *
+   * @param [out] out Ingredients persisted by previous runs, sorted by name
+   * @return false if the log file cannot be opened for writing
+   */
+  bool open(std::vector<Ingredient> &out);
+
+  /**
+   * @brief Queues a mutation for the next group commit.
+   *
+   * Returns immediately; use sync() to wait until the record is durable.
+   *
+   * @param [in] op Kind of mutation
+   * @param [in] ingredient Ingredient affected (only the name is used by Remove)
+   */
+  void append(Op op, const Ingredient &ingredient);
+
+  /**
+   * @brief Blocks until every record appended so far has been written.
+   *
+   * @return true if they are all on disk; false if the log failed to open or
+   *         any batch since open() could not be written or synced
+   */
+  bool sync();
+
+private:
+  std::string logPath;      ///< Write-ahead log file
+  std::string snapshotPath; ///< Compacted snapshot file
+  size_t compactThreshold;  ///< Log size that triggers compaction
+  int fd = -1;              ///< Log file descriptor
+  size_t logSize = 0;       ///< Current size of the log file
+
+  FlatHashMap<std::uint32_t, Ingredient> state; ///< Persisted pantry by name id, used for compaction (writer thread only)
+
+  std::mutex mutex;
+  std::condition_variable wakeWriter;
+  std::condition_variable committed;
+  std::vector<std::pair<Op, Ingredient>> pending; ///< Records waiting for the next group commit
+  std::uint64_t appendedSeq = 0;                  ///< Number of records appended
+  std::uint64_t processedSeq = 0;                 ///< Number of records the writer has handled, written or not
+  bool failed = false;                            ///< A batch was lost; sticky
+  bool stopping = false;
+  std::thread writer;
+
+  /**
+   * @brief Writer thread: commits batches and compacts the log.
+   */
+  void run();
+
+  /**
+   * @brief Writes the state mirror to a new snapshot and truncates the log.
+   */
+  void compact();
+};
@@ -0,0 +1,127 @@
+/**
+ * @file pantryUpdateQueue.hpp
+ * @brief Definition of the PantryUpdateQueue class.
+ *
+ * This file contains the ingestion path for pantry changes coming from many
+ * threads: a lock-free queue drained by one applier thread.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "ingredient.hpp"
+#include "mpscQueue.hpp"
+#include "pantryLog.hpp"
+
+/**
+ * @struct PantryUpdate
+ * @brief One pantry change: put (insert or replace by name) or remove.
+ */
+struct PantryUpdate
+{
+  PantryLog::Op op = PantryLog::Op::Put;
+  Ingredient ingredient; ///< Only the name is used by Remove
+};
+
+/**
+ * @struct PantryUpdateStats
+ * @brief Counters collected by a PantryUpdateQueue.
+ */
+struct PantryUpdateStats
+{
+  std::uint64_t submitted = 0; ///< Updates submitted by producers
+  std::uint64_t applied = 0;   ///< Updates handed to the applier after coalescing
+  std::uint64_t batches = 0;   ///< Batches applied
+};
+
+/**
+ * @class PantryUpdateQueue
+ * @brief Collects pantry updates from any thread and applies them in batches.
+ *
+ * Producers push onto an MpscQueue and return: a push is one atomic
+ * exchange, so producers never block, on each other or on the applier.
+ * The applier thread drains up to maxBatch updates at a time and coalesces
+ * them by ingredient name, keeping the last update for each: ten changes to
+ * the same ingredient cost one. The coalesced batch, in the order each name
+ * was first seen, is handed to the apply callback, which can then publish
+ * the whole batch at once instead of one pantry version per update.
+ *
+ * When the queue runs dry the applier announces that it is idle, checks the
+ * queue once more and sleeps. Only the producer that finds the announcement
+ * takes the mutex, briefly, to wake it.
+ */
+
+class PantryUpdateQueue
+{
+public:
+  using Apply = std::function<void(const std::vector<PantryUpdate> &batch)>; ///< Called from the applier thread
+
+  static constexpr size_t maxBatch = 4096; ///< Most updates drained into one batch
+
+  /**
+   * @brief Constructs a queue; nothing is applied until start() is called.
+   *
+   * @param [in] apply Callback invoked with every coalesced batch
+   */
+  explicit PantryUpdateQueue(Apply apply);
+
+  /**
+   * @brief Stops the applier after applying everything submitted.
+   */
+  ~PantryUpdateQueue();
+
+  PantryUpdateQueue(const PantryUpdateQueue &) = delete;
+  PantryUpdateQueue &operator=(const PantryUpdateQueue &) = delete;
+
+  /**
+   * @brief Starts the applier thread.
+   */
+  void start();
+
+  /**
+   * @brief Applies everything submitted so far, then stops the applier thread.
+   */
+  void stop();
+
+  /**
+   * @brief Queues an update; safe from any thread and never blocks.
+   *
+   * @param [in] update Change to apply
+   */
+  void submit(const PantryUpdate &update);
+
+  /**
+   * @brief Blocks until every update submitted so far has been applied.
+   */
+  void flush();
+
+  PantryUpdateStats stats() const;
+
+private:
+  Apply apply;
+  MpscQueue<PantryUpdate> queue;
+  std::atomic<std::uint64_t> submitted{0};
+  std::atomic<std::uint64_t> processed{0}; ///< Updates drained and applied, before coalescing
+  std::atomic<std::uint64_t> applied{0};
+  std::atomic<std::uint64_t> batches{0};
+  std::atomic<bool> idle{false};           ///< Set by the applier before it sleeps
+
+  std::mutex mutex;
+  std::condition_variable wake;     ///< The applier sleeps here
+  std::condition_variable drained;  ///< flush() waits here
+  bool running = false;
+  bool stopping = false;
+  std::thread applier;
+
+  /**
+   * @brief Applier thread: drains, coalesces and applies batches.
+   */
+  void run();
+};
@@ -0,0 +1,152 @@
+/**
+ * @file queryProtocol.hpp
+ * @brief Binary protocol spoken by QueryServer and its clients.
+ *
+ * This file contains the frame layout, the operation and status codes, and
+ * the helpers used to encode and decode frames on both sides.
+ *
+ * Every frame, request or reply, is a 9-byte header followed by a payload.
+ * Integers are little-endian (the server only accepts local clients):
+ *
+ *   u32 size    bytes after this field (5 + payload length)
+ *   u32 tag     chosen by the client, echoed in the reply
+ *   u8  code    Op in a request, Status in a reply
+ *
+ * Request payloads:
+ * - Available: empty; recipes that can be made with the server's pantry
+ * - Search: name text, matched as a case-insensitive substring
+ * - Detail: i32 recipe id
+ * - TenantAvailable: u64 tenant id; recipes that can be made with that
+ *   tenant's pantry (NotFound for an unknown tenant)
+ * - PantryPut: u16 length, name, i32 quantity in hundredths, u8 unit; puts
+ *   an ingredient in the server's pantry (BadRequest for a new name once
+ *   the server stops accepting new names)
+ * - PantryRemove: u16 length, name; removes an ingredient from the pantry
+ *   (NotFound for a name never seen)
+ *
+ * Reply payloads (Status::Ok):
+ * - Available, Search, TenantAvailable: u32 count, then count x (i32 id,
+ *   u16 length, name)
+ * - Detail: i32 id, u16 length, name, u16 ingredient count, then per
+ *   ingredient (u16 length, name, i32 quantity in hundredths, u8 unit),
+ *   then u32 length, instructions
+ * - PantryPut, PantryRemove: empty; the change is queued and visible to
+ *   queries shortly after. Pipelined changes may be handled in any order:
+ *   wait for the reply before sending a change that must follow another.
+ *
+ * Other statuses carry an empty payload. Clients may pipeline: send several
+ * requests without waiting. Replies can arrive in any order and are matched
+ * to their request by tag.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace QueryProtocol
+{
+  constexpr size_t headerBytes = 9;               ///< size, tag and code fields
+  constexpr std::uint32_t maxRequestBytes = 4096; ///< Largest request size field the server accepts
+
+  /**
+   * @brief Operation of a request.
+   */
+  enum class Op : std::uint8_t
+  {
+    Available = 1,
+    Search = 2,
+    Detail = 3,
+    TenantAvailable = 4,
+    PantryPut = 5,
+    PantryRemove = 6,
+  };
+
+  /**
+   * @brief Outcome of a request.
+   */
+  enum class Status : std::uint8_t
+  {
+    Ok = 0,
+    NotFound = 1,   ///< No recipe or tenant has the requested id
+    BadRequest = 2, ///< Unknown operation or malformed payload
+  };
+
+  inline void putU16(std::string &out, std::uint16_t value)
+  {
+    char bytes[2] = {static_cast<char>(value), static_cast<char>(value >> 8)};
+    out.append(bytes, 2);
+  }
+
+  inline void putU32(std::string &out, std::uint32_t value)
+  {
+    char bytes[4] = {static_cast<char>(value), static_cast<char>(value >> 8),
+                     static_cast<char>(value >> 16), static_cast<char>(value >> 24)};
+    out.append(bytes, 4);
+  }
+
+  inline void putI32(std::string &out, std::int32_t value) { putU32(out, static_cast<std::uint32_t>(value)); }
+
+  inline void putU64(std::string &out, std::uint64_t value)
+  {
+    putU32(out, static_cast<std::uint32_t>(value));
+    putU32(out, static_cast<std::uint32_t>(value >> 32));
+  }
+
+  /**
+   * @brief Appends a u16 length and the text, truncated to 65535 bytes.
+   */
+  inline void putShortString(std::string &out, std::string_view text)
+  {
+    size_t length = text.size() < 0xFFFF ? text.size() : 0xFFFF;
+    putU16(out, static_cast<std::uint16_t>(length));
+    out.append(text.data(), length);
+  }
+
+  inline std::uint16_t getU16(const char *p)
+  {
+    const unsigned char *b = reinterpret_cast<const unsigned char *>(p);
+    return static_cast<std::uint16_t>(b[0] | (b[1] << 8));
+  }
+
+  inline std::uint32_t getU32(const char *p)
+  {
+    const unsigned char *b = reinterpret_cast<const unsigned char *>(p);
+    return std::uint32_t(b[0]) | (std::uint32_t(b[1]) << 8) | (std::uint32_t(b[2]) << 16) | (std::uint32_t(b[3]) << 24);
+  }
+
+  inline std::int32_t getI32(const char *p) { return static_cast<std::int32_t>(getU32(p)); }
+
+  inline std::uint64_t getU64(const char *p) { return getU32(p) | (std::uint64_t(getU32(p + 4)) << 32); }
+
+  /**
+   * @brief Appends a frame header whose size is filled in by endFrame().
+   *
+   * @param [out] out Buffer to append to
+   * @param [in] tag Request tag
+   * @param [in] code Op or Status
+   * @return Offset of the frame in out, to pass to endFrame()
+   */
+  inline size_t beginFrame(std::string &out, std::uint32_t tag, std::uint8_t code)
+  {
+    size_t start = out.size();
+    putU32(out, 0);
+    putU32(out, tag);
+    out.push_back(static_cast<char>(code));
+    return start;
+  }
+
+  /**
+   * @brief Writes the size field of the frame started at an offset.
+   */
+  inline void endFrame(std::string &out, size_t start)
+  {
+    std::uint32_t size = static_cast<std::uint32_t>(out.size() - start - 4);
+    for (size_t i = 0; i < 4; ++i)
+    {
+      out[start + i] = static_cast<char>(size >> (8 * i));
+    }
+  }
+}
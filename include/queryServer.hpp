@@ -0,0 +1,165 @@
+/**
+ * @file queryServer.hpp
+ * @brief Definition of the QueryServer class.
+ *
+ * This file contains the local server that answers binary protocol requests
+ * (see queryProtocol.hpp) from many clients over a Unix domain socket.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+class RecipeManager;
+
+/**
+ * @class QueryServer
+ * @brief Event-driven query server with a worker pool.
+ *
+ * One thread runs an epoll loop over the listening socket and every client
+ * connection. It reads whatever bytes are available, cuts them into request
+ * frames and queues them for the workers, which answer through
+ * RecipeManager::answerRequest(). Finished replies are queued back to the
+ * loop, which is woken through an eventfd and writes them out, waiting for
+ * EPOLLOUT when a client reads slowly.
+ *
+ * Requests of one connection are answered concurrently, so a pipelining
+ * client gets its replies in completion order, matched by tag. A connection
+ * with maxInFlight requests pending is not read from until some are
+ * answered, which bounds the memory a fast writer can tie up.
+ *
+ * Linux only (epoll, eventfd); elsewhere listen() reports that the server
+ * is not supported.
+ */
+
+class QueryServer
+{
+public:
+  static constexpr size_t maxInFlight = 1024; ///< Pending requests per connection before reading pauses
+
+  /**
+   * @brief Creates a server for a manager; nothing runs until listen() and run().
+   *
+   * @param [in] manager Manager that answers the requests; must outlive the server
+   * @param [in] workers Number of worker threads, at least 1
+   */
+  QueryServer(RecipeManager &manager, size_t workers);
+
+  QueryServer(const QueryServer &) = delete;
+  QueryServer &operator=(const QueryServer &) = delete;
+
+  /**
+   * @brief Stops the workers and closes every socket.
+   */
+  ~QueryServer();
+
+  /**
+   * @brief Binds and listens on a Unix domain socket, replacing a stale socket file.
+   *
+   * @param [in] path Socket path
+   * @return false if the socket cannot be created
+   */
+  bool listen(const std::string &path);
+
+  /**
+   * @brief Runs the event loop on the calling thread until stop() is called.
+   */
+  void run();
+
+  /**
+   * @brief Makes run() return; safe to call from any thread or a signal handler.
+   */
+  void stop();
+
+private:
+  struct Connection
+  {
+    int fd = -1;
+    std::string input;     ///< Bytes read but not yet cut into frames
+    std::string output;    ///< Replies not yet written
+    size_t outputSent = 0; ///< Bytes of output already written
+    size_t inFlight = 0;   ///< Requests queued or being answered
+    bool reading = true;   ///< EPOLLIN enabled
+    bool writing = false;  ///< EPOLLOUT enabled
+  };
+
+  struct Job
+  {
+    std::uint64_t connection; ///< Connection id, not the fd: fds are reused
+    std::string request;      ///< Whole request frame
+  };
+
+  struct Reply
+  {
+    std::uint64_t connection;
+    std::string frame;
+  };
+
+  RecipeManager &manager;
+  std::string socketPath;
+  int listenFd = -1;
+  int epollFd = -1;
+  int wakeFd = -1;                   ///< eventfd: replies ready or stop requested
+  std::atomic<bool> stopping{false}; ///< Set by stop(), read by run() after a wakeup
+  std::uint64_t nextConnection = 1;
+  std::unordered_map<std::uint64_t, Connection> connections; ///< Owned by the loop thread
+  std::unique_ptr<char[]> readBuffer;                        ///< Every read lands here first; loop thread only
+
+  std::mutex jobsMutex;
+  std::condition_variable jobsReady;
+  std::deque<Job> jobs;
+  bool workersDone = false;
+  std::vector<std::thread> workers;
+
+  std::mutex repliesMutex;
+  std::vector<Reply> replies;    ///< Answered by workers, not yet handed to connections
+  std::vector<Reply> delivering; ///< Replies being handed out by the loop, reused
+
+  /**
+   * @brief Worker thread: answers queued requests until the server is destroyed.
+   */
+  void work();
+
+  /**
+   * @brief Accepts every pending connection.
+   */
+  void accept();
+
+  /**
+   * @brief Reads available bytes and queues the complete request frames.
+   *
+   * @return false if the connection was closed
+   */
+  bool readFrom(std::uint64_t id, Connection &connection);
+
+  /**
+   * @brief Writes pending replies until done or the socket is full.
+   *
+   * @return false if the connection was closed
+   */
+  bool writeTo(std::uint64_t id, Connection &connection);
+
+  /**
+   * @brief Moves the workers' replies to their connections and writes them.
+   */
+  void deliverReplies();
+
+  /**
+   * @brief Applies the connection's reading and writing flags to epoll.
+   */
+  void updateEvents(std::uint64_t id, const Connection &connection);
+
+  /**
+   * @brief Closes a connection; replies still being computed for it are dropped.
+   */
+  void disconnect(std::uint64_t id);
+};
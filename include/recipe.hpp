@@ -11,6 +11,7 @@
 #include <vector>
 #include <string>
 #include "ingredient.hpp"
+#include "memoryUsage.hpp"
 
 /**
  * @class Recipe
@@ -18,6 +19,9 @@
  *
  * The Recipe class stores all relevant information about a recipe,
  * including its unique identifier, name, list of ingredients, and step-by-step instructions.
+ *
+ * Recipe is the value type produced by parsing; once loaded, RecipeManager
+ * keeps the catalog in a columnar RecipeStore instead.
  */
 
 class Recipe
@@ -50,4 +54,9 @@ public:
    * Cleans up any resources used by the Recipe object.
    */
   ~Recipe();
+
+  /**
+   * @brief Returns the bytes of the object, its strings and its ingredient list.
+   */
+  MemoryUsage memoryUsage() const;
 };
\ No newline at end of file
@@ -0,0 +1,102 @@
+/**
+ * @file recipeCatalog.hpp
+ * @brief Definition of the RecipeCatalog class.
+ *
+ * This file contains one version of the recipe catalog: the columnar store,
+ * its id index and the codec of its instructions.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include "catalogImage.hpp"
+#include "idIndex.hpp"
+#include "memoryUsage.hpp"
+#include "recipe.hpp"
+#include "recipeStore.hpp"
+#include "textCodec.hpp"
+
+/**
+ * @class RecipeCatalog
+ * @brief A recipe catalog that is immutable once published.
+ *
+ * RecipeManager builds a new catalog for every load or reload, starting
+ * from a copy of the published one, and swaps it in. The copy shares the
+ * store pages and id index chunks of the published catalog and copies only
+ * those it writes, so a version costs time and memory proportional to its
+ * changes. Pages written by a version live in the monotonic arena of its
+ * store; once the arenas pinned by shared pages hold more than about three
+ * times what the pages use, the next copy is a compacted one instead. The codec
+ * and a shared catalog image are shared between versions.
+ */
+
+class RecipeCatalog
+{
+public:
+  /**
+   * @brief Creates an empty catalog whose store arena takes its blocks from upstream.
+   *
+   * @param [in] upstream Resource the arena blocks come from
+   */
+  explicit RecipeCatalog(std::pmr::memory_resource *upstream);
+
+  RecipeCatalog(const RecipeCatalog &) = delete;
+  RecipeCatalog &operator=(const RecipeCatalog &) = delete;
+
+  const std::uint64_t version;               ///< Unique per catalog object in the process, never reused
+  std::shared_ptr<const CatalogImage> image; ///< Shared image the store is attached to, if any
+  RecipeStore store;                         ///< Columnar recipes (paged, or attached to image)
+  IdIndex recipeIndex;                       ///< Recipe id -> slot in store
+  std::shared_ptr<const TextCodec> codec;    ///< Dictionary the stored instructions are compressed with
+  double loadMilliseconds = 0;               ///< Duration of the last full load
+  size_t loadAllocations = 0;                ///< Arena allocations made by the last full load
+
+  /**
+   * @brief Copies another catalog into this empty one, sharing its storage.
+   *
+   * The store pages and the id index chunks are shared; the store is copied
+   * compacted instead when its arenas hold more than about three times the
+   * bytes of its pages. Slots keep their order either way, so the id index stays
+   * valid. The codec and the load statistics are carried over.
+   *
+   * @param [in] other Catalog to copy; must not be attached to an image
+   */
+  void copyFrom(const RecipeCatalog &other);
+
+  /**
+   * @brief Appends a recipe and indexes its id.
+   *
+   * @param [in] recipe Recipe with encoded instructions and an id not in the catalog
+   */
+  void add(const Recipe &recipe);
+
+  /**
+   * @brief Removes the recipe in a slot in O(1).
+   *
+   * The last recipe is moved into the freed slot and recipeIndex is patched.
+   *
+   * @param [in] slot Slot of the recipe to remove
+   */
+  void erase(std::uint32_t slot);
+
+  /**
+   * @brief Returns the counters of the allocations served by the store's arena.
+   */
+  AllocationStats arenaStats() const { return store.arenaStats(); }
+
+  /**
+   * @brief Returns the counters of the blocks the store's arena took upstream.
+   */
+  AllocationStats blockStats() const { return store.blockStats(); }
+
+  /**
+   * @brief Adds the store columns, the image, the codec, the id index and the
+   * arena overhead to a report.
+   *
+   * @param [out] report Report to add to
+   */
+  void memoryUsage(MemoryReport &report) const;
+};
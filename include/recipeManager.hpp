@@ -11,8 +11,34 @@
 
 #include <vector>
 #include <string>
+#include <iosfwd>
+#include <atomic>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
 #include "recipe.hpp"
+#include "recipeCatalog.hpp"
+#include "pantry.hpp"
+#include "availabilityCache.hpp"
+#include "tenantPantryStore.hpp"
+#include "pantryUpdateQueue.hpp"
+#include "asyncTask.hpp"
+#include "jsonArrayReader.hpp"
+#include "epochDomain.hpp"
+#include "flatHashMap.hpp"
 #include "ingredient.hpp"
+#include "textCodec.hpp"
+#include "hugePageResource.hpp"
+#include "memoryUsage.hpp"
+#include "outputSink.hpp"
+#include "resultWriter.hpp"
+#include "queryProtocol.hpp"
+
+class FileWatcher;
+class PantryLog;
 
 /**
  * @class RecipeManager
@@ -20,15 +46,261 @@
  *
  * This class allows users to load, view, and interact with recipes and their ingredients.
  * It maintains internal lists of available recipes and ingredients.
+ *
+ * The catalog and the pantry are published as one immutable snapshot behind
+ * an atomic pointer. Queries pin the snapshot with one load and never take a
+ * lock, so they never wait for a load or a hot reload (see startWatching()).
+ * Writers build a new catalog or pantry off to the side, under a mutex that
+ * only writers take, and swap in a new snapshot; the old one is freed by an
+ * EpochDomain once no query can still be reading it.
  */
 
 class RecipeManager
 {
 private:
-  std::vector<Recipe> recipes;               ///< Collection of all loaded recipes
-  std::vector<SimpleIngredient> ingredients; ///< Collection of all loaded ingredients
+  /**
+   * @brief One published version of the catalog and the pantry.
+   *
+   * Both parts are reference counted, so a snapshot that changes only the
+   * pantry shares the catalog with the previous one. Queries read through
+   * the raw snapshot pointer and never touch the reference counts.
+   */
+  struct Snapshot
+  {
+    std::shared_ptr<const RecipeCatalog> catalog;
+    std::shared_ptr<const Pantry> pantry;
+  };
+
+  /**
+   * @brief A snapshot pinned for the length of a query.
+   */
+  class PinnedSnapshot
+  {
+  public:
+    PinnedSnapshot(EpochDomain &epochs, const std::atomic<const Snapshot *> &current)
+        : guard(epochs.pin()), snapshot(current.load())
+    {
+    }
+    const RecipeCatalog &catalog() const { return *snapshot->catalog; }
+    const Pantry &pantry() const { return *snapshot->pantry; }
+
+  private:
+    EpochDomain::Guard guard;  ///< Declared first: pinned before the load
+    const Snapshot *snapshot;
+  };
+
+  HugePageResource hugePages;                     ///< Huge-page backing for large bulk arrays
+  std::pmr::memory_resource *bulkResource;        ///< hugePages if enabled, the heap otherwise
+  mutable EpochDomain epochs;                     ///< Frees snapshots once no query reads them
+  std::atomic<const Snapshot *> current{nullptr}; ///< Published snapshot, never null after construction
+  std::unordered_map<std::string, FlatHashMap<std::uint32_t, Ingredient>>
+      fileIngredients;                            ///< Ingredients last loaded from each file, by name id
+  std::unordered_map<std::string, std::unordered_set<int>>
+      fileRecipes;                                ///< Recipe ids contributed by each file
+  mutable std::mutex mutex;                       ///< Serializes writers and guards the members above; queries never take it
+  std::unique_ptr<FileWatcher> watcher;           ///< Background hot reload watcher
+  std::unique_ptr<PantryLog> pantryLog;           ///< Write-ahead log of manual pantry changes
+  mutable AvailabilityCache availability{256};    ///< Recent availability results, cleared when the catalog changes
+  TenantPantryStore tenants;                      ///< Per-household pantries, queried against the published catalog
+  std::unique_ptr<PantryUpdateQueue> updates;     ///< Pantry changes submitted from any thread, applied in batches
+  AsyncJob recipeLoad;                            ///< Background load started by startLoadingRecipes()
+  std::atomic<bool> cancelLoad{false};            ///< Set by the destructor to cut a background load short
+  std::atomic<std::uint32_t> requestNames{0};     ///< Ingredient names added to the dictionary by answerRequest()
+
+  static constexpr std::uint32_t maxRequestNames = 65536; ///< Names socket clients may add over the process lifetime
+
+  /**
+   * @brief Parses a JSON recipe file without touching the loaded catalog.
+   *
+   * @param [in] filename Path to the JSON file
+   * @param [out] out Parsed recipes, in file order
+   * @return false if the file cannot be opened or is not valid JSON
+   */
+  static bool parseRecipesFile(const std::string &filename, std::vector<Recipe> &out);
+
+  /**
+   * @brief Reads the "name, quantity, unit" records of an ingredients file.
+   *
+   * Invalid lines are reported with their line number and skipped.
+   *
+   * @param [in] filename Path to the input file
+   * @param [out] out Parsed ingredients, in file order
+   * @return false if the file cannot be opened
+   */
+  static bool parseIngredientsFile(const std::string &filename, std::vector<Ingredient> &out);
+
+  /**
+   * @brief Pins the published snapshot for a query.
+   */
+  PinnedSnapshot pin() const { return PinnedSnapshot(epochs, current); }
+
+  /**
+   * @brief Returns the published snapshot to a writer.
+   *
+   * Must be called with the mutex held, which keeps the snapshot from being
+   * replaced and freed.
+   */
+  const Snapshot &latest() const { return *current.load(std::memory_order_acquire); }
+
+  /**
+   * @brief Publishes a new snapshot and retires the previous one.
+   *
+   * Must be called with the mutex held.
+   *
+   * @param [in] catalog Catalog of the new snapshot
+   * @param [in] pantry Pantry of the new snapshot
+   */
+  void swapSnapshot(std::shared_ptr<const RecipeCatalog> catalog, std::shared_ptr<const Pantry> pantry);
+
+  /**
+   * @brief Starts the next catalog as a copy of the published one that shares its pages.
+   *
+   * Must be called with the mutex held.
+   *
+   * @return Catalog to modify and pass to swapSnapshot()
+   */
+  std::shared_ptr<RecipeCatalog> copyCatalog() const;
+
+  /**
+   * @brief Appends parsed recipes, reporting and skipping ids already loaded.
+   *
+   * Must be called with the mutex held.
+   *
+   * @param [in] filename File the recipes were read from
+   * @param [in] parsed Recipes to append (moved from)
+   * @param [out] catalog Unpublished catalog to append to
+   * @return Number of recipes actually added
+   */
+  size_t mergeRecipes(const std::string &filename, std::vector<Recipe> &parsed, RecipeCatalog &catalog);
+
+  /**
+   * @brief Trains the instruction codec if it has not been trained yet.
+   *
+   * Runs once, on the first recipes loaded into an empty catalog; later
+   * loads are encoded with the same dictionary, or stored raw if the first
+   * load left the codec untrained.
+   *
+   * @param [in] corpus Raw instructions to learn from
+   * @param [out] catalog Unpublished catalog that receives the trained codec
+   */
+  static void trainInstructionCodec(const std::vector<std::string_view> &corpus, RecipeCatalog &catalog);
+
+  /**
+   * @brief Reads, parses and indexes a recipe file as a pipeline on the shared TaskScheduler.
+   *
+   * Takes the writer lock only while indexing each chunk.
+   *
+   * @param [in] filename Path to the JSON file, already registered in fileRecipes
+   * @param [in] reader Reader opened on the file
+   */
+  AsyncTask<> streamRecipes(std::string filename, JsonArrayReader reader);
+
+  /**
+   * @brief Prints the name, ingredients and decoded instructions of a recipe.
+   *
+   * @param [in] recipe Recipe to print
+   * @param [in] codec Codec of the catalog the recipe belongs to
+   * @param [in] out Sink to print to; it is not flushed
+   */
+  static void printRecipe(RecipeView recipe, const TextCodec &codec, OutputSink &out);
+
+  /**
+   * @brief Collects the slots of the recipes that can be made with the pantry.
+   *
+   * @param [in] store Catalog to scan
+   * @param [in] pantry Pantry to check against
+   * @param [out] slots Slots of the available recipes, in store order (cleared first)
+   */
+  static void findAvailableRecipes(const RecipeStore &store, const Pantry &pantry, std::vector<std::uint32_t> &slots);
+
+  /**
+   * @brief Collects the slots of the recipes that can be made with a tenant's pantry.
+   *
+   * @param [in] store Catalog to scan
+   * @param [in] pantry Tenant pantry to check against
+   * @param [out] slots Slots of the available recipes, in store order (cleared first)
+   */
+  static void findAvailableRecipes(const RecipeStore &store, const TenantPantry &pantry,
+                                   std::vector<std::uint32_t> &slots);
+
+  /**
+   * @brief findAvailableRecipes(), answered from the availability cache when possible.
+   *
+   * @tparam AnyPantry Pantry or TenantPantry
+   * @param [in] catalog Pinned catalog to query
+   * @param [in] pantry Pantry to check against
+   * @param [out] slots Slots of the available recipes, in store order (cleared first)
+   */
+  template <typename AnyPantry>
+  void availableRecipes(const RecipeCatalog &catalog, const AnyPantry &pantry, std::vector<std::uint32_t> &slots) const;
+
+  /**
+   * @brief Collects the slots of the recipes whose name contains a text, ignoring case.
+   *
+   * @param [in] store Catalog to scan
+   * @param [in] text Text to find
+   * @param [out] slots Slots of the matching recipes, in store order (cleared first)
+   */
+  static void findRecipesByName(const RecipeStore &store, std::string_view text, std::vector<std::uint32_t> &slots);
+
+  /**
+   * @brief Answers one query of runQueries().
+   *
+   * @param [in] command First word of the query
+   * @param [in] argument Rest of the query, trimmed
+   * @param [in] writer Writer of the reply
+   * @param [in] slots Scratch buffer reused across queries
+   * @param [in,out] pending Additions not applied yet; "add" appends to it
+   */
+  void answerQuery(std::string_view command, std::string_view argument, ResultWriter &writer,
+                   std::vector<std::uint32_t> &slots, std::vector<PantryUpdate> &pending);
+
+  /**
+   * @brief Answers a "tenant <id> <verb> [argument]" query of runQueries().
+   *
+   * @param [in] argument Everything after "tenant", trimmed
+   * @param [in] writer Writer of the reply
+   * @param [in] slots Scratch buffer reused across queries
+   */
+  void answerTenantQuery(std::string_view argument, ResultWriter &writer, std::vector<std::uint32_t> &slots);
+
+  /**
+   * @brief Applies a coalesced batch of pantry updates as one new snapshot.
+   *
+   * Called from the update queue's applier thread, and by runQueries() and
+   * the menu for the edits they collect. The batch is also appended to the
+   * pantry log, if one is open.
+   *
+   * @param [in] batch Updates, applied in order; a later one for the same name wins
+   */
+  void applyPantryUpdates(const std::vector<PantryUpdate> &batch);
+
+  /**
+   * @brief Tells whether an ingredient is in the pantry once pending edits are applied.
+   *
+   * @param [in] pending Edits not applied yet, in order
+   * @param [in] nameId Name of the ingredient
+   * @return true if the last pending edit of the name is a put, or, without one, if the published pantry has it
+   */
+  bool inPantry(const std::vector<PantryUpdate> &pending, std::uint32_t nameId);
 
 public:
+  /**
+   * @brief Creates a manager and publishes an empty snapshot.
+   *
+   * Every catalog version writes its pages to a monotonic arena of its own. With huge pages enabled, arena blocks of 2 MiB or more are mapped on
+   * huge pages (see HugePageResource), which cuts TLB misses on catalogs of
+   * millions of ingredient entries.
+   *
+   * @param [in] useHugePages true to back large bulk arrays with huge pages
+   */
+  explicit RecipeManager(bool useHugePages = false);
+
+  /**
+   * @brief Applies pending pantry updates, stops the file watcher, if any, and frees every snapshot.
+   */
+  ~RecipeManager();
+
   /**
    * @brief Loads ingredients from a text file.
    *
@@ -38,13 +310,34 @@ public:
    */
   void loadIngredientsFromFile(const std::string &filename);
 
+  /**
+   * @brief Restores manually added ingredients and starts persisting new ones.
+   *
+   * Loads the last compacted snapshot, replays the write-ahead log on top of
+   * it and merges the result into the pantry. From then on every ingredient
+   * added with manuallyAddIngredients() is appended to the log.
+   *
+   * @param [in] logFile Path to the write-ahead log
+   * @param [in] snapshotFile Path to the compacted snapshot
+   */
+  void openPantryLog(const std::string &logFile, const std::string &snapshotFile);
+
   /**
    * @brief Allows the user to manually add ingredients via console input.
    *
-   * Prompts the user to enter ingredient details until they choose to stop.
+   * Prompts the user to enter ingredient details until they choose to stop;
+   * the additions are then published together as one pantry snapshot.
    */
   void manuallyAddIngredients();
 
+  /**
+   * @brief Asks for ingredient names and removes them from the pantry.
+   *
+   * Used when ingredients are consumed. Removals are published together
+   * when the user stops and written to the pantry log like additions.
+   */
+  void removeIngredients();
+
   /**
    * @brief Displays all currently stored ingredients.
    *
@@ -56,11 +349,106 @@ public:
    * @brief Loads recipes from a JSON file.
    *
    * Parses a JSON file containing recipe data and adds them to the internal list.
+   * Same as startLoadingRecipes() followed by waitForRecipes().
    *
    * @param [in] filename Path to the JSON file
    */
   void loadRecipesFromJson(const std::string &filename);
 
+  /**
+   * @brief Starts loading a JSON recipe file in the background and returns at once.
+   *
+   * The file is streamed in chunks: reading, parsing and indexing overlap,
+   * and the catalog is published as it grows, so queries and the menu work
+   * (on the recipes indexed so far) while the load runs. Other recipe loads
+   * and reloads wait for it to finish; pantry changes do not.
+   *
+   * @param [in] filename Path to the JSON file
+   */
+  void startLoadingRecipes(const std::string &filename);
+
+  /**
+   * @brief Blocks until the recipe load started last is done; returns at once if none is running.
+   */
+  void waitForRecipes() { recipeLoad.wait(); }
+
+  /**
+   * @brief Returns true while a recipe load started by startLoadingRecipes() is running.
+   */
+  bool loadingRecipes() const { return recipeLoad.busy(); }
+
+  /**
+   * @brief Loads many recipe files concurrently.
+   *
+   * The path is either a directory, searched recursively for *.json files, or
+   * a manifest listing one recipe file per line (relative paths are resolved
+   * against the manifest's directory, lines starting with '#' are ignored).
+   * Duplicate ids are reported and the first file listed wins. Load time is
+   * reported per file.
+   *
+   * @param [in] path Manifest file or directory
+   */
+  void loadRecipesFromManifest(const std::string &path);
+
+  /**
+   * @brief Publishes the loaded catalog as a shared-memory image.
+   *
+   * Other processes can then call attachCatalog() with the same name instead
+   * of loading the recipe files. The image is a snapshot: later reloads are
+   * not published until this is called again, and neither are recipes a
+   * background load has not indexed yet (see waitForRecipes()).
+   *
+   * @param [in] name Shared memory object name (e.g. "/virtualchef")
+   * @return true if the image was published
+   */
+  bool publishCatalog(const std::string &name) const;
+
+  /**
+   * @brief Uses a catalog image published by another process, read-only.
+   *
+   * Must be called before any ingredient or recipe is loaded, since the
+   * image's ingredient ids have to match this process's dictionary. Once
+   * attached, recipe files can no longer be loaded or reloaded; the pantry
+   * works as usual.
+   *
+   * @param [in] name Shared memory object name given to publishCatalog()
+   * @return true if the catalog was attached
+   */
+  bool attachCatalog(const std::string &name);
+
+  /**
+   * @brief Re-reads a JSON recipe file and applies only what changed.
+   *
+   * Recipes are matched by id against the ones this file contributed. New ids
+   * are added, ids missing from the file are removed and recipes whose contents
+   * differ are replaced. Unchanged recipes, and recipes loaded from other
+   * files, are kept. The changes are applied to a copy of the catalog that
+   * replaces it as a whole, so queries see either the old or the new file.
+   *
+   * @param [in] filename Path to the JSON file
+   */
+  void reloadRecipesFromJson(const std::string &filename);
+
+  /**
+   * @brief Re-reads an ingredients file and applies only what changed.
+   *
+   * Names that disappeared from the file since it was last loaded are removed
+   * from the pantry, new names are added and entries whose quantity or unit
+   * changed are updated. Manually added ingredients are kept.
+   *
+   * @param [in] filename Path to the input file
+   */
+  void reloadIngredientsFromFile(const std::string &filename);
+
+  /**
+   * @brief Starts watching the data files and hot reloads them on change.
+   *
+   * Watches the ingredients file and every recipe file loaded so far.
+   *
+   * @param [in] ingredientsFile Path to the ingredients file
+   */
+  void startWatching(const std::string &ingredientsFile);
+
   /**
    * @brief Displays all loaded recipes.
    *
@@ -81,4 +469,129 @@ public:
    * Prompts the user to choose a recipe by ID and simulates its selection process.
    */
   void selectRecipe();
+
+  /**
+   * @brief Looks a recipe up by its external id in O(1).
+   *
+   * @param [in] id Recipe id, as written in the JSON files
+   * @return A copy of the recipe with decoded instructions, or std::nullopt if no recipe has that id
+   */
+  std::optional<Recipe> findRecipeById(int id) const;
+
+  /**
+   * @brief Asks for a recipe id and displays that recipe.
+   *
+   * Unlike selectRecipe(), the catalog is not listed; the id is resolved
+   * directly through the id index.
+   */
+  void selectRecipeById() const;
+
+  /**
+   * @brief Answers queries read line by line, for headless use.
+   *
+   * One query per line; blank lines and lines starting with '#' are skipped:
+   * - "available": recipes that can be made with the pantry
+   * - "search <text>": recipes whose name contains the text, ignoring case
+   * - "recipe <id>": one recipe with its ingredients and instructions
+   * - "pantry": every ingredient in the pantry
+   * - "add <name>, <quantity>, <unit>": puts an ingredient in the pantry;
+   *   consecutive adds are published as one pantry snapshot, before the
+   *   next other query
+   * - "starter <name> <ingredient>, ...": defines a starter pantry for tenants
+   * - "tenant <id> new [starter]", "tenant <id> add <ingredient>",
+   *   "tenant <id> remove <ingredient>", "tenant <id> drop": edit a tenant's pantry
+   * - "tenant <id> available": recipes that can be made with the tenant's pantry
+   *
+   * In the text format every reply is either "OK <n>" followed by n
+   * tab-separated lines, or a single "ERR <message>" line; backslashes, tabs
+   * and line breaks inside fields are escaped as "\\", "\t", "\n" and "\r".
+   * See ResultWriter for JSON and CSV. Replies collect in an OutputSink and
+   * reach the stream in large blocks; it is flushed once, after the last
+   * query. Each query reads the snapshot published when it starts.
+   *
+   * @param [in] in Queries
+   * @param [in] out Stream the replies are written to
+   * @param [in] format Encoding of the replies
+   * @return Number of queries answered
+   */
+  size_t runQueries(std::istream &in, std::ostream &out, ResultFormat format = ResultFormat::Text);
+
+  /**
+   * @brief Answers one request of the binary query protocol.
+   *
+   * Used by QueryServer workers; safe to call from any number of threads,
+   * each call reading the snapshot published when it starts. Pantry updates
+   * are queued with submitPantryUpdate() and acknowledged before they are
+   * applied.
+   *
+   * Interned names are never freed, so a put of a name the dictionary does
+   * not know yet is refused with Status::BadRequest once clients have added
+   * maxRequestNames names, or once the dictionary is full.
+   *
+   * @param [in] op Operation code of the request (QueryProtocol::Op)
+   * @param [in] payload Request payload
+   * @param [out] out Buffer the reply payload is appended to
+   * @return Status of the reply; nothing is appended unless it is Status::Ok
+   */
+  QueryProtocol::Status answerRequest(std::uint8_t op, std::string_view payload, std::string &out);
+
+  /**
+   * @brief Queues a pantry change; safe from any thread and never blocks.
+   *
+   * The change is applied shortly after, together with the others queued
+   * meanwhile, and is visible to queries from then on.
+   *
+   * @param [in] update Change to apply
+   */
+  void submitPantryUpdate(const PantryUpdate &update) { updates->submit(update); }
+
+  /**
+   * @brief Blocks until every pantry change submitted so far is applied.
+   */
+  void flushPantryUpdates() { updates->flush(); }
+
+  /**
+   * @brief Returns the submitted, applied and batch counters of the pantry update queue.
+   */
+  PantryUpdateStats pantryUpdateStats() const { return updates->stats(); }
+
+  /**
+   * @brief Returns the pantries of the tenants (households) served next to the process pantry.
+   *
+   * Tenant pantries hold ingredient name ids from IngredientDictionary::shared()
+   * and are queried against the same published catalog.
+   */
+  TenantPantryStore &tenantPantries() { return tenants; }
+
+  /**
+   * @brief Displays how much memory the catalog text uses.
+   *
+   * Compares the compressed instruction storage with plain std::string
+   * storage, both in bytes and in the time needed to read every instruction.
+   */
+  void showStorageReport() const;
+
+  /**
+   * @brief Returns the bytes held by the catalog, its indexes and the pantry.
+   *
+   * Components: recipe columns, ingredient arrays, names, instructions,
+   * instruction dictionary, recipe id index, ingredient dictionary, pantry,
+   * reload bookkeeping and catalog arena overhead. An attached catalog is
+   * reported as one shared catalog image component instead of the columns.
+   *
+   * @return Report with one entry per component
+   */
+  MemoryReport memoryUsage() const;
+
+  /**
+   * @brief Returns the hit, miss and eviction counters of the availability cache.
+   */
+  AvailabilityCacheStats availabilityCacheStats() const { return availability.stats(); }
+
+  /**
+   * @brief Prints memoryUsage() and offers to save it as JSON.
+   *
+   * @param [in] jsonFile Path the JSON report is written to
+   */
+  void showMemoryUsage(const std::string &jsonFile) const;
 };
\ No newline at end of file
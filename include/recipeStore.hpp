@@ -0,0 +1,365 @@
+/**
+ * @file recipeStore.hpp
+ * @brief Definition of the RecipeStore and RecipeView classes.
+ *
+ * This file contains the columnar (structure-of-arrays) storage used by
+ * RecipeManager for the recipe catalog, and the lightweight view used to
+ * read one recipe back.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <string_view>
+#include <vector>
+#include "countingResource.hpp"
+#include "ingredient.hpp"
+#include "recipe.hpp"
+#include "memoryUsage.hpp"
+
+class RecipeView;
+
+/**
+ * @brief Returns the bit an ingredient sets in a 64-bit ingredient signature.
+ *
+ * A signature ORs the bits of a set of ingredients, like a one-word Bloom
+ * filter. If a recipe's signature has a bit the pantry's signature lacks, the
+ * pantry is missing one of its ingredients; the converse does not hold.
+ *
+ * @param [in] nameId Dictionary id of the ingredient name
+ */
+inline std::uint64_t signatureBit(std::uint32_t nameId)
+{
+  return std::uint64_t(1) << ((nameId * 0x9E3779B9u) >> 26);
+}
+
+/**
+ * @struct IngredientRange
+ * @brief Contiguous range of the required ingredients of one recipe.
+ */
+struct IngredientRange
+{
+  const Ingredient *first; ///< First ingredient
+  const Ingredient *last;  ///< One past the last ingredient
+
+  const Ingredient *begin() const { return first; }
+  const Ingredient *end() const { return last; }
+  size_t size() const { return static_cast<size_t>(last - first); }
+};
+
+/**
+ * @class RecipeStore
+ * @brief Columnar storage for the recipe catalog.
+ *
+ * Hot data used by scans lives in parallel columns indexed by slot: id,
+ * ingredient signature, ingredient offset and ingredient count. The
+ * ingredients of every recipe are stored back to back in one flat array of
+ * packed Ingredient records addressed by the ingredient offset and count.
+ * Availability scans test the signature first and only read the ingredient
+ * records of recipes it cannot rule out. Cold data, read only to print a
+ * recipe, lives apart: names and instructions in a text pool, reached
+ * through the name offset and text length columns.
+ *
+ * The columns are cut into pages of pageSlots slots, each page holding its
+ * own ingredient array and text pool. Copying a store with shareTo() shares
+ * every page; a write to a page another store still holds copies that page,
+ * compacted, first. A catalog version that changes a few recipes therefore
+ * copies a few pages, not the catalog.
+ *
+ * Recipes are removed by moving the last slot into the hole, so removal is
+ * O(1) but does not preserve order, and every page but the last is full.
+ * Removed and replaced recipes leave their ingredients and text behind as
+ * garbage until their page is copied. Pages are allocated from a monotonic
+ * arena of the store, which every page allocated there keeps alive: a shared
+ * page outlives the store that wrote it, and so does its arena. Pages may be
+ * released on any thread; copies and writes must be serialized by the caller.
+ *
+ * Readers go through a set of raw column pointers per page (see Columns), so
+ * a store can also be attached to columns it does not own, such as a
+ * shared-memory CatalogImage. An attached store is read-only.
+ */
+class RecipeStore
+{
+public:
+  static constexpr std::uint32_t pageBits = 10;             ///< log2 of pageSlots
+  static constexpr std::uint32_t pageSlots = 1u << pageBits; ///< Slots per page
+
+  /**
+   * @brief Constructs an empty store.
+   *
+   * @param [in] upstream Resource the store's arena takes its blocks from
+   */
+  explicit RecipeStore(std::pmr::memory_resource *upstream);
+
+  RecipeStore(const RecipeStore &) = delete;
+  RecipeStore &operator=(const RecipeStore &) = delete;
+
+  /**
+   * @struct TextLengths
+   * @brief Lengths of the name and instructions of one recipe in the text pool.
+   */
+  struct TextLengths
+  {
+    std::uint32_t name;         ///< Length of the name in the text pool
+    std::uint32_t instructions; ///< Length of the instructions following the name
+  };
+
+  /**
+   * @struct Columns
+   * @brief Raw pointers to every column, as read by RecipeView.
+   */
+  struct Columns
+  {
+    std::uint32_t size = 0;                      ///< Number of recipes
+    const int *ids = nullptr;                    ///< Recipe id per slot
+    const std::uint64_t *signatures = nullptr;   ///< Ingredient signature per slot
+    const std::uint32_t *nameOffsets = nullptr;  ///< Text pool offset per slot
+    const std::uint32_t *ingredientOffsets = nullptr; ///< First ingredient per slot
+    const std::uint32_t *ingredientCounts = nullptr;  ///< Ingredient count per slot
+    const TextLengths *textLengths = nullptr;    ///< Text lengths per slot
+    const Ingredient *ingredients = nullptr;     ///< Ingredient records
+    size_t ingredientCount = 0;                  ///< Length of ingredients
+    const char *text = nullptr;                  ///< Text pool
+    size_t textBytes = 0;                        ///< Length of text
+  };
+
+  std::uint32_t size() const { return count; }                                ///< Number of recipes
+  bool empty() const { return count == 0; }                                   ///< True if there are no recipes
+  RecipeView view(std::uint32_t slot) const;                                  ///< View of one recipe
+  bool readOnly() const { return attached; }                                  ///< True while attached to external columns
+
+  /**
+   * @brief Returns the columns of the page holding a slot.
+   *
+   * Scans that view a page at a time through RecipeView(page, slot) load the
+   * column pointers once per page instead of once per recipe.
+   *
+   * @param [in] slot Any slot of the page
+   */
+  const Columns &pageOf(std::uint32_t slot) const;
+
+  /**
+   * @brief Points the store at columns it does not own, dropping its own.
+   *
+   * Until clear() is called the store is read-only: append(), replace() and
+   * remove() must not be used. The columns must outlive the store or the
+   * next clear().
+   *
+   * @param [in] external Columns to read from
+   */
+  void attach(const Columns &external);
+
+  /**
+   * @brief Appends a recipe.
+   *
+   * @param [in] recipe Recipe to store; instructions are stored as given
+   * @return Slot of the new recipe
+   */
+  std::uint32_t append(const Recipe &recipe);
+
+  /**
+   * @brief Replaces the recipe in a slot, keeping the slot.
+   *
+   * @param [in] slot Slot to overwrite
+   * @param [in] recipe New contents
+   */
+  void replace(std::uint32_t slot, const Recipe &recipe);
+
+  /**
+   * @brief Removes a recipe by moving the last recipe into its slot.
+   *
+   * @param [in] slot Slot to remove
+   */
+  void remove(std::uint32_t slot);
+
+  /**
+   * @brief Compares a stored recipe with a Recipe value.
+   *
+   * @param [in] slot Stored recipe
+   * @param [in] recipe Recipe to compare with (instructions as stored)
+   * @return true if id, name, ingredients and instructions are all equal
+   */
+  bool equals(std::uint32_t slot, const Recipe &recipe) const;
+
+  /**
+   * @brief Fills an empty store with a copy of every page of this one, without garbage.
+   *
+   * @param [out] dest Empty store to fill
+   */
+  void copyTo(RecipeStore &dest) const;
+
+  /**
+   * @brief Makes an empty store share every page of this one.
+   *
+   * Costs one pointer per page; the stores copy a page only when they write
+   * to it. This store must not be attached.
+   *
+   * @param [out] dest Empty store to fill
+   */
+  void shareTo(RecipeStore &dest) const;
+
+  /**
+   * @brief Removes every recipe and lets go of every page; detaches an attached store.
+   */
+  void clear();
+
+  /**
+   * @brief Returns the bytes held by removed or replaced recipes.
+   */
+  size_t garbageBytes() const;
+
+  /**
+   * @brief Returns the bytes the pages hold, spare capacity included.
+   */
+  size_t pageBytes() const;
+
+  /**
+   * @brief Returns the bytes the arenas of the pages took upstream.
+   *
+   * Counts each arena once. This exceeds pageBytes() by the buffers
+   * abandoned as pages grew and, since the pages shared with earlier stores
+   * pin their arenas, by what those arenas hold for pages no store uses.
+   */
+  size_t arenaBytes() const;
+
+  /**
+   * @brief Returns the counters of the allocations served by the store's arena.
+   */
+  AllocationStats arenaStats() const;
+
+  /**
+   * @brief Returns the counters of the blocks the store's arena took upstream.
+   */
+  AllocationStats blockStats() const;
+
+  /**
+   * @brief Adds the bytes of every page to a report.
+   *
+   * Components: "recipe columns", "ingredient arrays", "names" and
+   * "instructions". Garbage and spare capacity count as reserved. Pages
+   * shared with other stores are reported in full.
+   *
+   * @param [out] report Report to add to
+   */
+  void memoryUsage(MemoryReport &report) const;
+
+private:
+  friend class RecipeView;
+
+  static constexpr std::uint32_t pageMask = pageSlots - 1;
+
+  struct Arena;
+
+  /**
+   * @struct Page
+   * @brief pageSlots slots of every column, with their own ingredient array and text pool.
+   */
+  struct Page
+  {
+    explicit Page(std::shared_ptr<Arena> arena);
+
+    std::shared_ptr<Arena> arena; ///< Arena of the vectors below, released after them; null if attached
+
+    // Hot columns, one entry per slot.
+    std::pmr::vector<int> ids;
+    std::pmr::vector<std::uint64_t> signatures;
+    std::pmr::vector<std::uint32_t> ingredientOffsets;
+    std::pmr::vector<std::uint32_t> ingredientCounts;
+
+    // Flat array of required ingredients.
+    std::pmr::vector<Ingredient> ingredients;
+
+    // Cold columns and text pool.
+    std::pmr::vector<std::uint32_t> nameOffsets;
+    std::pmr::vector<TextLengths> textLengths;
+    std::pmr::vector<char> text;
+
+    size_t deadIngredients = 0; ///< Ingredient records no longer referenced
+    size_t deadText = 0;        ///< Text pool bytes no longer referenced
+
+    Columns cols; ///< What readers see: the vectors above, or attached columns
+
+    std::pmr::memory_resource *resource() const;
+    void push(int id, IngredientRange ingredients, std::string_view name, std::string_view instructions);
+    void write(std::uint32_t at, int id, IngredientRange ingredients, std::string_view name, std::string_view instructions);
+    void pop();
+    void refresh();
+    size_t bytes() const;
+  };
+
+  std::shared_ptr<Arena> arena;             ///< Arena new pages are allocated in
+  std::vector<std::shared_ptr<Page>> pages; ///< Page i holds slots [i * pageSlots, (i + 1) * pageSlots)
+  std::uint32_t count = 0;                  ///< Number of recipes
+  bool attached = false;                    ///< True while the pages point to external columns
+
+  /**
+   * @brief Returns a page this store may write, copying it into the arena if it is shared.
+   */
+  Page &writablePage(std::uint32_t page);
+
+  /**
+   * @brief Returns a compacted copy of a page, allocated in an arena.
+   */
+  static std::shared_ptr<Page> copyPage(const Page &from, const std::shared_ptr<Arena> &arena);
+};
+
+/**
+ * @class RecipeView
+ * @brief Read-only handle to one recipe of a RecipeStore.
+ *
+ * A view is two words and is meant to be passed by value. It stays valid
+ * until the store is modified.
+ */
+class RecipeView
+{
+public:
+  RecipeView(const RecipeStore &store, std::uint32_t slot);
+  RecipeView(const RecipeStore::Columns &page, std::uint32_t slot) : cols(&page), index(slot) {} ///< page must be store.pageOf(slot)
+
+  std::uint32_t slot() const { return index; } ///< Position of the recipe in the store
+  int id() const;                              ///< External recipe id
+  std::string_view name() const;               ///< Recipe name
+  std::string_view instructions() const;       ///< Instructions as stored (compressed)
+  std::uint32_t ingredientCount() const;       ///< Number of required ingredients
+  IngredientRange ingredients() const;         ///< Every required ingredient
+  std::uint64_t signature() const;             ///< signatureBit() of every required ingredient, ORed
+
+private:
+  const RecipeStore::Columns *cols; ///< Columns of the page holding the slot
+  std::uint32_t index;
+
+  std::uint32_t at() const; ///< Position of the slot in its page
+};
+
+inline const RecipeStore::Columns &RecipeStore::pageOf(std::uint32_t slot) const { return pages[slot >> pageBits]->cols; }
+
+inline RecipeView::RecipeView(const RecipeStore &store, std::uint32_t slot) : cols(&store.pageOf(slot)), index(slot) {}
+
+inline RecipeView RecipeStore::view(std::uint32_t slot) const { return RecipeView(*this, slot); }
+
+inline std::uint32_t RecipeView::at() const { return index & RecipeStore::pageMask; }
+
+inline int RecipeView::id() const { return cols->ids[at()]; }
+
+inline std::string_view RecipeView::name() const
+{
+  return std::string_view(cols->text + cols->nameOffsets[at()], cols->textLengths[at()].name);
+}
+
+inline std::string_view RecipeView::instructions() const
+{
+  const auto &lengths = cols->textLengths[at()];
+  return std::string_view(cols->text + cols->nameOffsets[at()] + lengths.name, lengths.instructions);
+}
+
+inline std::uint64_t RecipeView::signature() const { return cols->signatures[at()]; }
+
+inline std::uint32_t RecipeView::ingredientCount() const { return cols->ingredientCounts[at()]; }
+
+inline IngredientRange RecipeView::ingredients() const
+{
+  const Ingredient *first = cols->ingredients + cols->ingredientOffsets[at()];
+  return {first, first + cols->ingredientCounts[at()]};
+}
@@ -0,0 +1,157 @@
+/**
+ * @file resultWriter.hpp
+ * @brief Definition of the ResultFormat enum and the ResultWriter class.
+ *
+ * This file contains the serializer of query results (recipe lists,
+ * availability sets, recipe details, pantry dumps) as the tab-separated text
+ * of runQueries(), JSON or CSV, written straight into an OutputSink.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "ingredient.hpp"
+#include "outputSink.hpp"
+#include "recipeStore.hpp"
+#include "textCodec.hpp"
+
+/**
+ * @enum ResultFormat
+ * @brief Encoding of the replies written by ResultWriter.
+ */
+enum class ResultFormat : std::uint8_t
+{
+  Text, ///< "OK <n>" followed by n tab-separated lines, or "ERR <message>"; see ResultWriter::textField()
+  Json, ///< One JSON object per line (JSON Lines)
+  Csv   ///< One table per reply, header first, ended by an empty line
+};
+
+/**
+ * @brief Parses a format name ("text", "json" or "csv").
+ *
+ * @param [in] text Format name
+ * @param [out] out Parsed format
+ * @return true if the name is known
+ */
+bool parseResultFormat(std::string_view text, ResultFormat &out);
+
+/**
+ * @class ResultWriter
+ * @brief Writes one reply per call in the chosen format.
+ *
+ * Nothing is built in memory first: fields are escaped and numbers formatted
+ * directly into the sink's buffer, so serializing a reply costs about as much
+ * as copying its text. Quantities are written in decimal from their fixed
+ * point value ("2", "0.5"), the same in every format.
+ *
+ * JSON replies are objects on one line:
+ *   {"ok":true,"count":2,"recipes":[{"id":1,"name":"Pancakes"},...]}
+ *   {"ok":true,"recipe":{"id":1,"name":...,"ingredients":[{"name":...,"quantity":2,"unit":"units"}],"instructions":...}}
+ *   {"ok":true,"count":3,"ingredients":[...]}
+ *   {"ok":true}
+ *   {"ok":false,"error":"no recipe with id 7"}
+ *
+ * CSV replies are RFC 4180 tables with a header line (id,name / id,name,
+ * ingredient,quantity,unit,instructions / ingredient,quantity,unit / status
+ * / error), followed by an empty line so a stream of replies can be split.
+ * A recipe detail has one line per ingredient.
+ *
+ * In the text format, backslashes, tabs and line breaks inside names,
+ * instructions and messages are escaped (see textField()), so a reply is
+ * always exactly the lines its "OK <n>" announces, whatever the data holds.
+ *
+ * Names are written as stored: JSON output is valid UTF-8 when they are.
+ */
+
+class ResultWriter
+{
+public:
+  /**
+   * @brief Creates a writer.
+   *
+   * @param [in] out Sink the replies are written to; it is not flushed
+   * @param [in] format Encoding of the replies
+   */
+  ResultWriter(OutputSink &out, ResultFormat format) : out(out), format(format) {}
+
+  /**
+   * @brief Writes a list of recipes as ids and names.
+   *
+   * @param [in] store Catalog the slots belong to
+   * @param [in] slots Slots of the recipes, in output order
+   */
+  void recipes(const RecipeStore &store, const std::vector<std::uint32_t> &slots);
+
+  /**
+   * @brief Writes one recipe with its ingredients and decoded instructions.
+   *
+   * @param [in] recipe Recipe to write
+   * @param [in] codec Codec of the catalog the recipe belongs to
+   */
+  void recipe(RecipeView recipe, const TextCodec &codec);
+
+  /**
+   * @brief Writes a list of ingredients, such as a pantry.
+   *
+   * @param [in] items Ingredients, in output order
+   */
+  void ingredients(const std::vector<Ingredient> &items);
+
+  /**
+   * @brief Writes a successful reply without data.
+   */
+  void done();
+
+  /**
+   * @brief Writes a failed reply.
+   *
+   * @param [in] message What went wrong
+   */
+  void error(std::string_view message);
+
+  /**
+   * @brief Writes text as a quoted JSON string.
+   *
+   * @param [in] out Sink to write to
+   * @param [in] text Text to escape
+   */
+  static void jsonString(OutputSink &out, std::string_view text);
+
+  /**
+   * @brief Writes text as a field of the text format.
+   *
+   * A backslash becomes "\\", a tab "\t", a line feed "\n" and a carriage
+   * return "\r"; everything else is copied as is.
+   *
+   * @param [in] out Sink to write to
+   * @param [in] text Text to escape
+   */
+  static void textField(OutputSink &out, std::string_view text);
+
+  /**
+   * @brief Writes text as a CSV field, quoted only when it has to be.
+   *
+   * @param [in] out Sink to write to
+   * @param [in] text Text to escape
+   */
+  static void csvField(OutputSink &out, std::string_view text);
+
+  /**
+   * @brief Writes a quantity in hundredths as a decimal number, like formatQuantity().
+   *
+   * @param [in] out Sink to write to
+   * @param [in] quantity Quantity in hundredths
+   */
+  static void quantity(OutputSink &out, std::int32_t quantity);
+
+private:
+  OutputSink &out;
+  ResultFormat format;
+
+  /**
+   * @brief Writes one ingredient: a tab-separated line, a JSON object, or three CSV fields.
+   */
+  void ingredient(const Ingredient &item);
+};
@@ -0,0 +1,287 @@
+/**
+ * @file taskScheduler.hpp
+ * @brief Definition of the TaskScheduler class.
+ *
+ * This file contains the work-stealing scheduler shared by every parallel
+ * operation of the program, with its fork/join, parallelFor and
+ * parallelReduce helpers.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class TaskScheduler
+ * @brief Fork/join scheduler over a fixed set of workers with Chase-Lev deques.
+ *
+ * join(left, right) pushes right on the bottom of the calling worker's deque,
+ * runs left, then pops right back and runs it inline unless another worker
+ * stole it meanwhile. Idle workers steal from the top of a random victim's
+ * deque, which holds the oldest, and therefore largest, pieces of work. So a
+ * fork costs one push and one pop on the owner's deque, and tasks only move
+ * between threads when some worker runs out of work. Tasks live on the stack
+ * of the thread that forked them, which cannot return before they are done:
+ * scheduling never allocates.
+ *
+ * A worker waiting for a stolen task runs other tasks meanwhile. Idle workers
+ * go to sleep; a push wakes one only if every worker is asleep, so bursts of
+ * fine-grained tasks do not pay for a notify each.
+ *
+ * Threads that are not workers of the scheduler (the main thread, query
+ * server workers, the file watcher) hand the outermost join to the workers
+ * and block until it is done; nested joins then run on the workers.
+ *
+ * Coroutines (see asyncTask.hpp) are resumed on the workers with resume().
+ * Unlike joins, a resume allocates and goes through the handover queue: it
+ * is meant for coarse steps of a pipeline, not for fine-grained work.
+ *
+ * Tasks must not throw, and must not block on a lock that another task may
+ * hold while it waits for a join: a waiting worker may run any task.
+ */
+
+class TaskScheduler
+{
+public:
+  /**
+   * @brief Starts the workers.
+   *
+   * @param [in] workerCount Number of worker threads, at least 1
+   */
+  explicit TaskScheduler(size_t workerCount);
+
+  /**
+   * @brief Stops and joins the workers; no join may be in progress.
+   */
+  ~TaskScheduler();
+
+  TaskScheduler(const TaskScheduler &) = delete;
+  TaskScheduler &operator=(const TaskScheduler &) = delete;
+
+  /**
+   * @brief Returns the scheduler of the process, with one worker per hardware thread.
+   *
+   * Workers are started on the first call.
+   */
+  static TaskScheduler &shared();
+
+  size_t workerCount() const { return workers.size(); } ///< Number of worker threads
+
+  /**
+   * @brief Runs two functions, potentially in parallel, and returns when both are done.
+   *
+   * @param [in] left Function run by the calling thread
+   * @param [in] right Function offered to the other workers
+   */
+  template <typename Left, typename Right>
+  void join(const Left &left, const Right &right);
+
+  /**
+   * @brief Calls body(chunkBegin, chunkEnd) over [begin, end) in chunks of at most grain indices.
+   *
+   * The range is split in halves with join() until it is no larger than
+   * grain; a range no larger than grain runs inline on the caller.
+   *
+   * @param [in] begin First index
+   * @param [in] end One past the last index
+   * @param [in] grain Largest chunk run as one task, at least 1
+   * @param [in] body Function called for each chunk, concurrently
+   */
+  template <typename Body>
+  void parallelFor(size_t begin, size_t end, size_t grain, const Body &body);
+
+  /**
+   * @brief Maps every chunk of [begin, end) to a T and combines the results in index order.
+   *
+   * The range is split as in parallelFor(). combine is associative but need
+   * not be commutative: the left operand always covers lower indices.
+   *
+   * @param [in] begin First index
+   * @param [in] end One past the last index
+   * @param [in] grain Largest chunk mapped as one task, at least 1
+   * @param [in] map T map(chunkBegin, chunkEnd), called concurrently
+   * @param [in] combine T combine(T &&left, T &&right)
+   * @return map(begin, end) if the range is no larger than grain
+   */
+  template <typename T, typename Map, typename Combine>
+  T parallelReduce(size_t begin, size_t end, size_t grain, const Map &map, const Combine &combine);
+
+  /**
+   * @brief Resumes a suspended coroutine on one of the workers; returns at once.
+   *
+   * Safe from any thread, workers included. The coroutine runs after the
+   * tasks already handed over by non-worker threads.
+   *
+   * @param [in] handle Coroutine to resume
+   */
+  void resume(std::coroutine_handle<> handle);
+
+private:
+  /**
+   * @brief Unit of work, allocated by whoever forks it and run exactly once.
+   */
+  struct Task
+  {
+    void (*execute)(Task &) = nullptr;
+    std::atomic<bool> done{false};
+    bool external = false; ///< Handed over by a non-worker thread waiting on finished
+    bool detached = false; ///< Heap allocated, freed by execute; nobody waits for it
+  };
+
+  template <typename Function>
+  struct FunctionTask : Task
+  {
+    explicit FunctionTask(const Function &function) : function(function)
+    {
+      execute = [](Task &task)
+      { static_cast<FunctionTask &>(task).function(); };
+    }
+    const Function &function;
+  };
+
+  /**
+   * @brief Chase-Lev work-stealing deque of task pointers.
+   *
+   * The owner pushes and takes at the bottom, thieves steal at the top; the
+   * only contended operation is the race for the last task, settled by a CAS
+   * on top. Every access to top and bottom is sequentially consistent, which
+   * is what the algorithm needs (Le et al., PPoPP 2013) and costs the same as
+   * its fences on x86. A full array is replaced by one twice the size; old
+   * arrays are kept until the deque is destroyed since a thief may still be
+   * reading one.
+   */
+  class WorkDeque
+  {
+  public:
+    WorkDeque();
+    void push(Task *task);  ///< Owner only
+    Task *take();           ///< Owner only; null if empty
+    Task *steal();          ///< Any thread; null if empty or lost a race
+    bool empty() const;
+
+  private:
+    struct Array
+    {
+      explicit Array(size_t capacity) : mask(capacity - 1), slots(new std::atomic<Task *>[capacity]) {}
+      size_t mask;
+      std::unique_ptr<std::atomic<Task *>[]> slots;
+    };
+
+    std::atomic<std::int64_t> top{0};
+    std::atomic<std::int64_t> bottom{0};
+    std::atomic<Array *> array;
+    std::vector<std::unique_ptr<Array>> arrays; ///< Current and replaced arrays, owner only
+  };
+
+  struct alignas(64) Worker
+  {
+    TaskScheduler *owner = nullptr;
+    WorkDeque deque;
+    std::uint64_t random = 0; ///< xorshift state for picking victims
+  };
+
+  std::vector<std::unique_ptr<Worker>> workers;
+  std::vector<std::thread> threads;
+  std::atomic<size_t> searching{0};  ///< Awake workers looking for a task
+  std::atomic<size_t> sleeping{0};   ///< Workers blocked on wake
+  std::atomic<size_t> injectedCount{0};
+  std::mutex mutex;                  ///< Guards the members below
+  std::condition_variable wake;      ///< Sleeping workers wait here
+  std::condition_variable finished;  ///< Non-worker threads wait here for their task
+  std::deque<Task *> injected;       ///< Tasks handed over by non-worker threads
+  size_t wakeups = 0;
+  bool stopping = false;
+
+  static thread_local Worker *currentWorker; ///< Worker running on this thread, if any
+
+  void workerLoop(Worker &self);
+  Task *findTask(Worker &self);
+  bool haveWork() const;
+  void runTask(Task &task);
+  void push(Worker &self, Task &task);
+  void wakeOne();
+
+  /**
+   * @brief Waits for a stolen task, running other tasks meanwhile.
+   */
+  void waitFor(Worker &self, const Task &task);
+
+  /**
+   * @brief Hands a task to the workers and blocks until it is done.
+   */
+  void runExternal(Task &task);
+};
+
+template <typename Left, typename Right>
+void TaskScheduler::join(const Left &left, const Right &right)
+{
+  Worker *self = currentWorker;
+  if (self == nullptr || self->owner != this)
+  {
+    auto both = [&]()
+    { join(left, right); };
+    FunctionTask<decltype(both)> root(both);
+    runExternal(root);
+    return;
+  }
+
+  FunctionTask<Right> forked(right);
+  push(*self, forked);
+  left();
+  // Everything left() forked has been joined, so the bottom task is ours unless it was stolen.
+  if (self->deque.take() == &forked)
+  {
+    right();
+  }
+  else
+  {
+    waitFor(*self, forked);
+  }
+}
+
+template <typename Body>
+void TaskScheduler::parallelFor(size_t begin, size_t end, size_t grain, const Body &body)
+{
+  grain = std::max<size_t>(grain, 1);
+  if (end - begin <= grain)
+  {
+    if (begin < end)
+    {
+      body(begin, end);
+    }
+    return;
+  }
+  size_t middle = begin + (end - begin) / 2;
+  join([&]()
+       { parallelFor(begin, middle, grain, body); },
+       [&]()
+       { parallelFor(middle, end, grain, body); });
+}
+
+template <typename T, typename Map, typename Combine>
+T TaskScheduler::parallelReduce(size_t begin, size_t end, size_t grain, const Map &map, const Combine &combine)
+{
+  grain = std::max<size_t>(grain, 1);
+  if (end - begin <= grain)
+  {
+    return map(begin, end);
+  }
+  size_t middle = begin + (end - begin) / 2;
+  T left{};
+  T right{};
+  join([&]()
+       { left = parallelReduce<T>(begin, middle, grain, map, combine); },
+       [&]()
+       { right = parallelReduce<T>(middle, end, grain, map, combine); });
+  return combine(std::move(left), std::move(right));
+}
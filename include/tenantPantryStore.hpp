@@ -0,0 +1,181 @@
+/**
+ * @file tenantPantryStore.hpp
+ * @brief Definition of the TenantPantry and TenantPantryStore classes.
+ *
+ * This file contains the per-household pantries served next to the process
+ * pantry: compact immutable sets of ingredient name ids, shared between
+ * every tenant that holds the same set.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "flatHashMap.hpp"
+#include "memoryUsage.hpp"
+#include "pantry.hpp"
+
+/**
+ * @class TenantPantry
+ * @brief Immutable set of ingredient name ids.
+ *
+ * Stored as a sorted id array, or as a bitset over the ids when that is
+ * smaller (more than one id in 32 below the largest). Quantities are not
+ * kept: they do not change which recipes a tenant can make.
+ */
+
+class TenantPantry
+{
+public:
+  /**
+   * @brief Builds a set in its smaller representation.
+   *
+   * @param [in] nameIds Name ids, sorted and without duplicates
+   */
+  explicit TenantPantry(const std::vector<std::uint32_t> &nameIds);
+
+  bool contains(std::uint32_t nameId) const
+  {
+    if (!bits.empty())
+    {
+      return nameId / 64 < bits.size() && (bits[nameId / 64] >> (nameId % 64)) & 1;
+    }
+    return std::binary_search(sorted.begin(), sorted.end(), nameId);
+  }
+
+  size_t size() const { return count; }                            ///< Number of ids
+  const PantryFingerprint &fingerprint() const { return names; }   ///< Same hash as a Pantry with these names
+
+  /**
+   * @brief Returns the ids, in increasing order.
+   */
+  std::vector<std::uint32_t> ids() const;
+
+  /**
+   * @brief Returns the bytes of the array or the bitset, plus the object.
+   */
+  MemoryUsage memoryUsage() const;
+
+private:
+  std::vector<std::uint32_t> sorted; ///< Sorted ids, when bits is empty
+  std::vector<std::uint64_t> bits;   ///< Bit id % 64 of word id / 64 is set for every id
+  size_t count = 0;
+  PantryFingerprint names;
+};
+
+/**
+ * @struct TenantPantryStats
+ * @brief Counts reported by TenantPantryStore::stats().
+ */
+struct TenantPantryStats
+{
+  size_t tenants = 0;  ///< Tenants with a pantry
+  size_t distinct = 0; ///< Distinct pantries held by the store
+  size_t starters = 0; ///< Named starter pantries
+};
+
+/**
+ * @class TenantPantryStore
+ * @brief Pantries of many tenants, keyed by tenant id.
+ *
+ * A tenant is one entry of a flat hash map: its 64-bit id and a shared
+ * pointer to an immutable TenantPantry, 25 bytes plus the table's slack.
+ * Pantries are hash-consed by fingerprint, so every tenant holding the same
+ * set of ingredients shares one copy: new tenants share a named starter
+ * pantry, and a tenant whose edits lead back to a known set shares it again.
+ * An edit is copy-on-write: the tenant's set is copied with the change,
+ * interned, and the tenant's pointer replaced. Queries take a reference to
+ * a tenant's pantry and read it without the lock.
+ *
+ * Sets no tenant holds any more are dropped from the intern table when the
+ * last tenant leaves them, or by the next sweep if a query still held them.
+ */
+
+class TenantPantryStore
+{
+public:
+  using PantryPtr = std::shared_ptr<const TenantPantry>;
+
+  TenantPantryStore();
+
+  /**
+   * @brief Defines or replaces a starter pantry; tenants created from the old one keep it.
+   *
+   * @param [in] name Starter name
+   * @param [in] nameIds Ingredient name ids, in any order
+   */
+  void defineStarter(const std::string &name, std::vector<std::uint32_t> nameIds);
+
+  /**
+   * @brief Creates a tenant, or resets an existing one, with a starter pantry.
+   *
+   * @param [in] tenant Tenant id
+   * @param [in] starter Starter name, or empty for an empty pantry
+   * @return false if the starter is not defined
+   */
+  bool createTenant(std::uint64_t tenant, std::string_view starter);
+
+  /**
+   * @brief Removes a tenant.
+   *
+   * @return false if the tenant does not exist
+   */
+  bool eraseTenant(std::uint64_t tenant);
+
+  /**
+   * @brief Adds an ingredient to a tenant's pantry, creating the tenant if needed.
+   *
+   * @return false if the ingredient was already there
+   */
+  bool put(std::uint64_t tenant, std::uint32_t nameId);
+
+  /**
+   * @brief Removes an ingredient from a tenant's pantry.
+   *
+   * @return false if the tenant or the ingredient does not exist
+   */
+  bool remove(std::uint64_t tenant, std::uint32_t nameId);
+
+  /**
+   * @brief Returns a tenant's pantry, or null for an unknown tenant.
+   */
+  PantryPtr find(std::uint64_t tenant) const;
+
+  TenantPantryStats stats() const;
+
+  /**
+   * @brief Returns the bytes of the tenant and intern tables and of every distinct pantry.
+   */
+  MemoryUsage memoryUsage() const;
+
+private:
+  mutable std::mutex mutex;                                    ///< Guards every member below
+  FlatHashMap<std::uint64_t, PantryPtr> tenants;               ///< Tenant id -> pantry
+  FlatHashMap<std::uint64_t, PantryPtr> interned;              ///< Fingerprint (low half) -> distinct pantry
+  FlatHashMap<std::string, PantryPtr, StringHash> starters;    ///< Starter name -> pantry
+  PantryPtr empty;                                             ///< Shared by every tenant with nothing in stock
+  size_t sweepAt = 64;                                         ///< Intern table size that triggers the next sweep
+
+  /**
+   * @brief Returns the shared pantry holding exactly these ids, creating it if needed.
+   *
+   * @param [in] nameIds Sorted ids without duplicates
+   */
+  PantryPtr intern(const std::vector<std::uint32_t> &nameIds);
+
+  /**
+   * @brief Replaces a tenant's pantry and lets go of the old one.
+   */
+  void assign(PantryPtr &slot, PantryPtr next);
+
+  /**
+   * @brief Drops interned pantries that only the intern table holds.
+   */
+  void sweep();
+};
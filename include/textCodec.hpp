@@ -0,0 +1,99 @@
+/**
+ * @file textCodec.hpp
+ * @brief Definition of the TextCodec class.
+ *
+ * This file contains a small static-dictionary codec used to keep recipe
+ * instructions compressed in memory.
+ */
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "memoryUsage.hpp"
+
+/**
+ * @class TextCodec
+ * @brief Static-dictionary compressor for short, repetitive English text.
+ *
+ * train() collects the word sequences that save the most bytes across a
+ * corpus ("until golden ", "season with salt") and assigns each one a single
+ * byte code in the range 0x80-0xFE. encode() replaces the longest dictionary
+ * phrase found at every position with its code; ASCII bytes are stored as is
+ * and any other byte is escaped with 0xFF. Decoding is a single table lookup
+ * per byte, cheap enough to run every time a recipe is displayed.
+ *
+ * An untrained codec stores text unchanged.
+ */
+
+class TextCodec
+{
+public:
+  static constexpr size_t maxEntries = 127; ///< Codes 0x80-0xFE
+
+  /**
+   * @brief Builds the dictionary from a sample of texts.
+   *
+   * Replaces any previous dictionary; text encoded with it must be decoded first.
+   *
+   * @param [in] corpus Texts to learn from
+   */
+  void train(const std::vector<std::string_view> &corpus);
+
+  /**
+   * @brief Replaces the dictionary with phrases saved from another codec.
+   *
+   * Text encoded by that codec decodes identically with this one.
+   *
+   * @param [in] phrases Phrases in code order, as returned by phrases()
+   */
+  void load(const std::vector<std::string_view> &phrases);
+
+  /**
+   * @brief Returns the dictionary phrases in code order.
+   */
+  const std::vector<std::string> &phrases() const { return entries; }
+
+  /**
+   * @brief Returns true once train() has produced a non-empty dictionary.
+   */
+  bool trained() const { return !entries.empty(); }
+
+  /**
+   * @brief Compresses a text with the current dictionary.
+   *
+   * @param [in] text Raw text
+   * @return Encoded bytes
+   */
+  std::string encode(std::string_view text) const;
+
+  /**
+   * @brief Restores the original text.
+   *
+   * @param [in] data Bytes produced by encode()
+   * @return Decoded text
+   */
+  std::string decode(std::string_view data) const;
+
+  /**
+   * @brief Returns the number of bytes used by the dictionary phrases.
+   */
+  size_t dictionaryBytes() const;
+
+  /**
+   * @brief Returns the number of phrases in the dictionary.
+   */
+  size_t size() const { return entries.size(); }
+
+  /**
+   * @brief Returns the bytes of the phrases and the first-byte lookup table.
+   */
+  MemoryUsage memoryUsage() const;
+
+private:
+  void buildLookup();
+
+  std::vector<std::string> entries;                 ///< Phrase for code 0x80 + index
+  std::vector<std::vector<unsigned char>> byFirst; ///< Entry indices by first byte, longest first
+};
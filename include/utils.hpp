@@ -8,6 +8,7 @@
 
 #pragma once
 #include <string>
+#include <string_view>
 
 /**
  * @brief Removes leading and trailing whitespace from a string.
@@ -20,6 +21,17 @@
  */
 std::string trim(const std::string &s);
 
+/**
+ * @brief Removes leading and trailing whitespace from a string view.
+ *
+ * Unlike trim(), this strips every ASCII whitespace character (including
+ * '\r' from files saved with Windows line endings) and does not allocate.
+ *
+ * @param [in] s Input view to trim
+ * @return A view into s without surrounding whitespace
+ */
+std::string_view trimView(std::string_view s);
+
 /**
  * @brief Gets an integer input from the user within a specified range.
  *
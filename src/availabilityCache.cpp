@@ -0,0 +1,134 @@
+/**
+ * @file availabilityCache.cpp
+ * @brief Implementation of the AvailabilityCache class.
+ */
+
+#include "../include/availabilityCache.hpp"
+#include <algorithm>
+
+AvailabilityCache::AvailabilityCache(size_t capacity)
+    : sets(std::max<size_t>((capacity + ways - 1) / ways, 1)), slots(new Slot[sets * ways]), hands(sets, 0)
+{
+}
+
+AvailabilityCache::~AvailabilityCache()
+{
+  for (size_t i = 0; i < sets * ways; ++i)
+  {
+    delete slots[i].entry.load();
+  }
+}
+
+/**
+ * @brief Compares the entries of the key's set under an epoch pin.
+ *
+ * The reference bit is only written when it is clear, so repeated hits on
+ * the same entry do not keep writing to its cache line.
+ */
+std::shared_ptr<const AvailabilityCache::Bitmap> AvailabilityCache::find(std::uint64_t version,
+                                                                         const PantryFingerprint &pantry)
+{
+  EpochDomain::Guard guard = epochs.pin();
+  Slot *set = &slots[keyOf(version, pantry) % sets * ways];
+  for (size_t way = 0; way < ways; ++way)
+  {
+    const Entry *entry = set[way].entry.load();
+    if (entry != nullptr && entry->version == version && entry->pantry == pantry)
+    {
+      if (!set[way].referenced.load(std::memory_order_relaxed))
+      {
+        set[way].referenced.store(true, std::memory_order_relaxed);
+      }
+      hits.fetch_add(1, std::memory_order_relaxed);
+      return entry->result;
+    }
+  }
+  misses.fetch_add(1, std::memory_order_relaxed);
+  return nullptr;
+}
+
+void AvailabilityCache::insert(std::uint64_t version, const PantryFingerprint &pantry,
+                               std::shared_ptr<const Bitmap> result)
+{
+  auto fresh = new Entry{version, pantry, std::move(result)};
+  size_t first = keyOf(version, pantry) % sets;
+  Slot *set = &slots[first * ways];
+
+  std::lock_guard<std::mutex> lock(mutex);
+  // Computed concurrently by another query: replace it. Otherwise take a
+  // free way, or the CLOCK victim of the set.
+  size_t way = ways;
+  for (size_t i = 0; i < ways && way == ways; ++i)
+  {
+    const Entry *entry = set[i].entry.load(std::memory_order_relaxed);
+    if (entry != nullptr && entry->version == version && entry->pantry == pantry)
+    {
+      way = i;
+    }
+  }
+  for (size_t i = 0; i < ways && way == ways; ++i)
+  {
+    if (set[i].entry.load(std::memory_order_relaxed) == nullptr)
+    {
+      way = i;
+      ++entries;
+    }
+  }
+  if (way == ways)
+  {
+    std::uint8_t &hand = hands[first];
+    while (set[hand].referenced.exchange(false, std::memory_order_relaxed))
+    {
+      hand = static_cast<std::uint8_t>((hand + 1) % ways);
+    }
+    way = hand;
+    hand = static_cast<std::uint8_t>((hand + 1) % ways);
+    ++evictions;
+  }
+
+  set[way].referenced.store(false, std::memory_order_relaxed);
+  epochs.retire(set[way].entry.exchange(fresh));
+  epochs.collect();
+}
+
+void AvailabilityCache::clear()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  for (size_t i = 0; i < sets * ways; ++i)
+  {
+    slots[i].referenced.store(false, std::memory_order_relaxed);
+    epochs.retire(slots[i].entry.exchange(nullptr));
+  }
+  std::fill(hands.begin(), hands.end(), 0);
+  entries = 0;
+  epochs.collect();
+}
+
+AvailabilityCacheStats AvailabilityCache::stats() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  AvailabilityCacheStats counters;
+  counters.hits = hits.load(std::memory_order_relaxed);
+  counters.misses = misses.load(std::memory_order_relaxed);
+  counters.evictions = evictions;
+  counters.entries = entries;
+  return counters;
+}
+
+/**
+ * @brief Reads the entries under the mutex: only writers, which hold it, retire them.
+ */
+MemoryUsage AvailabilityCache::memoryUsage() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  MemoryUsage usage{entries * (sizeof(Entry) + sizeof(Slot)), entries * sizeof(Entry) + sets * ways * sizeof(Slot)};
+  for (size_t i = 0; i < sets * ways; ++i)
+  {
+    const Entry *entry = slots[i].entry.load(std::memory_order_relaxed);
+    if (entry != nullptr)
+    {
+      usage += {entry->result->size() * sizeof(std::uint64_t), entry->result->capacity() * sizeof(std::uint64_t)};
+    }
+  }
+  return usage;
+}
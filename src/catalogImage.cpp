@@ -0,0 +1,393 @@
+/**
+ * @file catalogImage.cpp
+ * @brief Implementation of the CatalogImage shared-memory catalog.
+ *
+ * Image layout (host byte order, every section 8-byte aligned):
+ *   Header | ids | signatures | name offsets | ingredient offsets |
+ *   ingredient counts | text lengths | ingredient records | text pool |
+ *   name table | phrase table
+ * A string table is u32 offsets[count + 1] followed by the string bytes;
+ * string i spans [offsets[i], offsets[i + 1]) of the bytes.
+ *
+ * The magic is written last, so a process that maps an image still being
+ * written sees it as not ready rather than reading half of it.
+ */
+
+#include "../include/catalogImage.hpp"
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <type_traits>
+#include "../include/ingredientDictionary.hpp"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+  constexpr std::uint64_t imageMagic = 0x3147414d49435656; // "VVCIMAG1"
+  constexpr std::uint32_t imageVersion = 2;
+
+  struct Header
+  {
+    std::uint64_t magic;
+    std::uint32_t version;
+    std::uint32_t ingredientSize; ///< sizeof(Ingredient) of the publisher
+    std::uint32_t recipes;
+    std::uint32_t names;
+    std::uint32_t phrases;
+    std::uint32_t reserved;
+    std::uint64_t ingredientCount;
+    std::uint64_t textBytes;
+    std::uint64_t totalBytes;
+    std::uint64_t ids;
+    std::uint64_t signatures;
+    std::uint64_t nameOffsets;
+    std::uint64_t ingredientOffsets;
+    std::uint64_t ingredientCounts;
+    std::uint64_t textLengths;
+    std::uint64_t ingredients;
+    std::uint64_t text;
+    std::uint64_t nameTable;
+    std::uint64_t phraseTable;
+  };
+  static_assert(std::is_trivially_copyable_v<Header>, "Header is written with memcpy");
+  static_assert(std::is_trivially_copyable_v<RecipeStore::TextLengths>, "TextLengths is written with memcpy");
+
+  constexpr std::uint64_t alignUp(std::uint64_t offset)
+  {
+    return (offset + 7) & ~std::uint64_t(7);
+  }
+
+  template <typename Strings>
+  std::uint64_t tableBytes(const Strings &strings)
+  {
+    std::uint64_t bytes = (strings.size() + 1) * sizeof(std::uint32_t);
+    for (const auto &s : strings)
+    {
+      bytes += s.size();
+    }
+    return bytes;
+  }
+
+  template <typename Strings>
+  void writeTable(unsigned char *out, const Strings &strings)
+  {
+    unsigned char *chars = out + (strings.size() + 1) * sizeof(std::uint32_t);
+    std::uint32_t offset = 0;
+    for (size_t i = 0; i < strings.size(); ++i)
+    {
+      std::memcpy(out + i * sizeof(offset), &offset, sizeof(offset));
+      std::memcpy(chars + offset, strings[i].data(), strings[i].size());
+      offset += static_cast<std::uint32_t>(strings[i].size());
+    }
+    std::memcpy(out + strings.size() * sizeof(offset), &offset, sizeof(offset));
+  }
+}
+
+CatalogImage::~CatalogImage()
+{
+  detach();
+}
+
+#ifdef _WIN32
+
+bool CatalogImage::publish(const std::string &, const RecipeStore &, const TextCodec &)
+{
+  std::cerr << "Shared catalog images are not supported on this platform." << std::endl;
+  return false;
+}
+
+bool CatalogImage::attach(const std::string &)
+{
+  std::cerr << "Shared catalog images are not supported on this platform." << std::endl;
+  return false;
+}
+
+void CatalogImage::detach()
+{
+}
+
+#else
+
+/**
+ * @brief Lays out and writes a new image; the previous image, if any, is unlinked first.
+ */
+bool CatalogImage::publish(const std::string &name, const RecipeStore &store, const TextCodec &codec)
+{
+  // The image holds live recipes only, so the pools are sized from the views, not the pages.
+  std::uint32_t recipes = store.size();
+  std::uint64_t ingredientCount = 0;
+  std::uint64_t textBytes = 0;
+  for (std::uint32_t slot = 0; slot < recipes; ++slot)
+  {
+    RecipeView recipe = store.view(slot);
+    ingredientCount += recipe.ingredientCount();
+    textBytes += recipe.name().size() + recipe.instructions().size();
+  }
+
+  IngredientDictionary &dictionary = IngredientDictionary::shared();
+  std::vector<std::string_view> names;
+  names.reserve(dictionary.size());
+  for (std::uint32_t id = 0; id < dictionary.size(); ++id)
+  {
+    names.push_back(dictionary.name(id));
+  }
+  const std::vector<std::string> &phrases = codec.phrases();
+
+  Header header{};
+  header.version = imageVersion;
+  header.ingredientSize = sizeof(Ingredient);
+  header.recipes = recipes;
+  header.names = static_cast<std::uint32_t>(names.size());
+  header.phrases = static_cast<std::uint32_t>(phrases.size());
+  header.ingredientCount = ingredientCount;
+  header.textBytes = textBytes;
+
+  std::uint64_t offset = sizeof(Header);
+  auto section = [&offset](std::uint64_t bytes)
+  {
+    std::uint64_t start = alignUp(offset);
+    offset = start + bytes;
+    return start;
+  };
+  header.ids = section(recipes * sizeof(int));
+  header.signatures = section(recipes * sizeof(std::uint64_t));
+  header.nameOffsets = section(recipes * sizeof(std::uint32_t));
+  header.ingredientOffsets = section(recipes * sizeof(std::uint32_t));
+  header.ingredientCounts = section(recipes * sizeof(std::uint32_t));
+  header.textLengths = section(recipes * sizeof(RecipeStore::TextLengths));
+  header.ingredients = section(ingredientCount * sizeof(Ingredient));
+  header.text = section(textBytes);
+  header.nameTable = section(tableBytes(names));
+  header.phraseTable = section(tableBytes(phrases));
+  header.totalBytes = alignUp(offset);
+
+  shm_unlink(name.c_str());
+  int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+  if (fd < 0)
+  {
+    std::cerr << "Could not create shared memory object " << name << ": " << std::strerror(errno) << std::endl;
+    return false;
+  }
+  if (ftruncate(fd, static_cast<off_t>(header.totalBytes)) != 0)
+  {
+    std::cerr << "Could not size shared memory object " << name << ": " << std::strerror(errno) << std::endl;
+    close(fd);
+    shm_unlink(name.c_str());
+    return false;
+  }
+  void *mapping = mmap(nullptr, header.totalBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED)
+  {
+    std::cerr << "Could not map shared memory object " << name << ": " << std::strerror(errno) << std::endl;
+    shm_unlink(name.c_str());
+    return false;
+  }
+
+  unsigned char *out = static_cast<unsigned char *>(mapping);
+  auto write = [out](std::uint64_t at, const void *data, size_t bytes)
+  {
+    if (bytes > 0)
+      std::memcpy(out + at, data, bytes);
+  };
+  std::uint32_t ingredientOffset = 0;
+  std::uint32_t textOffset = 0;
+  for (std::uint32_t slot = 0; slot < recipes; ++slot)
+  {
+    RecipeView recipe = store.view(slot);
+    int id = recipe.id();
+    std::uint64_t signature = recipe.signature();
+    IngredientRange ingredients = recipe.ingredients();
+    std::uint32_t ingredientTotal = static_cast<std::uint32_t>(ingredients.size());
+    std::string_view name = recipe.name();
+    std::string_view instructions = recipe.instructions();
+    RecipeStore::TextLengths lengths{static_cast<std::uint32_t>(name.size()),
+                                     static_cast<std::uint32_t>(instructions.size())};
+    write(header.ids + slot * sizeof(int), &id, sizeof(int));
+    write(header.signatures + slot * sizeof(std::uint64_t), &signature, sizeof(std::uint64_t));
+    write(header.nameOffsets + slot * sizeof(std::uint32_t), &textOffset, sizeof(std::uint32_t));
+    write(header.ingredientOffsets + slot * sizeof(std::uint32_t), &ingredientOffset, sizeof(std::uint32_t));
+    write(header.ingredientCounts + slot * sizeof(std::uint32_t), &ingredientTotal, sizeof(std::uint32_t));
+    write(header.textLengths + slot * sizeof(RecipeStore::TextLengths), &lengths, sizeof(lengths));
+    write(header.ingredients + std::uint64_t(ingredientOffset) * sizeof(Ingredient), ingredients.begin(),
+          ingredients.size() * sizeof(Ingredient));
+    write(header.text + textOffset, name.data(), name.size());
+    write(header.text + textOffset + name.size(), instructions.data(), instructions.size());
+    ingredientOffset += ingredientTotal;
+    textOffset += lengths.name + lengths.instructions;
+  }
+  writeTable(out + header.nameTable, names);
+  writeTable(out + header.phraseTable, phrases);
+  write(0, &header, sizeof(Header));
+
+  std::atomic_thread_fence(std::memory_order_release);
+  std::memcpy(out, &imageMagic, sizeof(imageMagic));
+  munmap(mapping, header.totalBytes);
+  return true;
+}
+
+/**
+ * @brief Maps an image and checks every offset before trusting it.
+ *
+ * The image comes from another process, so the column offsets, ingredient
+ * ids and string tables are all bounds-checked once here; readers then index
+ * the columns without further checks.
+ */
+bool CatalogImage::attach(const std::string &name)
+{
+  detach();
+  int fd = shm_open(name.c_str(), O_RDONLY, 0);
+  if (fd < 0)
+  {
+    std::cerr << "Could not open shared memory object " << name << ": " << std::strerror(errno) << std::endl;
+    return false;
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0 || static_cast<std::uint64_t>(info.st_size) < sizeof(Header))
+  {
+    std::cerr << "Shared memory object " << name << " is not a catalog image." << std::endl;
+    close(fd);
+    return false;
+  }
+  size_t size = static_cast<size_t>(info.st_size);
+  void *mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED)
+  {
+    std::cerr << "Could not map shared memory object " << name << ": " << std::strerror(errno) << std::endl;
+    return false;
+  }
+  base = static_cast<const unsigned char *>(mapping);
+  length = size;
+
+  Header header;
+  std::memcpy(&header, base, sizeof(Header));
+  std::atomic_thread_fence(std::memory_order_acquire);
+  // Sections start after the header, so a corrupt offset cannot alias it.
+  auto fits = [&header](std::uint64_t at, std::uint64_t count, std::uint64_t elementSize)
+  {
+    return at % 8 == 0 && at >= sizeof(Header) && at <= header.totalBytes &&
+           count <= (header.totalBytes - at) / elementSize;
+  };
+  bool valid = header.magic == imageMagic && header.version == imageVersion &&
+               header.ingredientSize == sizeof(Ingredient) && header.totalBytes <= size &&
+               fits(header.ids, header.recipes, sizeof(int)) &&
+               fits(header.signatures, header.recipes, sizeof(std::uint64_t)) &&
+               fits(header.nameOffsets, header.recipes, sizeof(std::uint32_t)) &&
+               fits(header.ingredientOffsets, header.recipes, sizeof(std::uint32_t)) &&
+               fits(header.ingredientCounts, header.recipes, sizeof(std::uint32_t)) &&
+               fits(header.textLengths, header.recipes, sizeof(RecipeStore::TextLengths)) &&
+               fits(header.ingredients, header.ingredientCount, sizeof(Ingredient)) &&
+               fits(header.text, header.textBytes, 1) &&
+               fits(header.nameTable, std::uint64_t(header.names) + 1, sizeof(std::uint32_t)) &&
+               fits(header.phraseTable, std::uint64_t(header.phrases) + 1, sizeof(std::uint32_t));
+  if (valid)
+  {
+    // Each string table's last offset must lie inside the image.
+    for (auto table : {std::make_pair(header.nameTable, header.names), std::make_pair(header.phraseTable, header.phrases)})
+    {
+      const std::uint32_t *offsets = reinterpret_cast<const std::uint32_t *>(base + table.first);
+      std::uint64_t chars = table.first + (std::uint64_t(table.second) + 1) * sizeof(std::uint32_t);
+      for (std::uint32_t i = 0; valid && i < table.second; ++i)
+      {
+        valid = offsets[i] <= offsets[i + 1];
+      }
+      valid = valid && offsets[table.second] <= header.totalBytes - chars;
+    }
+  }
+  if (valid)
+  {
+    RecipeStore::Columns cols = columns();
+    for (std::uint32_t slot = 0; valid && slot < cols.size; ++slot)
+    {
+      const RecipeStore::TextLengths &lengths = cols.textLengths[slot];
+      valid = cols.ingredientOffsets[slot] <= cols.ingredientCount &&
+              cols.ingredientCounts[slot] <= cols.ingredientCount - cols.ingredientOffsets[slot] &&
+              cols.nameOffsets[slot] <= cols.textBytes &&
+              std::uint64_t(lengths.name) + lengths.instructions <= cols.textBytes - cols.nameOffsets[slot];
+    }
+    for (size_t i = 0; valid && i < cols.ingredientCount; ++i)
+    {
+      valid = cols.ingredients[i].nameId < header.names &&
+              static_cast<std::uint8_t>(cols.ingredients[i].unit) <= static_cast<std::uint8_t>(Unit::Stalks);
+    }
+  }
+  if (!valid)
+  {
+    std::cerr << "Shared memory object " << name << " is not a valid catalog image." << std::endl;
+    detach();
+    return false;
+  }
+  return true;
+}
+
+void CatalogImage::detach()
+{
+  if (base != nullptr)
+  {
+    munmap(const_cast<unsigned char *>(base), length);
+    base = nullptr;
+    length = 0;
+  }
+}
+
+#endif
+
+RecipeStore::Columns CatalogImage::columns() const
+{
+  RecipeStore::Columns cols;
+  if (base == nullptr)
+    return cols;
+  Header header;
+  std::memcpy(&header, base, sizeof(Header));
+  cols.size = header.recipes;
+  cols.ids = reinterpret_cast<const int *>(base + header.ids);
+  cols.signatures = reinterpret_cast<const std::uint64_t *>(base + header.signatures);
+  cols.nameOffsets = reinterpret_cast<const std::uint32_t *>(base + header.nameOffsets);
+  cols.ingredientOffsets = reinterpret_cast<const std::uint32_t *>(base + header.ingredientOffsets);
+  cols.ingredientCounts = reinterpret_cast<const std::uint32_t *>(base + header.ingredientCounts);
+  cols.textLengths = reinterpret_cast<const RecipeStore::TextLengths *>(base + header.textLengths);
+  cols.ingredients = reinterpret_cast<const Ingredient *>(base + header.ingredients);
+  cols.ingredientCount = header.ingredientCount;
+  cols.text = reinterpret_cast<const char *>(base + header.text);
+  cols.textBytes = header.textBytes;
+  return cols;
+}
+
+std::vector<std::string_view> CatalogImage::strings(std::uint64_t offset, std::uint32_t count) const
+{
+  std::vector<std::string_view> out;
+  const std::uint32_t *offsets = reinterpret_cast<const std::uint32_t *>(base + offset);
+  const char *chars = reinterpret_cast<const char *>(offsets + count + 1);
+  out.reserve(count);
+  for (std::uint32_t i = 0; i < count; ++i)
+  {
+    out.emplace_back(chars + offsets[i], offsets[i + 1] - offsets[i]);
+  }
+  return out;
+}
+
+std::vector<std::string_view> CatalogImage::names() const
+{
+  if (base == nullptr)
+    return {};
+  Header header;
+  std::memcpy(&header, base, sizeof(Header));
+  return strings(header.nameTable, header.names);
+}
+
+std::vector<std::string_view> CatalogImage::phrases() const
+{
+  if (base == nullptr)
+    return {};
+  Header header;
+  std::memcpy(&header, base, sizeof(Header));
+  return strings(header.phraseTable, header.phrases);
+}
@@ -0,0 +1,53 @@
+/**
+ * @file countingResource.cpp
+ * @brief Implementation of the CountingResource memory resource adaptor.
+ */
+
+#include "../include/countingResource.hpp"
+
+CountingResource::CountingResource(std::pmr::memory_resource *upstream)
+    : upstream(upstream)
+{
+}
+
+void *CountingResource::do_allocate(size_t bytes, size_t alignment)
+{
+  void *p = upstream->allocate(bytes, alignment);
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  bytesAllocated.fetch_add(bytes, std::memory_order_relaxed);
+  bytesLive.fetch_add(bytes, std::memory_order_relaxed);
+  return p;
+}
+
+void CountingResource::do_deallocate(void *p, size_t bytes, size_t alignment)
+{
+  upstream->deallocate(p, bytes, alignment);
+  deallocations.fetch_add(1, std::memory_order_relaxed);
+  bytesLive.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Reads each counter; counts changing meanwhile may be seen half updated.
+ */
+AllocationStats CountingResource::stats() const
+{
+  AllocationStats counters;
+  counters.allocations = allocations.load(std::memory_order_relaxed);
+  counters.deallocations = deallocations.load(std::memory_order_relaxed);
+  counters.bytesAllocated = bytesAllocated.load(std::memory_order_relaxed);
+  counters.bytesLive = bytesLive.load(std::memory_order_relaxed);
+  return counters;
+}
+
+void CountingResource::reset()
+{
+  allocations.store(0, std::memory_order_relaxed);
+  deallocations.store(0, std::memory_order_relaxed);
+  bytesAllocated.store(0, std::memory_order_relaxed);
+  bytesLive.store(0, std::memory_order_relaxed);
+}
+
+bool CountingResource::do_is_equal(const std::pmr::memory_resource &other) const noexcept
+{
+  return this == &other;
+}
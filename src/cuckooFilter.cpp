@@ -0,0 +1,132 @@
+/**
+ * @file cuckooFilter.cpp
+ * @brief Implementation of the CuckooFilter class.
+ */
+
+#include "../include/cuckooFilter.hpp"
+
+/**
+ * @brief Sizes the table for the keys at a load of at most 90%, rounded up to a power of two buckets.
+ */
+void CuckooFilter::reset(size_t capacity)
+{
+  size_t buckets = 16;
+  while (buckets * slotsPerBucket * 9 < capacity * 10)
+  {
+    buckets *= 2;
+  }
+  slots.assign(buckets * slotsPerBucket, empty);
+  mask = buckets - 1;
+  count = 0;
+  hasVictim = false;
+}
+
+bool CuckooFilter::bucketPut(size_t bucket, std::uint16_t fingerprint)
+{
+  std::uint16_t *b = &slots[bucket * slotsPerBucket];
+  for (size_t i = 0; i < slotsPerBucket; ++i)
+  {
+    if (b[i] == empty)
+    {
+      b[i] = fingerprint;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool CuckooFilter::bucketTake(size_t bucket, std::uint16_t fingerprint)
+{
+  std::uint16_t *b = &slots[bucket * slotsPerBucket];
+  for (size_t i = 0; i < slotsPerBucket; ++i)
+  {
+    if (b[i] == fingerprint)
+    {
+      b[i] = empty;
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Stores the fingerprint in either bucket, evicting and relocating others if both are full.
+ *
+ * After maxKicks relocations the fingerprint still in hand is kept aside as
+ * the victim, so no key is ever lost, and the filter reports itself full.
+ */
+bool CuckooFilter::insert(std::uint32_t key)
+{
+  if (hasVictim)
+  {
+    return false;
+  }
+  std::uint64_t hash = mix(key);
+  std::uint16_t fp = fingerprint(hash);
+  size_t bucket = hash & mask;
+  ++count;
+  if (bucketPut(bucket, fp))
+  {
+    return true;
+  }
+  bucket = altBucket(bucket, fp);
+  if (bucketPut(bucket, fp))
+  {
+    return true;
+  }
+
+  for (size_t kick = 0; kick < maxKicks; ++kick)
+  {
+    // Swap with a pseudo-randomly chosen slot and move the evicted fingerprint on.
+    std::uint16_t &slot = slots[bucket * slotsPerBucket + ((fp ^ kick) & (slotsPerBucket - 1))];
+    std::uint16_t evicted = slot;
+    slot = fp;
+    fp = evicted;
+    bucket = altBucket(bucket, fp);
+    if (bucketPut(bucket, fp))
+    {
+      return true;
+    }
+  }
+  hasVictim = true;
+  victimBucket = bucket;
+  victimFingerprint = fp;
+  return false;
+}
+
+/**
+ * @brief Clears one matching fingerprint; the victim, if any, is moved back into the table.
+ */
+bool CuckooFilter::erase(std::uint32_t key)
+{
+  std::uint64_t hash = mix(key);
+  std::uint16_t fp = fingerprint(hash);
+  size_t bucket = hash & mask;
+  size_t other = altBucket(bucket, fp);
+  bool removed = false;
+  if (hasVictim && victimFingerprint == fp && (victimBucket == bucket || victimBucket == other))
+  {
+    hasVictim = false;
+    removed = true;
+  }
+  else
+  {
+    removed = bucketTake(bucket, fp) || bucketTake(other, fp);
+  }
+  if (!removed)
+  {
+    return false;
+  }
+  --count;
+  if (hasVictim && (bucketPut(victimBucket, victimFingerprint) ||
+                    bucketPut(altBucket(victimBucket, victimFingerprint), victimFingerprint)))
+  {
+    hasVictim = false;
+  }
+  return true;
+}
+
+MemoryUsage CuckooFilter::memoryUsage() const
+{
+  return {count * sizeof(std::uint16_t), slots.capacity() * sizeof(std::uint16_t)};
+}
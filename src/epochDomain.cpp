@@ -0,0 +1,85 @@
+/**
+ * @file epochDomain.cpp
+ * @brief Implementation of the EpochDomain class.
+ */
+
+#include "../include/epochDomain.hpp"
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <thread>
+
+EpochDomain::~EpochDomain()
+{
+  for (const Retired &entry : retired)
+  {
+    entry.destroy(entry.object);
+  }
+}
+
+/**
+ * @brief Claims a free slot, starting from one picked by thread id.
+ *
+ * The epoch may advance between reading it and claiming the slot; the slot
+ * then announces an older epoch than necessary, which only delays frees.
+ * Every operation here is sequentially consistent so that a writer either
+ * sees the claimed slot or the reader sees the writer's swap.
+ */
+EpochDomain::Guard EpochDomain::pin()
+{
+  static thread_local const size_t home = std::hash<std::thread::id>()(std::this_thread::get_id());
+  while (true)
+  {
+    std::uint64_t epoch = globalEpoch.load();
+    for (size_t i = 0; i < maxReaders; ++i)
+    {
+      std::atomic<std::uint64_t> &slot = slots[(home + i) % maxReaders].epoch;
+      std::uint64_t expected = 0;
+      if (slot.load(std::memory_order_relaxed) == 0 && slot.compare_exchange_strong(expected, epoch))
+      {
+        return Guard(&slot);
+      }
+    }
+    std::this_thread::yield();
+  }
+}
+
+void EpochDomain::retire(void *object, void (*destroy)(void *))
+{
+  std::lock_guard<std::mutex> lock(retiredMutex);
+  retired.push_back({globalEpoch.fetch_add(1), object, destroy});
+}
+
+/**
+ * @brief Frees what is older than the oldest epoch still announced.
+ */
+size_t EpochDomain::collect()
+{
+  std::lock_guard<std::mutex> lock(retiredMutex);
+  std::uint64_t oldest = std::numeric_limits<std::uint64_t>::max();
+  for (const Slot &slot : slots)
+  {
+    std::uint64_t epoch = slot.epoch.load();
+    if (epoch != 0)
+    {
+      oldest = std::min(oldest, epoch);
+    }
+  }
+
+  size_t freed = 0;
+  auto keep = std::partition(retired.begin(), retired.end(), [oldest](const Retired &entry)
+                             { return entry.epoch >= oldest; });
+  for (auto it = keep; it != retired.end(); ++it)
+  {
+    it->destroy(it->object);
+    ++freed;
+  }
+  retired.erase(keep, retired.end());
+  return freed;
+}
+
+size_t EpochDomain::pending() const
+{
+  std::lock_guard<std::mutex> lock(retiredMutex);
+  return retired.size();
+}
@@ -0,0 +1,177 @@
+/**
+ * @file fileWatcher.cpp
+ * @brief Implementation of the FileWatcher class.
+ *
+ * This file contains the inotify based watcher used on Linux and the
+ * portable polling fallback used everywhere else.
+ */
+
+#include "../include/fileWatcher.hpp"
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <set>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+FileWatcher::FileWatcher(const std::vector<std::string> &paths, Callback onChange)
+    : paths(paths), onChange(std::move(onChange))
+{
+}
+
+FileWatcher::~FileWatcher()
+{
+  stop();
+}
+
+/**
+ * @brief Starts watching the configured files.
+ *
+ * On Linux an inotify watch is placed on every parent directory, listening for
+ * IN_CLOSE_WRITE and IN_MOVED_TO so that both in-place writes and atomic
+ * "write temp + rename" saves are reported.
+ *
+ * @return true if the background thread was started
+ */
+bool FileWatcher::start()
+{
+  if (running)
+  {
+    return true;
+  }
+
+#ifdef __linux__
+  inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (inotifyFd < 0)
+  {
+    std::cerr << "Could not initialize inotify, hot reload disabled." << std::endl;
+    return false;
+  }
+  // Directories holding several watched files get one watch; adding it again
+  // returns the same descriptor, which is what events are matched on.
+  watches.assign(paths.size(), -1);
+  for (size_t i = 0; i < paths.size(); ++i)
+  {
+    fs::path parent = fs::path(paths[i]).parent_path();
+    std::string dir = parent.empty() ? "." : parent.string();
+    watches[i] = inotify_add_watch(inotifyFd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (watches[i] < 0)
+    {
+      std::cerr << "Could not watch directory " << dir << "." << std::endl;
+    }
+  }
+#endif
+
+  running = true;
+  worker = std::thread(&FileWatcher::run, this);
+  return true;
+}
+
+/**
+ * @brief Stops the background thread.
+ *
+ * The watcher loop wakes up at least every 200 ms, so stop() returns quickly.
+ */
+void FileWatcher::stop()
+{
+  running = false;
+  if (worker.joinable())
+  {
+    worker.join();
+  }
+#ifdef __linux__
+  if (inotifyFd >= 0)
+  {
+    close(inotifyFd);
+    inotifyFd = -1;
+  }
+#endif
+}
+
+#ifdef __linux__
+/**
+ * @brief Waits for inotify events and dispatches the changed files.
+ *
+ * Events are matched against the watched files by watch descriptor and file
+ * name, so equal names in different directories are told apart. Bursts of events
+ * (an editor usually emits several per save) are coalesced by waiting a short
+ * moment after the first event before invoking the callback once per file.
+ */
+void FileWatcher::run()
+{
+  alignas(inotify_event) char buffer[4096];
+  std::set<std::string> changed;
+
+  while (running)
+  {
+    pollfd pfd{inotifyFd, POLLIN, 0};
+    int ready = poll(&pfd, 1, changed.empty() ? 200 : 100);
+    if (ready > 0)
+    {
+      ssize_t length;
+      while ((length = read(inotifyFd, buffer, sizeof(buffer))) > 0)
+      {
+        for (char *ptr = buffer; ptr < buffer + length;)
+        {
+          const auto *event = reinterpret_cast<const inotify_event *>(ptr);
+          if (event->len > 0)
+          {
+            for (size_t i = 0; i < paths.size(); ++i)
+            {
+              if (watches[i] == event->wd && fs::path(paths[i]).filename() == event->name)
+              {
+                changed.insert(paths[i]);
+              }
+            }
+          }
+          ptr += sizeof(inotify_event) + event->len;
+        }
+      }
+      continue;
+    }
+
+    // Quiet period after a burst of events: report every file once.
+    for (const auto &path : changed)
+    {
+      onChange(path);
+    }
+    changed.clear();
+  }
+}
+#else
+/**
+ * @brief Polls the last write time of every watched file once per second.
+ */
+void FileWatcher::run()
+{
+  std::vector<fs::file_time_type> lastWrite;
+  std::error_code ec;
+  for (const auto &path : paths)
+  {
+    lastWrite.push_back(fs::last_write_time(path, ec));
+  }
+
+  while (running)
+  {
+    for (int i = 0; i < 5 && running; ++i)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+    for (size_t i = 0; i < paths.size() && running; ++i)
+    {
+      auto current = fs::last_write_time(paths[i], ec);
+      if (!ec && current != lastWrite[i])
+      {
+        lastWrite[i] = current;
+        onChange(paths[i]);
+      }
+    }
+  }
+}
+#endif
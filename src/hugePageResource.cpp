@@ -0,0 +1,110 @@
+/**
+ * @file hugePageResource.cpp
+ * @brief Implementation of the HugePageResource memory resource.
+ */
+
+#include "../include/hugePageResource.hpp"
+#include <cstdint>
+
+#ifdef __linux__
+#include <sys/mman.h>
+
+namespace
+{
+  size_t roundToHugePages(size_t bytes)
+  {
+    return (bytes + HugePageResource::hugePageSize - 1) & ~(HugePageResource::hugePageSize - 1);
+  }
+}
+#endif
+
+HugePageResource::HugePageResource(size_t minBytes, std::pmr::memory_resource *upstream)
+    : minBytes(minBytes), upstream(upstream)
+{
+}
+
+/**
+ * @brief Unmaps any block its owner did not give back.
+ */
+HugePageResource::~HugePageResource()
+{
+#ifdef __linux__
+  for (const auto &mapping : mappings)
+  {
+    munmap(mapping.first, mapping.second.length);
+  }
+#endif
+}
+
+/**
+ * @brief Tries MAP_HUGETLB, then an aligned normal mapping with MADV_HUGEPAGE, then upstream.
+ */
+void *HugePageResource::do_allocate(size_t bytes, size_t alignment)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+#ifdef __linux__
+  if (bytes >= minBytes && alignment <= hugePageSize)
+  {
+    size_t length = roundToHugePages(bytes);
+    void *p = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (p != MAP_FAILED)
+    {
+      mappings.emplace(p, Mapping{length, true});
+      counters.explicitBytes += length;
+      return p;
+    }
+
+    // Over-map by one huge page and trim, so the block starts on a huge page
+    // boundary and every 2 MiB of it can be backed by one page.
+    size_t padded = length + hugePageSize;
+    void *raw = mmap(nullptr, padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw != MAP_FAILED)
+    {
+      std::uintptr_t start = reinterpret_cast<std::uintptr_t>(raw);
+      std::uintptr_t aligned = (start + hugePageSize - 1) & ~std::uintptr_t(hugePageSize - 1);
+      if (aligned > start)
+        munmap(raw, aligned - start);
+      size_t tail = padded - (aligned - start) - length;
+      if (tail > 0)
+        munmap(reinterpret_cast<void *>(aligned + length), tail);
+      p = reinterpret_cast<void *>(aligned);
+      madvise(p, length, MADV_HUGEPAGE);
+      mappings.emplace(p, Mapping{length, false});
+      counters.transparentBytes += length;
+      return p;
+    }
+  }
+#endif
+  void *p = upstream->allocate(bytes, alignment);
+  counters.upstreamBytes += bytes;
+  return p;
+}
+
+void HugePageResource::do_deallocate(void *p, size_t bytes, size_t alignment)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+#ifdef __linux__
+  auto mapping = mappings.find(p);
+  if (mapping != mappings.end())
+  {
+    size_t length = mapping->second.length;
+    munmap(p, length);
+    (mapping->second.explicitPages ? counters.explicitBytes : counters.transparentBytes) -= length;
+    mappings.erase(mapping);
+    return;
+  }
+#endif
+  upstream->deallocate(p, bytes, alignment);
+  counters.upstreamBytes -= bytes;
+}
+
+HugePageStats HugePageResource::stats() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return counters;
+}
+
+bool HugePageResource::do_is_equal(const std::pmr::memory_resource &other) const noexcept
+{
+  return this == &other;
+}
@@ -0,0 +1,239 @@
+/**
+ * @file idIndex.cpp
+ * @brief Implementation of the IdIndex class.
+ */
+
+#include "../include/idIndex.hpp"
+#include <algorithm>
+
+/**
+ * @brief Returns true if an array covering [lo, hi] is small enough for the entries.
+ */
+bool IdIndex::compact(long long lo, long long hi, size_t entries)
+{
+  unsigned long long span = static_cast<unsigned long long>(hi - lo) + 1;
+  return span <= maxSpread * entries + minSpan;
+}
+
+/**
+ * @brief Mixes the bits of an id so that nearby ids spread over the table.
+ */
+size_t IdIndex::bucket(int id, size_t mask)
+{
+  std::uint32_t h = static_cast<std::uint32_t>(id);
+  h ^= h >> 16;
+  h *= 0x45d9f3bu;
+  h ^= h >> 16;
+  return h & mask;
+}
+
+std::uint32_t IdIndex::find(int id) const
+{
+  if (isDense)
+  {
+    unsigned long long offset = static_cast<unsigned long long>(id - base);
+    return offset < slots.size() ? slots[offset] : npos;
+  }
+  size_t mask = table.size() - 1;
+  for (size_t i = bucket(id, mask);; i = (i + 1) & mask)
+  {
+    const Entry &entry = table[i];
+    if (entry.slot == npos)
+      return npos;
+    if (entry.id == id && entry.slot != tombstone)
+      return entry.slot;
+  }
+}
+
+/**
+ * @brief Inserts or updates an id, growing the array or switching layout as needed.
+ */
+void IdIndex::assign(int id, std::uint32_t slot)
+{
+  if (isDense)
+  {
+    long long offset = id - base;
+    if (offset >= 0 && offset < static_cast<long long>(slots.size()))
+    {
+      count += slots[offset] == npos;
+      slots.set(static_cast<size_t>(offset), slot);
+      room = std::min(room, static_cast<size_t>(offset));
+      return;
+    }
+    long long lo = slots.empty() ? id : std::min<long long>(base + static_cast<long long>(room), id);
+    long long hi = slots.empty() ? id : std::max<long long>(base + static_cast<long long>(slots.size()) - 1, id);
+    if (!compact(lo, hi, count + 1))
+    {
+      rebuild(id, false);
+      insertHashed(id, slot);
+      return;
+    }
+    if (slots.empty())
+    {
+      base = id;
+      room = 0;
+      slots.assign(1, npos);
+    }
+    else if (id < base)
+    {
+      // Leave as much room below the id as the array already holds, so
+      // that a descending run shifts the array O(log n) times, not per id.
+      // Whole chunks are prepended, so the chunks already there are kept.
+      size_t grow = std::max(static_cast<size_t>(base - id), slots.size());
+      size_t chunks = (grow + slots.chunkSize - 1) / slots.chunkSize;
+      slots.prependChunks(chunks, npos);
+      base -= static_cast<long long>(chunks * slots.chunkSize);
+      room = static_cast<size_t>(id - base);
+    }
+    else
+    {
+      slots.resize(static_cast<size_t>(id - base) + 1, npos);
+    }
+    slots.set(static_cast<size_t>(id - base), slot);
+    ++count;
+    return;
+  }
+
+  size_t mask = table.size() - 1;
+  for (size_t i = bucket(id, mask);; i = (i + 1) & mask)
+  {
+    const Entry &entry = table[i];
+    if (entry.slot == npos)
+      break;
+    if (entry.id == id && entry.slot != tombstone)
+    {
+      table.set(i, {id, slot});
+      return;
+    }
+  }
+  if ((used + 1) * 4 > table.size() * 3)
+  {
+    rebuild(id, true);
+    if (isDense)
+    {
+      assign(id, slot);
+      return;
+    }
+  }
+  insertHashed(id, slot);
+}
+
+void IdIndex::erase(int id)
+{
+  if (isDense)
+  {
+    unsigned long long offset = static_cast<unsigned long long>(id - base);
+    if (offset < slots.size() && slots[offset] != npos)
+    {
+      slots.set(offset, npos);
+      --count;
+    }
+    return;
+  }
+  size_t mask = table.size() - 1;
+  for (size_t i = bucket(id, mask);; i = (i + 1) & mask)
+  {
+    const Entry &entry = table[i];
+    if (entry.slot == npos)
+      return;
+    if (entry.id == id && entry.slot != tombstone)
+    {
+      table.set(i, {id, tombstone});
+      --count;
+      return;
+    }
+  }
+}
+
+/**
+ * @brief Re-lays the index out for its live ids plus one id about to be inserted.
+ *
+ * @param [in] pending Id the caller inserts next
+ * @param [in] allowDense false to force the hash table layout
+ */
+void IdIndex::rebuild(int pending, bool allowDense)
+{
+  std::vector<Entry> live;
+  live.reserve(count);
+  if (isDense)
+  {
+    for (size_t i = 0; i < slots.size(); ++i)
+    {
+      if (slots[i] != npos)
+        live.push_back({static_cast<int>(base + static_cast<long long>(i)), slots[i]});
+    }
+  }
+  else
+  {
+    for (size_t i = 0; i < table.size(); ++i)
+    {
+      const Entry &entry = table[i];
+      if (entry.slot != npos && entry.slot != tombstone)
+        live.push_back(entry);
+    }
+  }
+
+  long long lo = pending;
+  long long hi = pending;
+  for (const Entry &entry : live)
+  {
+    lo = std::min<long long>(lo, entry.id);
+    hi = std::max<long long>(hi, entry.id);
+  }
+
+  slots.clear();
+  table.clear();
+  used = 0;
+  count = 0;
+  isDense = allowDense && compact(lo, hi, live.size() + 1);
+  if (isDense)
+  {
+    base = lo;
+    room = 0;
+    slots.assign(static_cast<size_t>(hi - lo) + 1, npos);
+    for (const Entry &entry : live)
+    {
+      slots.set(static_cast<size_t>(entry.id - base), entry.slot);
+    }
+    count = live.size();
+    return;
+  }
+
+  size_t capacity = 16;
+  while (capacity < (live.size() + 1) * 2)
+  {
+    capacity *= 2;
+  }
+  table.assign(capacity, {0, npos});
+  for (const Entry &entry : live)
+  {
+    insertHashed(entry.id, entry.slot);
+  }
+}
+
+/**
+ * @brief Stores an id known to be absent in the first free hash table entry.
+ */
+void IdIndex::insertHashed(int id, std::uint32_t slot)
+{
+  size_t mask = table.size() - 1;
+  size_t i = bucket(id, mask);
+  while (table[i].slot != npos && table[i].slot != tombstone)
+  {
+    i = (i + 1) & mask;
+  }
+  used += table[i].slot == npos;
+  table.set(i, {id, slot});
+  ++count;
+}
+
+/**
+ * @brief Counts one entry per id as used; holes and free table entries are only reserved.
+ */
+MemoryUsage IdIndex::memoryUsage() const
+{
+  MemoryUsage usage;
+  usage.used = count * (isDense ? sizeof(std::uint32_t) : sizeof(Entry));
+  usage.reserved = slots.capacity() * sizeof(std::uint32_t) + table.capacity() * sizeof(Entry);
+  return usage;
+}
@@ -0,0 +1,166 @@
+/**
+ * @file ingredient.cpp
+ * @brief Implementation of the unit and quantity conversion helpers.
+ *
+ * This file contains the lookup tables used to convert units of measurement
+ * between their text form in the data files and the Unit enum, and the
+ * conversions of fixed-point quantities.
+ */
+
+#include "../include/ingredient.hpp"
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+  struct UnitAlias
+  {
+    std::string_view text;
+    Unit unit;
+  };
+
+  constexpr UnitAlias unitAliases[] = {
+      {"grams", Unit::Grams},
+      {"gram", Unit::Grams},
+      {"g", Unit::Grams},
+      {"milliliters", Unit::Milliliters},
+      {"milliliter", Unit::Milliliters},
+      {"ml", Unit::Milliliters},
+      {"units", Unit::Units},
+      {"unit", Unit::Units},
+      {"cloves", Unit::Cloves},
+      {"clove", Unit::Cloves},
+      {"slices", Unit::Slices},
+      {"slice", Unit::Slices},
+      {"pieces", Unit::Pieces},
+      {"piece", Unit::Pieces},
+      {"stalks", Unit::Stalks},
+      {"stalk", Unit::Stalks},
+  };
+
+  bool equalsIgnoreCase(std::string_view a, std::string_view b)
+  {
+    if (a.size() != b.size())
+      return false;
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+      if (std::tolower(static_cast<unsigned char>(a[i])) != b[i])
+        return false;
+    }
+    return true;
+  }
+}
+
+/**
+ * @brief Parses a unit name by scanning the alias table.
+ *
+ * The table is tiny, so a linear scan is faster than any hashing.
+ *
+ * @param [in] text Unit name, already trimmed
+ * @param [out] out Parsed unit
+ * @return true if the text names a known unit
+ */
+bool parseUnit(std::string_view text, Unit &out)
+{
+  for (const auto &alias : unitAliases)
+  {
+    if (equalsIgnoreCase(text, alias.text))
+    {
+      out = alias.unit;
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Returns the canonical name of a unit.
+ *
+ * @param [in] unit Unit to convert
+ * @return Unit name, or an empty string for Unit::Unknown
+ */
+const char *unitName(Unit unit)
+{
+  switch (unit)
+  {
+  case Unit::Grams:
+    return "grams";
+  case Unit::Milliliters:
+    return "milliliters";
+  case Unit::Units:
+    return "units";
+  case Unit::Cloves:
+    return "cloves";
+  case Unit::Slices:
+    return "slices";
+  case Unit::Pieces:
+    return "pieces";
+  case Unit::Stalks:
+    return "stalks";
+  case Unit::Unknown:
+    break;
+  }
+  return "";
+}
+
+/**
+ * @brief Parses a decimal quantity into hundredths with std::from_chars.
+ *
+ * The integer and fraction parts are parsed separately, so the result is
+ * exact and independent of the current locale.
+ *
+ * @param [in] text Quantity, already trimmed
+ * @param [out] out Quantity in hundredths
+ * @return true if the text is a non-negative number in range
+ */
+bool parseQuantity(std::string_view text, std::int32_t &out)
+{
+  size_t dot = text.find('.');
+  std::string_view whole = text.substr(0, dot);
+  std::string_view fraction = dot == std::string_view::npos ? std::string_view() : text.substr(dot + 1);
+  if (whole.empty() || fraction.size() > 2 || (dot != std::string_view::npos && fraction.empty()))
+    return false;
+
+  std::int32_t units = 0;
+  auto result = std::from_chars(whole.data(), whole.data() + whole.size(), units);
+  if (result.ec != std::errc() || result.ptr != whole.data() + whole.size() || units < 0 ||
+      units > std::numeric_limits<std::int32_t>::max() / Ingredient::quantityScale - 1)
+    return false;
+
+  std::int32_t hundredths = 0;
+  for (size_t i = 0; i < 2; ++i)
+  {
+    char c = i < fraction.size() ? fraction[i] : '0';
+    if (c < '0' || c > '9')
+      return false;
+    hundredths = hundredths * 10 + (c - '0');
+  }
+  out = units * Ingredient::quantityScale + hundredths;
+  return true;
+}
+
+std::int32_t quantityFromDouble(double value)
+{
+  double scaled = std::round(value * Ingredient::quantityScale);
+  if (!(scaled >= 0))
+    return 0;
+  if (scaled > std::numeric_limits<std::int32_t>::max())
+    return std::numeric_limits<std::int32_t>::max();
+  return static_cast<std::int32_t>(scaled);
+}
+
+std::string formatQuantity(std::int32_t quantity)
+{
+  std::string text = std::to_string(quantity / Ingredient::quantityScale);
+  std::int32_t hundredths = quantity % Ingredient::quantityScale;
+  if (hundredths != 0)
+  {
+    text += '.';
+    text += static_cast<char>('0' + hundredths / 10);
+    if (hundredths % 10 != 0)
+      text += static_cast<char>('0' + hundredths % 10);
+  }
+  return text;
+}
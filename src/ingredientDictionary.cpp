@@ -0,0 +1,93 @@
+/**
+ * @file ingredientDictionary.cpp
+ * @brief Implementation of the IngredientDictionary class.
+ */
+
+#include "../include/ingredientDictionary.hpp"
+#include <cstdlib>
+#include <iostream>
+
+IngredientDictionary::~IngredientDictionary()
+{
+  for (auto &chunk : chunks)
+  {
+    delete[] chunk.load(std::memory_order_relaxed);
+  }
+}
+
+IngredientDictionary &IngredientDictionary::shared()
+{
+  static IngredientDictionary dictionary;
+  return dictionary;
+}
+
+std::uint32_t IngredientDictionary::intern(std::string_view name)
+{
+  std::uint32_t id;
+  if (!tryIntern(name, id))
+  {
+    std::cerr << "Ingredient dictionary is full." << std::endl;
+    std::abort();
+  }
+  return id;
+}
+
+/**
+ * @brief Interns a name under the lock.
+ *
+ * The name is written to its chunk before the count is published, so a
+ * reader that sees the id also sees the name.
+ */
+bool IngredientDictionary::tryIntern(std::string_view name, std::uint32_t &id)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  size_t hash = lookup.hashOf(name);
+  if (const std::uint32_t *existing = lookup.find(name, hash))
+  {
+    id = *existing;
+    return true;
+  }
+
+  std::uint32_t next = count.load(std::memory_order_relaxed);
+  if ((next >> chunkBits) >= maxChunks)
+  {
+    return false;
+  }
+  id = next;
+  std::string *chunk = chunks[id >> chunkBits].load(std::memory_order_relaxed);
+  if (chunk == nullptr)
+  {
+    chunk = new std::string[chunkSize];
+    chunks[id >> chunkBits].store(chunk, std::memory_order_release);
+  }
+  std::string &slot = chunk[id & (chunkSize - 1)];
+  slot.assign(name);
+  lookup.tryEmplaceHashed(hash, std::string_view(slot), id);
+  count.store(id + 1, std::memory_order_release);
+  return true;
+}
+
+std::uint32_t IngredientDictionary::find(std::string_view name) const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  const std::uint32_t *id = lookup.find(name);
+  return id == nullptr ? npos : *id;
+}
+
+/**
+ * @brief Counts the string objects of every allocated chunk, the heap bytes of long names and the lookup table.
+ */
+MemoryUsage IngredientDictionary::memoryUsage() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  MemoryUsage usage = lookup.memoryUsage();
+  std::uint32_t names = count.load(std::memory_order_relaxed);
+  for (std::uint32_t id = 0; id < names; ++id)
+  {
+    const std::string &text = chunks[id >> chunkBits].load(std::memory_order_relaxed)[id & (chunkSize - 1)];
+    usage.used += sizeof(std::string) + stringHeapBytes(text);
+    usage.reserved += stringHeapBytes(text);
+  }
+  usage.reserved += ((names + chunkSize - 1) / chunkSize) * chunkSize * sizeof(std::string);
+  return usage;
+}
@@ -0,0 +1,147 @@
+/**
+ * @file jsonArrayReader.cpp
+ * @brief Implementation of the JsonArrayReader class.
+ */
+
+#include "../include/jsonArrayReader.hpp"
+
+namespace
+{
+  bool isJsonSpace(char c)
+  {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+  }
+}
+
+JsonArrayReader::JsonArrayReader(const std::string &filename, size_t chunkBytes)
+    : file(filename, std::ios::binary), chunkBytes(chunkBytes)
+{
+}
+
+/**
+ * @brief Reads and scans chunks until an element completes, then hands the completed text over.
+ *
+ * The returned text ends with the last completed element; whatever follows
+ * it stays in pending, so the next chunk continues the element cut in two.
+ */
+bool JsonArrayReader::next(JsonChunk &out)
+{
+  out.text.clear();
+  out.elements.clear();
+  while (out.elements.empty())
+  {
+    // After the closing bracket, the rest of the file is still read so that
+    // text after the array is reported whatever the chunk size.
+    if (!failure.empty() || (finished && scanned == pending.size() && file.eof()))
+    {
+      return false;
+    }
+    if (scanned == pending.size())
+    {
+      if (file.eof())
+      {
+        failure = started ? "unexpected end of file" : "empty file";
+        return false;
+      }
+      size_t size = pending.size();
+      pending.resize(size + chunkBytes);
+      file.read(&pending[size], static_cast<std::streamsize>(chunkBytes));
+      pending.resize(size + static_cast<size_t>(file.gcount()));
+      if (file.bad() || (file.gcount() == 0 && !file.eof()))
+      {
+        failure = "read error at byte " + std::to_string(consumed + size);
+        return false;
+      }
+    }
+    if (!scan(out.elements))
+    {
+      return false;
+    }
+  }
+
+  size_t cut = out.elements.back().second;
+  out.text.assign(pending, 0, cut);
+  pending.erase(0, cut);
+  scanned -= cut;
+  elementStart -= depth > 0 ? cut : 0;
+  consumed += cut;
+  return true;
+}
+
+/**
+ * @brief Tracks what was last seen between elements, so that only an element
+ * or ']' may follow '[', only an element may follow ',', and only ',' or ']'
+ * may follow an element.
+ */
+bool JsonArrayReader::scan(std::vector<std::pair<size_t, size_t>> &out)
+{
+  for (; scanned < pending.size(); ++scanned)
+  {
+    char c = pending[scanned];
+    if (depth > 0)
+    {
+      if (inString)
+      {
+        if (escaped)
+          escaped = false;
+        else if (c == '\\')
+          escaped = true;
+        else if (c == '"')
+          inString = false;
+      }
+      else if (c == '"')
+      {
+        inString = true;
+      }
+      else if (c == '{' || c == '[')
+      {
+        ++depth;
+      }
+      else if ((c == '}' || c == ']') && --depth == 0)
+      {
+        out.emplace_back(elementStart, scanned + 1);
+        last = '}';
+      }
+      continue;
+    }
+    if (isJsonSpace(c))
+    {
+      continue;
+    }
+    if (finished)
+    {
+      failure = "unexpected text after the array at byte " + std::to_string(consumed + scanned);
+      return false;
+    }
+    if (!started)
+    {
+      if (c != '[')
+      {
+        failure = "expected an array at byte " + std::to_string(consumed + scanned);
+        return false;
+      }
+      started = true;
+      last = '[';
+    }
+    else if (c == ']' && last != ',')
+    {
+      finished = true;
+    }
+    else if (c == ',' && last == '}')
+    {
+      last = ',';
+    }
+    else if ((c == '{' || c == '[') && last != '}')
+    {
+      elementStart = scanned;
+      depth = 1;
+    }
+    else
+    {
+      failure = (last == '}' ? "expected ',' or ']' at byte " : "expected an object at byte ") +
+                std::to_string(consumed + scanned);
+      return false;
+    }
+  }
+  return true;
+}
@@ -7,46 +7,230 @@
  * and ingredients.
  */
 
+#include <algorithm>
+#include <csignal>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <thread>
+#include "../include/outputSink.hpp"
 #include "../include/recipeManager.hpp"
+#include "../include/queryServer.hpp"
 #include "../include/utils.hpp"
 
-int main()
+namespace
+{
+  QueryServer *runningServer = nullptr; ///< Stopped by SIGINT and SIGTERM in server mode
+
+  void stopServer(int)
+  {
+    if (runningServer != nullptr)
+    {
+      runningServer->stop();
+    }
+  }
+
+  /**
+   * @brief Prints the command line synopsis, for a rejected argument.
+   */
+  void printUsage(std::ostream &out)
+  {
+    out << "Usage: main [manifest] [--ingredients <file>] [--recipes <file>] [--batch <file>]\n"
+        << "            [--format text|json|csv] [--serve <socket>] [--workers <n>]\n"
+        << "            [--publish <name>] [--attach <name>] [--huge-pages]" << std::endl;
+  }
+}
+
+int main(int argc, char *argv[])
 {
   /**
    * @brief Initializes the RecipeManager and loads required data files.
    *
    * Loads:
    * - Ingredients from a text file.
-   * - Recipes from a JSON file.
+   * - Recipes from a JSON file, or from every file of a manifest/directory
+   *   when one is given on the command line.
    *
+   * Command line: main [manifest] [--ingredients <file>] [--recipes <file>] [--batch <file>]
+   *                    [--format text|json|csv] [--serve <socket>] [--workers <n>]
+   *                    [--publish <name>] [--attach <name>] [--huge-pages]
+   * - --ingredients and --recipes replace the default data files.
+   * - --batch answers the queries in <file> ("-" for stdin) on stdout and
+   *   exits, without the menu, the file watcher or the pantry log (see
+   *   RecipeManager::runQueries()).
+   * - --format writes the --batch replies as tab-separated text (the
+   *   default), JSON Lines or CSV (see ResultWriter).
+   * - --serve answers binary protocol requests on the Unix domain socket
+   *   <socket> (see QueryServer) with <n> worker threads, hot reloading the
+   *   data files, until SIGINT or SIGTERM.
+   * - --publish shares the loaded catalog in shared memory under <name>.
+   * - --attach uses the catalog another process published under <name>
+   *   instead of loading recipe files (falls back to loading them if it fails).
+   * - --huge-pages backs the large catalog arrays with 2 MiB pages.
+   * - Any other argument starting with "--", or an option missing its
+   *   value, prints the usage and exits with status 1.
    *
    * @param [in] rm                  Class RecipeManager instance that allows recipes management.
    * @param [in] ingredientsFile     Relative path to the ingredients file.
    * @param [in] recipesFile         Relative path to the recipes file.
    * @note Paths are relative to the current working directory.
    */
-  RecipeManager rm;
-  const std::string ingredientsFile = "../data/ingredients.txt";
-  const std::string recipesFile = "../data/recipes.json";
+  std::string ingredientsFile = "../data/ingredients.txt";
+  std::string recipesFile = "../data/recipes.json";
+  std::string batchFile;
+  ResultFormat format = ResultFormat::Text;
+  std::string serveSocket;
+  size_t workers = std::max(1u, std::thread::hardware_concurrency());
+  std::string manifest;
+  std::string publishName;
+  std::string attachName;
+  bool hugePages = false;
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    if (arg == "--ingredients" && i + 1 < argc)
+    {
+      ingredientsFile = argv[++i];
+    }
+    else if (arg == "--recipes" && i + 1 < argc)
+    {
+      recipesFile = argv[++i];
+    }
+    else if (arg == "--batch" && i + 1 < argc)
+    {
+      batchFile = argv[++i];
+    }
+    else if (arg == "--format" && i + 1 < argc)
+    {
+      if (!parseResultFormat(argv[++i], format))
+      {
+        std::cerr << "Unknown format " << argv[i] << ", expected text, json or csv." << std::endl;
+        return 1;
+      }
+    }
+    else if (arg == "--serve" && i + 1 < argc)
+    {
+      serveSocket = argv[++i];
+    }
+    else if (arg == "--workers" && i + 1 < argc)
+    {
+      workers = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+    }
+    else if (arg == "--publish" && i + 1 < argc)
+    {
+      publishName = argv[++i];
+    }
+    else if (arg == "--attach" && i + 1 < argc)
+    {
+      attachName = argv[++i];
+    }
+    else if (arg == "--huge-pages")
+    {
+      hugePages = true;
+    }
+    else if (arg.rfind("--", 0) == 0)
+    {
+      // Also reached by an option given last without its value: never take it for the manifest.
+      std::cerr << "Unknown option or missing value: " << arg << std::endl;
+      printUsage(std::cerr);
+      return 1;
+    }
+    else
+    {
+      manifest = arg;
+    }
+  }
+
+  // In batch mode stdout carries only replies: load reports go to stderr.
+  // The replies themselves are buffered by runQueries().
+  std::streambuf *stdoutBuffer = nullptr;
+  if (!batchFile.empty())
+  {
+    std::ios::sync_with_stdio(false);
+    std::cin.tie(nullptr);
+    stdoutBuffer = std::cout.rdbuf();
+    std::cout.rdbuf(std::cerr.rdbuf());
+  }
+
+  RecipeManager rm(hugePages);
+  bool attached = !attachName.empty() && rm.attachCatalog(attachName); ///< Must run before any load.
+  if (!attached && !manifest.empty())
+  {
+    rm.loadRecipesFromManifest(manifest); ///< Loads many recipe files in parallel.
+  }
+  else if (!attached)
+  {
+    rm.startLoadingRecipes(recipesFile); ///< Streams in the background, overlapping the pantry load below.
+  }
   rm.loadIngredientsFromFile(ingredientsFile);
-  rm.loadRecipesFromJson(recipesFile);
+  if (!publishName.empty() || !batchFile.empty() || !serveSocket.empty())
+  {
+    rm.waitForRecipes(); ///< Headless modes and the shared image need the whole catalog; the menu does not.
+  }
+  if (!publishName.empty())
+  {
+    rm.publishCatalog(publishName); ///< Lets other processes attach to this catalog.
+  }
+  if (!batchFile.empty())
+  {
+    std::cout.rdbuf(stdoutBuffer);
+    std::ifstream queries;
+    if (batchFile != "-")
+    {
+      queries.open(batchFile);
+      if (!queries.is_open())
+      {
+        std::cerr << "File " << batchFile << " not found or cannot be opened." << std::endl;
+        return 1;
+      }
+    }
+    rm.runQueries(batchFile == "-" ? std::cin : queries, std::cout, format); ///< Headless: answers queries and exits.
+    return 0;
+  }
+  rm.openPantryLog("../data/pantry.wal", "../data/pantry.snapshot"); ///< Restores manually added ingredients.
+  rm.startWatching(ingredientsFile); ///< Hot reloads the data files when they change on disk.
+
+  if (!serveSocket.empty())
+  {
+    QueryServer server(rm, workers);
+    if (!server.listen(serveSocket))
+    {
+      return 1;
+    }
+    runningServer = &server;
+    std::signal(SIGINT, stopServer);
+    std::signal(SIGTERM, stopServer);
+    std::cout << "Serving queries on " << serveSocket << " with " << workers << " workers." << std::endl;
+    server.run(); ///< Headless: answers clients until interrupted.
+    runningServer = nullptr;
+    std::cout << "Server stopped." << std::endl;
+    return 0;
+  }
 
+  OutputSink &out = OutputSink::console(); ///< Flushed before each read, see getIntegerInput().
   int choice;
   do
   {
     // Display main menu options
-    std::cout << "--- Virtual Chef ---" << std::endl;
-    std::cout << "1. Show all recipes" << std::endl;
-    std::cout << "2. Show available recipes" << std::endl;
-    std::cout << "3. Select a recipe" << std::endl;
-    std::cout << "4. Show all ingredients" << std::endl;
-    std::cout << "5. Add ingredients manually" << std::endl;
-    std::cout << "6. Load ingredients from file" << std::endl;
-    std::cout << "7. Exit" << std::endl;
-    std::cout << "Choose an option: ";
+    out << "--- Virtual Chef ---\n";
+    if (rm.loadingRecipes())
+    {
+      out << "(Recipes are still loading; lists show the ones indexed so far.)\n";
+    }
+    out << "1. Show all recipes\n";
+    out << "2. Show available recipes\n";
+    out << "3. Select a recipe\n";
+    out << "4. Show all ingredients\n";
+    out << "5. Add ingredients manually\n";
+    out << "6. Load ingredients from file\n";
+    out << "7. Show storage report\n";
+    out << "8. Select a recipe by id\n";
+    out << "9. Show memory usage\n";
+    out << "10. Remove used ingredients\n";
+    out << "11. Exit\n";
+    out << "Choose an option: ";
 
-    if (!getIntegerInput(choice, 1, 7))
+    if (!getIntegerInput(choice, 1, 11))
     {
       continue;
     };
@@ -69,16 +253,30 @@ int main()
       rm.manuallyAddIngredients(); ///< Allows the user to manually add an ingredient to the program.
       break;
     case 6:
-      std::cout << "To load new ingredients from a file, drop a txt or a csv with ingredients on 'data' folder";
-      std::cout << " with the format: \negg\nsalt\npepper\netc...\n " << std::endl;
-      std::cout << "Loading ingredients..." << std::endl;
-      rm.loadIngredientsFromFile(recipesFile);
+      out << "To load new ingredients from a file, drop a txt or a csv with ingredients on 'data' folder";
+      out << " with the format: \neggs, 6, units\nsalt, 100, grams\npepper, 20, grams\netc...\n \n";
+      out << "Loading ingredients...\n";
+      out.flush(); ///< The reload reports on std::cout directly.
+      rm.reloadIngredientsFromFile(ingredientsFile);
       break;
     case 7:
-      std::cout << "Exiting program..." << std::endl; ///< Ends execution of program.
+      rm.showStorageReport(); ///< Shows how much memory the catalog text uses.
+      break;
+    case 8:
+      rm.selectRecipeById(); ///< Shows the recipe with a given id without listing the catalog.
+      break;
+    case 9:
+      rm.showMemoryUsage("../data/memoryUsage.json"); ///< Shows what each part of the catalog costs in RAM.
+      break;
+    case 10:
+      rm.removeIngredients(); ///< Removes consumed ingredients from the pantry.
+      break;
+    case 11:
+      out << "Exiting program...\n"; ///< Ends execution of program.
       break;
     }
-  } while (choice != 7);
+  } while (choice != 11);
+  out.flush();
 
   return 0;
 };
\ No newline at end of file
@@ -0,0 +1,61 @@
+/**
+ * @file memoryUsage.cpp
+ * @brief Implementation of the MemoryReport class.
+ */
+
+#include "../include/memoryUsage.hpp"
+#include <string>
+#include "../include/outputSink.hpp"
+#include "../imports/nlohmann/json.hpp"
+
+MemoryUsage MemoryReport::total() const
+{
+  MemoryUsage sum;
+  for (const auto &entry : entries)
+  {
+    sum += entry.second;
+  }
+  return sum;
+}
+
+/**
+ * @brief Prints the components as an aligned table.
+ *
+ * Output format:
+ *   component             used bytes   reserved bytes
+ */
+void MemoryReport::print(OutputSink &out) const
+{
+  auto row = [&out](const std::string &name, const std::string &used, const std::string &reserved)
+  {
+    out.pad(name, 24, false);
+    out.pad(used, 12, true);
+    out.pad(reserved, 14, true);
+    out << '\n';
+  };
+  auto line = [&row](const std::string &name, const MemoryUsage &usage)
+  {
+    row(name, std::to_string(usage.used), std::to_string(usage.reserved));
+  };
+  row("Component", "Used", "Reserved");
+  for (const auto &entry : entries)
+  {
+    line(entry.first, entry.second);
+  }
+  line("Total", total());
+}
+
+std::string MemoryReport::toJson() const
+{
+  nlohmann::json components = nlohmann::json::array();
+  for (const auto &entry : entries)
+  {
+    components.push_back({{"name", entry.first},
+                          {"usedBytes", entry.second.used},
+                          {"reservedBytes", entry.second.reserved}});
+  }
+  MemoryUsage sum = total();
+  nlohmann::json document = {{"components", components},
+                             {"total", {{"usedBytes", sum.used}, {"reservedBytes", sum.reserved}}}};
+  return document.dump(2);
+}
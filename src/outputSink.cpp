@@ -0,0 +1,85 @@
+/**
+ * @file outputSink.cpp
+ * @brief Implementation of the OutputSink class.
+ */
+
+#include "../include/outputSink.hpp"
+#include <algorithm>
+#include <iostream>
+
+OutputSink::OutputSink(std::ostream &target, size_t capacity)
+    : target(target), capacity(std::max<size_t>(capacity, 64)), buffer(new char[this->capacity])
+{
+}
+
+OutputSink::~OutputSink()
+{
+  flush();
+}
+
+OutputSink &OutputSink::console()
+{
+  static OutputSink sink(std::cout);
+  return sink;
+}
+
+OutputSink &OutputSink::operator<<(double value)
+{
+  reserve(32);
+  used = static_cast<size_t>(
+      std::to_chars(buffer.get() + used, buffer.get() + capacity, value, std::chars_format::general, 6).ptr -
+      buffer.get());
+  return *this;
+}
+
+void OutputSink::pad(std::string_view text, size_t width, bool alignRight)
+{
+  size_t spaces = text.size() < width ? width - text.size() : 0;
+  if (!alignRight)
+  {
+    *this << text;
+  }
+  for (size_t i = 0; i < spaces; ++i)
+  {
+    *this << ' ';
+  }
+  if (alignRight)
+  {
+    *this << text;
+  }
+}
+
+void OutputSink::flush()
+{
+  drain();
+  target.flush();
+}
+
+void OutputSink::drain()
+{
+  if (used > 0)
+  {
+    target.write(buffer.get(), static_cast<std::streamsize>(used));
+    used = 0;
+  }
+}
+
+/**
+ * @brief Fills the buffer, then writes the rest straight through if it is a block or more.
+ */
+void OutputSink::writeLarge(const char *data, size_t size)
+{
+  size_t room = capacity - used;
+  std::memcpy(buffer.get() + used, data, room);
+  used = capacity;
+  drain();
+  data += room;
+  size -= room;
+  if (size >= capacity)
+  {
+    target.write(data, static_cast<std::streamsize>(size));
+    return;
+  }
+  std::memcpy(buffer.get(), data, size);
+  used = size;
+}
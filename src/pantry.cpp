@@ -0,0 +1,66 @@
+/**
+ * @file pantry.cpp
+ * @brief Implementation of the Pantry class.
+ */
+
+#include "../include/pantry.hpp"
+
+void Pantry::reserve(size_t count)
+{
+  ingredients.reserve(count);
+  index.reserve(count);
+}
+
+bool Pantry::put(const Ingredient &ingredient)
+{
+  auto inserted = index.tryEmplace(ingredient.nameId, static_cast<std::uint32_t>(ingredients.size()));
+  if (!inserted.second)
+  {
+    ingredients[*inserted.first] = ingredient;
+    return false;
+  }
+  ingredients.push_back(ingredient);
+  names.add(ingredient.nameId);
+  if (!filter.insert(ingredient.nameId))
+  {
+    rebuildFilter();
+  }
+  return true;
+}
+
+bool Pantry::remove(std::uint32_t nameId)
+{
+  const std::uint32_t *pos = index.find(nameId);
+  if (pos == nullptr)
+  {
+    return false;
+  }
+  std::uint32_t hole = *pos;
+  index.erase(nameId);
+  filter.erase(nameId);
+  names.remove(nameId);
+  if (hole != ingredients.size() - 1)
+  {
+    ingredients[hole] = ingredients.back();
+    index[ingredients[hole].nameId] = hole;
+  }
+  ingredients.pop_back();
+  return true;
+}
+
+void Pantry::rebuildFilter()
+{
+  filter.reset(ingredients.size() * 2);
+  for (const auto &ingredient : ingredients)
+  {
+    filter.insert(ingredient.nameId);
+  }
+}
+
+MemoryUsage Pantry::memoryUsage() const
+{
+  MemoryUsage usage = index.memoryUsage();
+  usage += filter.memoryUsage();
+  usage += {ingredients.size() * sizeof(Ingredient), ingredients.capacity() * sizeof(Ingredient)};
+  return usage;
+}
@@ -0,0 +1,402 @@
+/**
+ * @file pantryLog.cpp
+ * @brief Implementation of the PantryLog write-ahead log.
+ *
+ * Record layout (host byte order):
+ *   u32 payload length | u32 FNV-1a checksum of payload | payload
+ * Payload layout:
+ *   u8 op | u8 unit | i32 quantity | name bytes
+ *
+ * Records written since quantities became fixed point set fixedPointFlag in
+ * the op byte and store the quantity in hundredths; older records hold whole
+ * units and are scaled on replay.
+ *
+ * A snapshot file is a 4-byte magic followed by Put records in the same layout.
+ */
+
+#include "../include/pantryLog.hpp"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+  constexpr std::uint32_t snapshotMagic = 0x53504356; // "VCPS"
+  constexpr size_t headerSize = 8;
+  constexpr size_t fixedPayloadSize = 6;
+  constexpr unsigned char fixedPointFlag = 0x10;
+
+  std::uint32_t checksum(const char *data, size_t size)
+  {
+    std::uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; ++i)
+    {
+      hash ^= static_cast<unsigned char>(data[i]);
+      hash *= 16777619u;
+    }
+    return hash;
+  }
+
+  void encodeRecord(std::vector<char> &out, PantryLog::Op op, const Ingredient &ingredient)
+  {
+    std::string_view name = ingredient.name();
+    std::uint32_t length = static_cast<std::uint32_t>(fixedPayloadSize + name.size());
+    size_t start = out.size();
+    out.resize(start + headerSize + length);
+    char *payload = out.data() + start + headerSize;
+    payload[0] = static_cast<char>(static_cast<unsigned char>(op) | fixedPointFlag);
+    payload[1] = static_cast<char>(ingredient.unit);
+    std::int32_t quantity = ingredient.quantity;
+    std::memcpy(payload + 2, &quantity, sizeof(quantity));
+    std::memcpy(payload + fixedPayloadSize, name.data(), name.size());
+
+    std::uint32_t sum = checksum(payload, length);
+    std::memcpy(out.data() + start, &length, sizeof(length));
+    std::memcpy(out.data() + start + 4, &sum, sizeof(sum));
+  }
+
+  /**
+   * @brief Decodes records from a buffer and applies them to a map.
+   *
+   * @return Number of bytes consumed; decoding stops at the first torn or
+   *         corrupt record
+   */
+  size_t replayRecords(const std::string &data, size_t offset, FlatHashMap<std::uint32_t, Ingredient> &state)
+  {
+    while (data.size() - offset >= headerSize)
+    {
+      std::uint32_t length;
+      std::uint32_t sum;
+      std::memcpy(&length, data.data() + offset, sizeof(length));
+      std::memcpy(&sum, data.data() + offset + 4, sizeof(sum));
+      if (length < fixedPayloadSize || data.size() - offset - headerSize < length)
+        break;
+      const char *payload = data.data() + offset + headerSize;
+      if (checksum(payload, length) != sum)
+        break;
+
+      unsigned char opByte = static_cast<unsigned char>(payload[0]);
+      auto op = static_cast<PantryLog::Op>(opByte & ~fixedPointFlag);
+      std::int32_t quantity;
+      std::memcpy(&quantity, payload + 2, sizeof(quantity));
+      if ((opByte & fixedPointFlag) == 0)
+        quantity *= Ingredient::quantityScale;
+      Ingredient ingredient(std::string_view(payload + fixedPayloadSize, length - fixedPayloadSize),
+                            quantity, static_cast<Unit>(payload[1]));
+
+      if (op == PantryLog::Op::Put)
+        state[ingredient.nameId] = ingredient;
+      else if (op == PantryLog::Op::Remove)
+        state.erase(ingredient.nameId);
+      offset += headerSize + length;
+    }
+    return offset;
+  }
+
+  bool readFile(const std::string &path, std::string &out)
+  {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+      return false;
+    out.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+  }
+
+#ifdef _WIN32
+  int openForAppend(const std::string &path)
+  {
+    return _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY, _S_IREAD | _S_IWRITE);
+  }
+  int openForWrite(const std::string &path)
+  {
+    return _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+  }
+  bool writeAll(int fd, const char *data, size_t size)
+  {
+    while (size > 0)
+    {
+      int written = _write(fd, data, static_cast<unsigned>(size));
+      if (written <= 0)
+        return false;
+      data += written;
+      size -= static_cast<size_t>(written);
+    }
+    return true;
+  }
+  bool syncFile(int fd) { return _commit(fd) == 0; }
+  bool truncateFile(int fd, size_t size) { return _chsize(fd, static_cast<long>(size)) == 0; }
+  void closeFile(int fd) { _close(fd); }
+  void syncDirectory(const std::string &) {}
+#else
+  int openForAppend(const std::string &path)
+  {
+    return ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  }
+  int openForWrite(const std::string &path)
+  {
+    return ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  }
+  bool writeAll(int fd, const char *data, size_t size)
+  {
+    while (size > 0)
+    {
+      ssize_t written = ::write(fd, data, size);
+      if (written <= 0)
+        return false;
+      data += written;
+      size -= static_cast<size_t>(written);
+    }
+    return true;
+  }
+  bool syncFile(int fd)
+  {
+#ifdef __APPLE__
+    return ::fsync(fd) == 0;
+#else
+    return ::fdatasync(fd) == 0;
+#endif
+  }
+  bool truncateFile(int fd, size_t size) { return ::ftruncate(fd, static_cast<off_t>(size)) == 0; }
+  void closeFile(int fd) { ::close(fd); }
+  /// Makes a rename inside the directory durable.
+  void syncDirectory(const std::string &path)
+  {
+    std::filesystem::path parent = std::filesystem::path(path).parent_path();
+    int dirFd = ::open(parent.empty() ? "." : parent.c_str(), O_RDONLY | O_CLOEXEC);
+    if (dirFd >= 0)
+    {
+      ::fsync(dirFd);
+      ::close(dirFd);
+    }
+  }
+#endif
+}
+
+PantryLog::PantryLog(const std::string &logPath,
+                     const std::string &snapshotPath,
+                     size_t compactThreshold)
+    : logPath(logPath), snapshotPath(snapshotPath), compactThreshold(compactThreshold)
+{
+}
+
+PantryLog::~PantryLog()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  wakeWriter.notify_one();
+  if (writer.joinable())
+  {
+    writer.join();
+  }
+  if (fd >= 0)
+  {
+    closeFile(fd);
+  }
+}
+
+/**
+ * @brief Loads the snapshot, replays the log and starts the writer thread.
+ *
+ * If the log ends with a torn record it is truncated back to the last
+ * complete record, so new appends are never hidden behind garbage.
+ *
+ * @param [out] out Ingredients persisted by previous runs, sorted by name
+ * @return false if the log file cannot be opened for writing
+ */
+bool PantryLog::open(std::vector<Ingredient> &out)
+{
+  std::string data;
+  if (readFile(snapshotPath, data))
+  {
+    std::uint32_t magic = 0;
+    if (data.size() >= sizeof(magic))
+      std::memcpy(&magic, data.data(), sizeof(magic));
+    if (magic == snapshotMagic)
+      replayRecords(data, sizeof(magic), state);
+    else
+      std::cerr << "Pantry snapshot " << snapshotPath << " is corrupt, ignoring it." << std::endl;
+  }
+
+  data.clear();
+  readFile(logPath, data);
+  logSize = replayRecords(data, 0, state);
+
+  fd = openForAppend(logPath);
+  if (fd < 0)
+  {
+    std::cerr << "Pantry log " << logPath << " cannot be opened, changes will not be saved." << std::endl;
+    return false;
+  }
+  if (logSize != data.size())
+  {
+    std::cerr << "Pantry log " << logPath << " has a torn tail, truncating it." << std::endl;
+    truncateFile(fd, logSize);
+  }
+
+  size_t first = out.size();
+  state.forEach([&](std::uint32_t, const Ingredient &ingredient)
+                { out.push_back(ingredient); });
+  std::sort(out.begin() + static_cast<std::ptrdiff_t>(first), out.end(), [](const Ingredient &a, const Ingredient &b)
+            { return a.name() < b.name(); });
+  writer = std::thread(&PantryLog::run, this);
+  return true;
+}
+
+/**
+ * @brief Queues a mutation; the writer thread encodes and commits it.
+ *
+ * @param [in] op Kind of mutation
+ * @param [in] ingredient Ingredient affected
+ */
+void PantryLog::append(Op op, const Ingredient &ingredient)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    pending.emplace_back(op, ingredient);
+    ++appendedSeq;
+  }
+  wakeWriter.notify_one();
+}
+
+/**
+ * @brief Waits until the writer has handled every record appended so far.
+ */
+bool PantryLog::sync()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  if (!writer.joinable())
+  {
+    return false;
+  }
+  std::uint64_t target = appendedSeq;
+  committed.wait(lock, [&]
+                 { return processedSeq >= target; });
+  return !failed;
+}
+
+/**
+ * @brief Writer loop implementing group commit.
+ *
+ * Every pass takes all records queued since the previous pass, so while one
+ * fsync is in flight new appends accumulate into the next batch. The loop
+ * drains the queue completely before honoring a stop request. logSize only
+ * grows once a batch is written and synced, so it is always the end of the
+ * last good record.
+ */
+void PantryLog::run()
+{
+  std::vector<std::pair<Op, Ingredient>> batch;
+  std::vector<char> buffer;
+  bool broken = false; ///< The log could not be truncated after a failed write; nothing more is written
+
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true)
+  {
+    wakeWriter.wait(lock, [&]
+                    { return stopping || !pending.empty(); });
+    if (pending.empty())
+    {
+      break;
+    }
+    batch.swap(pending);
+    std::uint64_t batchEnd = appendedSeq;
+    lock.unlock();
+
+    buffer.clear();
+    for (const auto &record : batch)
+    {
+      encodeRecord(buffer, record.first, record.second);
+    }
+    bool written = !broken && writeAll(fd, buffer.data(), buffer.size()) && syncFile(fd);
+    if (written)
+    {
+      // The state mirror only holds what is on disk, so compaction never
+      // persists a record the log lost.
+      for (const auto &record : batch)
+      {
+        if (record.first == Op::Put)
+          state[record.second.nameId] = record.second;
+        else
+          state.erase(record.second.nameId);
+      }
+      logSize += buffer.size();
+    }
+    else if (!broken)
+    {
+      // Part of the batch may have reached the file: cut it off so the next
+      // batch does not land behind a torn record that would end the replay.
+      broken = !truncateFile(fd, logSize) || !syncFile(fd);
+      std::cerr << "Could not write pantry log " << logPath << ", " << batch.size() << " changes not saved"
+                << (broken ? "; the log cannot be repaired and no further changes will be saved." : ".")
+                << std::endl;
+    }
+    batch.clear();
+
+    if (written && logSize > compactThreshold)
+    {
+      compact();
+    }
+
+    lock.lock();
+    failed = failed || !written;
+    processedSeq = batchEnd;
+    committed.notify_all();
+  }
+}
+
+/**
+ * @brief Rewrites the snapshot from the state mirror and empties the log.
+ *
+ * The snapshot is written to a temporary file, synced and renamed over the
+ * old one before the log is truncated. A crash at any point leaves either the
+ * old snapshot plus the full log or the new snapshot plus a log whose records
+ * are already included in it; Put and Remove are idempotent, so replaying
+ * them again is harmless.
+ */
+void PantryLog::compact()
+{
+  std::vector<char> buffer(sizeof(snapshotMagic));
+  std::memcpy(buffer.data(), &snapshotMagic, sizeof(snapshotMagic));
+  state.forEach([&](std::uint32_t, const Ingredient &ingredient)
+                { encodeRecord(buffer, Op::Put, ingredient); });
+
+  std::string tmpPath = snapshotPath + ".tmp";
+  int tmpFd = openForWrite(tmpPath);
+  if (tmpFd < 0)
+  {
+    return;
+  }
+  bool ok = writeAll(tmpFd, buffer.data(), buffer.size()) && syncFile(tmpFd);
+  closeFile(tmpFd);
+  std::error_code ec;
+  if (!ok)
+  {
+    std::filesystem::remove(tmpPath, ec);
+    return;
+  }
+  std::filesystem::rename(tmpPath, snapshotPath, ec);
+  if (ec)
+  {
+    return;
+  }
+  syncDirectory(snapshotPath);
+
+  if (truncateFile(fd, 0) && syncFile(fd))
+  {
+    logSize = 0;
+  }
+}
@@ -0,0 +1,132 @@
+/**
+ * @file pantryUpdateQueue.cpp
+ * @brief Implementation of the PantryUpdateQueue class.
+ */
+
+#include "../include/pantryUpdateQueue.hpp"
+#include "../include/flatHashMap.hpp"
+
+PantryUpdateQueue::PantryUpdateQueue(Apply apply) : apply(std::move(apply))
+{
+}
+
+PantryUpdateQueue::~PantryUpdateQueue()
+{
+  stop();
+}
+
+void PantryUpdateQueue::start()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  if (running)
+  {
+    return;
+  }
+  running = true;
+  stopping = false;
+  applier = std::thread(&PantryUpdateQueue::run, this);
+}
+
+void PantryUpdateQueue::stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!running)
+    {
+      return;
+    }
+    stopping = true;
+  }
+  wake.notify_one();
+  applier.join();
+  std::lock_guard<std::mutex> lock(mutex);
+  running = false;
+}
+
+void PantryUpdateQueue::submit(const PantryUpdate &update)
+{
+  submitted.fetch_add(1, std::memory_order_relaxed);
+  queue.push(update);
+  if (idle.load() && idle.exchange(false))
+  {
+    // The applier holds the mutex from its announcement until it waits.
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+    }
+    wake.notify_one();
+  }
+}
+
+/**
+ * @brief Waits until the applier has caught up with the updates submitted before the call.
+ *
+ * Returns at once if the applier is not running.
+ */
+void PantryUpdateQueue::flush()
+{
+  std::uint64_t target = submitted.load();
+  std::unique_lock<std::mutex> lock(mutex);
+  drained.wait(lock, [&]()
+               { return processed.load() >= target || !running || stopping; });
+}
+
+PantryUpdateStats PantryUpdateQueue::stats() const
+{
+  return {submitted.load(std::memory_order_relaxed), applied.load(std::memory_order_relaxed),
+          batches.load(std::memory_order_relaxed)};
+}
+
+void PantryUpdateQueue::run()
+{
+  std::vector<PantryUpdate> batch;
+  FlatHashMap<std::uint32_t, std::uint32_t> position; ///< Name id -> position in batch
+  PantryUpdate update;
+  while (true)
+  {
+    batch.clear();
+    position.clear();
+    size_t count = 0;
+    while (count < maxBatch && queue.pop(update))
+    {
+      ++count;
+      auto inserted = position.tryEmplace(update.ingredient.nameId, static_cast<std::uint32_t>(batch.size()));
+      if (inserted.second)
+      {
+        batch.push_back(update);
+      }
+      else
+      {
+        batch[*inserted.first] = update;
+      }
+    }
+
+    if (count > 0)
+    {
+      apply(batch);
+      applied.fetch_add(batch.size(), std::memory_order_relaxed);
+      batches.fetch_add(1, std::memory_order_relaxed);
+      processed.fetch_add(count);
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+      }
+      drained.notify_all();
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    if (stopping)
+    {
+      break;
+    }
+    idle.store(true);
+    if (!queue.empty())
+    {
+      idle.store(false);
+      continue;
+    }
+    wake.wait(lock, [&]()
+              { return !idle.load() || stopping; });
+    idle.store(false);
+  }
+  drained.notify_all();
+}
@@ -0,0 +1,454 @@
+/**
+ * @file queryServer.cpp
+ * @brief Implementation of the QueryServer class.
+ */
+
+#include "../include/queryServer.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include "../include/queryProtocol.hpp"
+#include "../include/recipeManager.hpp"
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+  constexpr std::uint64_t listenId = 0;          ///< epoll tag of the listening socket
+  constexpr std::uint64_t wakeId = ~std::uint64_t(0); ///< epoll tag of the eventfd
+  constexpr size_t readChunk = 64 * 1024;
+}
+
+QueryServer::QueryServer(RecipeManager &manager, size_t workerCount)
+    : manager(manager), readBuffer(new char[readChunk])
+{
+  for (size_t i = 0; i < std::max<size_t>(workerCount, 1); ++i)
+  {
+    workers.emplace_back(&QueryServer::work, this);
+  }
+}
+
+QueryServer::~QueryServer()
+{
+  {
+    std::lock_guard<std::mutex> lock(jobsMutex);
+    workersDone = true;
+  }
+  jobsReady.notify_all();
+  for (auto &worker : workers)
+  {
+    worker.join();
+  }
+#ifdef __linux__
+  for (const auto &entry : connections)
+  {
+    ::close(entry.second.fd);
+  }
+  for (int fd : {listenFd, epollFd, wakeFd})
+  {
+    if (fd >= 0)
+    {
+      ::close(fd);
+    }
+  }
+  if (!socketPath.empty())
+  {
+    ::unlink(socketPath.c_str());
+  }
+#endif
+}
+
+bool QueryServer::listen(const std::string &path)
+{
+#ifndef __linux__
+  std::cerr << "The query server is only supported on Linux, " << path << " not opened." << std::endl;
+  return false;
+#else
+  sockaddr_un address;
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (path.empty() || path.size() >= sizeof(address.sun_path))
+  {
+    std::cerr << "Socket path " << path << " is empty or too long." << std::endl;
+    return false;
+  }
+  std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+  // A socket file left behind by a server that crashed would make bind() fail.
+  struct stat existing;
+  if (::stat(path.c_str(), &existing) == 0 && S_ISSOCK(existing.st_mode))
+  {
+    ::unlink(path.c_str());
+  }
+
+  listenFd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (listenFd < 0 || ::bind(listenFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 ||
+      ::listen(listenFd, SOMAXCONN) != 0)
+  {
+    std::cerr << "Cannot listen on " << path << ": " << std::strerror(errno) << std::endl;
+    return false;
+  }
+  socketPath = path;
+
+  epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+  wakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (epollFd < 0 || wakeFd < 0)
+  {
+    std::cerr << "Cannot create the event loop: " << std::strerror(errno) << std::endl;
+    return false;
+  }
+  epoll_event event;
+  event.events = EPOLLIN;
+  event.data.u64 = listenId;
+  ::epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event);
+  event.data.u64 = wakeId;
+  ::epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+  return true;
+#endif
+}
+
+void QueryServer::run()
+{
+#ifdef __linux__
+  if (epollFd < 0)
+  {
+    return;
+  }
+  epoll_event events[64];
+  while (!stopping)
+  {
+    int count = ::epoll_wait(epollFd, events, 64, -1);
+    if (count < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      std::cerr << "epoll_wait failed: " << std::strerror(errno) << std::endl;
+      return;
+    }
+    for (int i = 0; i < count; ++i)
+    {
+      std::uint64_t id = events[i].data.u64;
+      if (id == listenId)
+      {
+        accept();
+        continue;
+      }
+      if (id == wakeId)
+      {
+        std::uint64_t wakeups;
+        if (::read(wakeFd, &wakeups, sizeof(wakeups)) > 0)
+        {
+          deliverReplies();
+        }
+        continue;
+      }
+      auto it = connections.find(id);
+      if (it == connections.end())
+      {
+        continue;
+      }
+      if ((events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) && !readFrom(id, it->second))
+      {
+        continue;
+      }
+      if (events[i].events & EPOLLOUT)
+      {
+        writeTo(id, it->second);
+      }
+    }
+  }
+#endif
+}
+
+void QueryServer::stop()
+{
+  stopping = true;
+#ifdef __linux__
+  if (wakeFd >= 0)
+  {
+    std::uint64_t one = 1;
+    ssize_t written = ::write(wakeFd, &one, sizeof(one));
+    (void)written;
+  }
+#endif
+}
+
+void QueryServer::work()
+{
+  while (true)
+  {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(jobsMutex);
+      jobsReady.wait(lock, [this]()
+                     { return workersDone || !jobs.empty(); });
+      if (jobs.empty())
+      {
+        return;
+      }
+      job = std::move(jobs.front());
+      jobs.pop_front();
+    }
+
+    const char *request = job.request.data();
+    Reply reply{job.connection, std::string()};
+    size_t start = QueryProtocol::beginFrame(reply.frame, QueryProtocol::getU32(request + 4), 0);
+    QueryProtocol::Status status = manager.answerRequest(
+        static_cast<std::uint8_t>(request[8]),
+        std::string_view(request + QueryProtocol::headerBytes, job.request.size() - QueryProtocol::headerBytes),
+        reply.frame);
+    reply.frame[start + 8] = static_cast<char>(status);
+    QueryProtocol::endFrame(reply.frame, start);
+
+    // Only the reply that finds the queue empty has to wake the loop; the
+    // loop takes every queued reply at once.
+    bool wake;
+    {
+      std::lock_guard<std::mutex> lock(repliesMutex);
+      wake = replies.empty();
+      replies.push_back(std::move(reply));
+    }
+#ifdef __linux__
+    if (wake)
+    {
+      std::uint64_t one = 1;
+      ssize_t written = ::write(wakeFd, &one, sizeof(one));
+      (void)written;
+    }
+#else
+    (void)wake;
+#endif
+  }
+}
+
+void QueryServer::accept()
+{
+#ifdef __linux__
+  while (true)
+  {
+    int fd = ::accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0)
+    {
+      if (errno == EINTR || errno == ECONNABORTED)
+      {
+        continue;
+      }
+      if (errno != EAGAIN && errno != EWOULDBLOCK)
+      {
+        std::cerr << "accept failed: " << std::strerror(errno) << std::endl;
+      }
+      return;
+    }
+    std::uint64_t id = nextConnection++;
+    connections[id].fd = fd;
+    epoll_event event;
+    event.events = EPOLLIN;
+    event.data.u64 = id;
+    ::epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+  }
+#endif
+}
+
+/**
+ * @brief Reads once per readiness event, so one busy client cannot starve the others.
+ */
+bool QueryServer::readFrom(std::uint64_t id, Connection &connection)
+{
+#ifdef __linux__
+  ssize_t received = ::read(connection.fd, readBuffer.get(), readChunk);
+  if (received == 0 || (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+  {
+    disconnect(id);
+    return false;
+  }
+
+  // Frames are cut straight from the read buffer; only a partial frame is
+  // kept in the connection, and only then are later reads appended to it.
+  std::string_view data(readBuffer.get(), static_cast<size_t>(std::max<ssize_t>(received, 0)));
+  bool buffered = !connection.input.empty();
+  if (buffered)
+  {
+    connection.input.append(data);
+    data = connection.input;
+  }
+  std::vector<Job> batch;
+  size_t pos = 0;
+  while (data.size() - pos >= 4)
+  {
+    std::uint32_t size = QueryProtocol::getU32(data.data() + pos);
+    if (size < QueryProtocol::headerBytes - 4 || size > QueryProtocol::maxRequestBytes)
+    {
+      disconnect(id);
+      return false;
+    }
+    if (data.size() - pos < 4 + size)
+    {
+      break;
+    }
+    batch.push_back({id, std::string(data.substr(pos, 4 + size))});
+    pos += 4 + size;
+  }
+  if (buffered)
+  {
+    connection.input.erase(0, pos);
+  }
+  else
+  {
+    connection.input.assign(data.substr(pos));
+  }
+  if (batch.empty())
+  {
+    return true;
+  }
+
+  connection.inFlight += batch.size();
+  {
+    std::lock_guard<std::mutex> lock(jobsMutex);
+    for (auto &job : batch)
+    {
+      jobs.push_back(std::move(job));
+    }
+  }
+  if (batch.size() == 1)
+  {
+    jobsReady.notify_one();
+  }
+  else
+  {
+    jobsReady.notify_all();
+  }
+  if (connection.inFlight >= maxInFlight)
+  {
+    connection.reading = false;
+    updateEvents(id, connection);
+  }
+  return true;
+#else
+  (void)id;
+  (void)connection;
+  return false;
+#endif
+}
+
+bool QueryServer::writeTo(std::uint64_t id, Connection &connection)
+{
+#ifdef __linux__
+  while (connection.outputSent < connection.output.size())
+  {
+    ssize_t sent = ::send(connection.fd, connection.output.data() + connection.outputSent,
+                          connection.output.size() - connection.outputSent, MSG_NOSIGNAL);
+    if (sent < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      if (errno == EAGAIN || errno == EWOULDBLOCK)
+      {
+        break;
+      }
+      disconnect(id);
+      return false;
+    }
+    connection.outputSent += static_cast<size_t>(sent);
+  }
+
+  bool pending = connection.outputSent < connection.output.size();
+  if (!pending)
+  {
+    connection.output.clear();
+    connection.outputSent = 0;
+  }
+  if (pending != connection.writing)
+  {
+    connection.writing = pending;
+    updateEvents(id, connection);
+  }
+  return true;
+#else
+  (void)id;
+  (void)connection;
+  return false;
+#endif
+}
+
+/**
+ * @brief Appends each reply to its connection, then writes to every connection that was idle.
+ *
+ * A connection that still has unwritten output is already waiting for
+ * EPOLLOUT and is written when the socket drains.
+ */
+void QueryServer::deliverReplies()
+{
+  {
+    std::lock_guard<std::mutex> lock(repliesMutex);
+    delivering.swap(replies);
+  }
+  std::vector<std::uint64_t> idle;
+  for (auto &reply : delivering)
+  {
+    auto it = connections.find(reply.connection);
+    if (it == connections.end())
+    {
+      continue;
+    }
+    Connection &connection = it->second;
+    if (connection.output.empty())
+    {
+      idle.push_back(reply.connection);
+    }
+    connection.output += reply.frame;
+    --connection.inFlight;
+    if (!connection.reading && connection.inFlight < maxInFlight / 2)
+    {
+      connection.reading = true;
+      updateEvents(reply.connection, connection);
+    }
+  }
+  delivering.clear();
+
+  for (std::uint64_t id : idle)
+  {
+    auto it = connections.find(id);
+    if (it != connections.end())
+    {
+      writeTo(id, it->second);
+    }
+  }
+}
+
+void QueryServer::updateEvents(std::uint64_t id, const Connection &connection)
+{
+#ifdef __linux__
+  epoll_event event;
+  event.events = (connection.reading ? EPOLLIN : 0u) | (connection.writing ? EPOLLOUT : 0u);
+  event.data.u64 = id;
+  ::epoll_ctl(epollFd, EPOLL_CTL_MOD, connection.fd, &event);
+#else
+  (void)id;
+  (void)connection;
+#endif
+}
+
+void QueryServer::disconnect(std::uint64_t id)
+{
+  auto it = connections.find(id);
+  if (it == connections.end())
+  {
+    return;
+  }
+#ifdef __linux__
+  ::close(it->second.fd); // Also removes it from the epoll set.
+#endif
+  connections.erase(it);
+}
@@ -7,6 +7,7 @@
  */
 
 #include "../include/recipe.hpp"
+#include <algorithm>
 
 /**
  * @brief Constructs a new Recipe object.
@@ -15,14 +16,14 @@
  * and preparation instructions. The data is stored internally for use
  * in recipe management systems.
  *
- * Example usage:
+ * Example usage (quantities are in hundredths, see Ingredient::quantityScale):
  * ```cpp
  * Recipe recipe(101,
- *              "Cheese Burger",
- *              {{"Bread", 2, "slices"},
- *               {"Lettuce", 2, "slices"},
- *               {"Mayonnaise", 8, "grams"}},
- *              "Start by placing the burger patty on a heated grill...");
+ *               "Cheese Burger",
+ *               {Ingredient("Bread", 200, Unit::Slices),
+ *                Ingredient("Lettuce", 200, Unit::Slices),
+ *                Ingredient("Mayonnaise", 800, Unit::Grams)},
+ *               "Start by placing the burger patty on a heated grill...");
  * ```
  *
  * @param [in] id Unique identifier for the recipe
@@ -48,4 +49,20 @@ Recipe::Recipe(int id,
  * Currently performs no additional cleanup as all internal members
  * are handled automatically by their destructors.
  */
-Recipe::~Recipe() = default;
\ No newline at end of file
+Recipe::~Recipe() = default;
+
+/**
+ * @brief Returns the bytes held by the recipe.
+ *
+ * Strings short enough for the small string buffer cost nothing beyond the
+ * object itself.
+ */
+MemoryUsage Recipe::memoryUsage() const
+{
+  MemoryUsage usage;
+  usage.used = sizeof(Recipe) + recipe_name.size() + instructions.size() + ingredients.size() * sizeof(Ingredient);
+  usage.reserved = sizeof(Recipe) + stringHeapBytes(recipe_name) + stringHeapBytes(instructions) +
+                   ingredients.capacity() * sizeof(Ingredient);
+  usage.reserved = std::max(usage.reserved, usage.used);
+  return usage;
+}
@@ -0,0 +1,85 @@
+/**
+ * @file recipeCatalog.cpp
+ * @brief Implementation of the RecipeCatalog class.
+ */
+
+#include "../include/recipeCatalog.hpp"
+#include <atomic>
+
+namespace
+{
+  std::atomic<std::uint64_t> nextCatalogVersion{1}; ///< Catalogs are created by writers and by attach, on any thread
+  constexpr size_t compactionRatio = 3;              ///< Arena bytes allowed per page byte before compacting
+  constexpr size_t compactionSlack = 1 << 20;        ///< Arena bytes always allowed on top
+}
+
+RecipeCatalog::RecipeCatalog(std::pmr::memory_resource *upstream)
+    : version(nextCatalogVersion.fetch_add(1, std::memory_order_relaxed)),
+      store(upstream),
+      codec(std::make_shared<TextCodec>())
+{
+}
+
+/**
+ * @brief Shares the other catalog's storage, or compacts it once it pins too much.
+ *
+ * A full load leaves up to about as much arena behind as its pages use, in
+ * buffers abandoned as the pools grew. Compaction copies the whole catalog,
+ * but only after earlier versions left more than the live bytes behind on
+ * top of that, so its cost is amortized over them.
+ */
+void RecipeCatalog::copyFrom(const RecipeCatalog &other)
+{
+  if (other.store.arenaBytes() > compactionRatio * other.store.pageBytes() + compactionSlack)
+  {
+    other.store.copyTo(store);
+  }
+  else
+  {
+    other.store.shareTo(store);
+  }
+  recipeIndex = other.recipeIndex;
+  codec = other.codec;
+  loadMilliseconds = other.loadMilliseconds;
+  loadAllocations = other.loadAllocations;
+}
+
+void RecipeCatalog::add(const Recipe &recipe)
+{
+  recipeIndex.assign(recipe.id, store.append(recipe));
+}
+
+void RecipeCatalog::erase(std::uint32_t slot)
+{
+  recipeIndex.erase(store.view(slot).id());
+  std::uint32_t last = store.size() - 1;
+  if (slot != last)
+  {
+    recipeIndex.assign(store.view(last).id(), slot);
+  }
+  store.remove(slot);
+}
+
+/**
+ * @brief Reports the catalog components.
+ *
+ * The arena overhead is what the arenas of the store pages took upstream
+ * but no page holds: buffers abandoned when a column grew, the unused tail
+ * of each block and pages of earlier versions that no catalog uses any more.
+ * A shared image is reported in full, although every attached process maps
+ * the same pages.
+ */
+void RecipeCatalog::memoryUsage(MemoryReport &report) const
+{
+  store.memoryUsage(report);
+  if (image)
+  {
+    report.add("shared catalog image", {image->bytes(), image->bytes()});
+  }
+  report.add("instruction dictionary", codec->memoryUsage());
+  report.add("recipe id index", recipeIndex.memoryUsage());
+
+  size_t arenaReserved = store.arenaBytes();
+  size_t arenaLive = store.pageBytes();
+  report.add("catalog arena overhead", {0, arenaReserved > arenaLive ? arenaReserved - arenaLive : 0});
+}
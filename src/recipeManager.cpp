@@ -12,23 +12,214 @@
 #include <iostream>
 #include <algorithm>
 #include <cctype>
+#include <charconv>
+#include <chrono>
+#include <filesystem>
+#include <limits>
 #include "../imports/nlohmann/json.hpp"
 #include "utils.hpp"
+#include "fileWatcher.hpp"
+#include "pantryLog.hpp"
+#include "catalogImage.hpp"
+#include "taskScheduler.hpp"
 
 using json = nlohmann::json;
 
+/**
+ * @brief Publishes an empty catalog and pantry and starts the pantry update applier.
+ *
+ * Every catalog arena takes its blocks from bulkResource: the heap, or
+ * hugePages when enabled.
+ *
+ * @param [in] useHugePages true to back large bulk arrays with huge pages
+ */
+RecipeManager::RecipeManager(bool useHugePages)
+    : bulkResource(useHugePages ? static_cast<std::pmr::memory_resource *>(&hugePages)
+                                : std::pmr::new_delete_resource())
+{
+  current.store(new Snapshot{std::make_shared<RecipeCatalog>(bulkResource), std::make_shared<Pantry>()});
+  updates = std::make_unique<PantryUpdateQueue>(
+      [this](const std::vector<PantryUpdate> &batch)
+      {
+        applyPantryUpdates(batch);
+      });
+  updates->start();
+}
+
+/**
+ * @brief Stops the recipe load, the update applier and the watcher, the last writers besides the caller, and frees the published snapshot.
+ *
+ * A background recipe load stops after the chunks in flight. Queued pantry updates are applied, and logged, before the log closes.
+ * Retired snapshots are freed by the epoch domain, before hugePages goes away.
+ */
+RecipeManager::~RecipeManager()
+{
+  cancelLoad.store(true);
+  waitForRecipes();
+  updates->stop();
+  if (watcher)
+  {
+    watcher->stop();
+  }
+  delete current.exchange(nullptr);
+}
+
+void RecipeManager::swapSnapshot(std::shared_ptr<const RecipeCatalog> catalog, std::shared_ptr<const Pantry> pantry)
+{
+  bool catalogChanged = catalog != latest().catalog;
+  const Snapshot *previous = current.exchange(new Snapshot{std::move(catalog), std::move(pantry)});
+  if (catalogChanged)
+  {
+    // Entries of the old catalog could never be hit again, free them now.
+    availability.clear();
+  }
+  epochs.retire(previous);
+  epochs.collect();
+}
+
+/**
+ * @brief Starts a new catalog version from the published one.
+ *
+ * The new version shares the pages and index chunks of the published one,
+ * so it costs one pointer per page until it writes. Once earlier versions
+ * pinned too much arena memory, it is a compacted copy instead (see
+ * RecipeCatalog::copyFrom()); this is what keeps the monotonic arenas from
+ * growing.
+ */
+std::shared_ptr<RecipeCatalog> RecipeManager::copyCatalog() const
+{
+  auto next = std::make_shared<RecipeCatalog>(bulkResource);
+  next->copyFrom(*latest().catalog);
+  return next;
+}
+
+namespace
+{
+  /**
+   * @brief Parses one "name, quantity, unit" line of an ingredients file.
+   *
+   * Quantity is parsed with parseQuantity(), which neither throws nor depends
+   * on the current locale. A line holding only a name is accepted with a zero
+   * quantity and an unknown unit, as in the plain "egg\nsalt" list format.
+   *
+   * @param [in] line Line to parse, already trimmed and not empty
+   * @param [out] out Parsed ingredient
+   * @param [out] error Description of the problem when parsing fails
+   * @return true if the line is valid
+   */
+  bool parseIngredientLine(std::string_view line, Ingredient &out, std::string &error)
+  {
+    std::string_view fields[3];
+    size_t count = 0;
+    while (true)
+    {
+      size_t comma = line.find(',');
+      if (count == 3)
+      {
+        error = "too many fields";
+        return false;
+      }
+      fields[count++] = trimView(line.substr(0, comma));
+      if (comma == std::string_view::npos)
+        break;
+      line.remove_prefix(comma + 1);
+    }
+
+    if (fields[0].empty())
+    {
+      error = "missing ingredient name";
+      return false;
+    }
+    if (count == 1)
+    {
+      out = Ingredient(fields[0], 0, Unit::Unknown);
+      return true;
+    }
+
+    std::int32_t quantity;
+    if (!parseQuantity(fields[1], quantity))
+    {
+      error = "invalid quantity '" + std::string(fields[1]) + "'";
+      return false;
+    }
+    Unit unit;
+    if (count < 3 || fields[2].empty())
+    {
+      error = "missing unit";
+      return false;
+    }
+    if (!parseUnit(fields[2], unit))
+    {
+      error = "unknown unit '" + std::string(fields[2]) + "'";
+      return false;
+    }
+    out = Ingredient(fields[0], quantity, unit);
+    return true;
+  }
+}
+
+/**
+ * @brief Reads the ingredients listed in a CSV file.
+ *
+ * The whole file is read with a single call and split into lines with
+ * std::string_view, so no per-line stream or string is created. Invalid lines
+ * are reported on std::cerr with their line number and skipped.
+ *
+ * @param [in] filename Path to the input file
+ * @param [out] out Parsed ingredients, in file order
+ * @return false if the file cannot be opened
+ */
+bool RecipeManager::parseIngredientsFile(const std::string &filename, std::vector<Ingredient> &out)
+{
+  std::ifstream ingredientsFile(filename, std::ios::binary);
+  if (!ingredientsFile.is_open())
+  {
+    std::cerr << "File " << filename << " not found or cannot be opened." << std::endl;
+    return false;
+  }
+  std::string content;
+  ingredientsFile.seekg(0, std::ios::end);
+  content.resize(static_cast<size_t>(ingredientsFile.tellg()));
+  ingredientsFile.seekg(0, std::ios::beg);
+  ingredientsFile.read(&content[0], static_cast<std::streamsize>(content.size()));
+
+  std::string_view rest(content);
+  std::string error;
+  size_t lineNumber = 0;
+  while (!rest.empty())
+  {
+    size_t eol = rest.find('\n');
+    std::string_view line = trimView(rest.substr(0, eol));
+    rest.remove_prefix(eol == std::string_view::npos ? rest.size() : eol + 1);
+    ++lineNumber;
+    if (line.empty())
+    {
+      continue;
+    }
+
+    Ingredient ingredient;
+    if (parseIngredientLine(line, ingredient, error))
+    {
+      out.push_back(std::move(ingredient));
+    }
+    else
+    {
+      std::cerr << filename << ":" << lineNumber << ": " << error << ", line skipped.\n";
+    }
+  }
+  std::cerr.flush();
+  return true;
+}
+
 /**
  * @brief Loads ingredients from a CSV file into the internal list.
  *
- * The function opens the specified file and reads it line-by-line using std::getline().
  * Each line is expected to follow this format:
  *   "name,quantity,unit"
  *
- * For each line:
- * - The string is split using ',' as delimiter with std::getline()
- * - Leading/trailing spaces are trimmed using trim()
- * - Quantity is parsed via std::stoi()
- * - A new Ingredient object is constructed and added to the vector
+ * See parseIngredientsFile() for the parsing rules and error reporting.
+ * The loaded ingredients are remembered per file so reloadIngredientsFromFile()
+ * can later apply only the difference.
  *
  * If the file cannot be opened, an error message is printed and execution stops early.
  *
@@ -36,25 +227,112 @@ using json = nlohmann::json;
  */
 void RecipeManager::loadIngredientsFromFile(const std::string &filename)
 {
-  std::ifstream ingredientsFile(filename);
-  if (!ingredientsFile.is_open())
+  std::vector<Ingredient> parsed;
+  if (!parseIngredientsFile(filename, parsed))
   {
-    std::cerr << "File " << filename << " not found or cannot be opened." << std::endl;
     return;
   }
 
-  std::string line;
-  while (std::getline(ingredientsFile, line))
+  std::lock_guard<std::mutex> lock(mutex);
+  auto &loaded = fileIngredients[filename];
+  auto pantry = std::make_shared<Pantry>(*latest().pantry);
+  pantry->reserve(pantry->size() + parsed.size());
+  for (const auto &ingredient : parsed)
   {
-    std::istringstream ss(line);
-    std::string name;
+    loaded[ingredient.nameId] = ingredient;
+    pantry->put(ingredient);
+  }
+  swapSnapshot(latest().catalog, std::move(pantry));
+}
 
-    if (std::getline(ss, name, ','))
-    {
-      name = trim(name);
-      ingredients.push_back({name});
-    }
+/**
+ * @brief Re-reads an ingredients file and applies the difference.
+ *
+ * The ingredients loaded from the file last time are compared with its current
+ * contents by name. Only removed, added or changed (quantity or unit) entries
+ * are touched, so ingredients that were added manually (or come from another
+ * file) survive the reload. The changes are made on a copy of the pantry,
+ * published in one swap.
+ *
+ * @param [in] filename Path to the input file
+ */
+void RecipeManager::reloadIngredientsFromFile(const std::string &filename)
+{
+  std::vector<Ingredient> parsed;
+  if (!parseIngredientsFile(filename, parsed))
+  {
+    return;
+  }
+  FlatHashMap<std::uint32_t, Ingredient> inFile;
+  inFile.reserve(parsed.size());
+  for (const auto &ingredient : parsed)
+  {
+    inFile[ingredient.nameId] = ingredient;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex);
+  auto &previous = fileIngredients[filename];
+  auto pantry = std::make_shared<Pantry>(*latest().pantry);
+  size_t added = 0;
+  size_t removed = 0;
+  size_t changed = 0;
+
+  previous.forEach(
+      [&](std::uint32_t nameId, const Ingredient &)
+      {
+        if (!inFile.contains(nameId) && pantry->remove(nameId))
+        {
+          ++removed;
+        }
+      });
+  inFile.forEach(
+      [&](std::uint32_t nameId, const Ingredient &ingredient)
+      {
+        const Ingredient *old = previous.find(nameId);
+        if (old == nullptr)
+        {
+          pantry->put(ingredient);
+          ++added;
+        }
+        else if (*old != ingredient)
+        {
+          pantry->put(ingredient);
+          ++changed;
+        }
+      });
+  previous = std::move(inFile);
+  swapSnapshot(latest().catalog, std::move(pantry));
+
+  std::cout << "\n[reload] " << filename << ": +" << added << " -" << removed
+            << " ~" << changed << " ingredients" << std::endl;
+}
+
+/**
+ * @brief Opens the pantry write-ahead log and merges its contents.
+ *
+ * Persisted ingredients replace file-loaded ones with the same name, since
+ * they record a later manual change.
+ *
+ * @param [in] logFile Path to the write-ahead log
+ * @param [in] snapshotFile Path to the compacted snapshot
+ */
+void RecipeManager::openPantryLog(const std::string &logFile, const std::string &snapshotFile)
+{
+  auto log = std::make_unique<PantryLog>(logFile, snapshotFile);
+  std::vector<Ingredient> persisted;
+  if (!log->open(persisted))
+  {
+    return;
   }
+
+  std::lock_guard<std::mutex> lock(mutex);
+  auto pantry = std::make_shared<Pantry>(*latest().pantry);
+  for (const auto &ingredient : persisted)
+  {
+    pantry->put(ingredient);
+  }
+  swapSnapshot(latest().catalog, std::move(pantry));
+  pantryLog = std::move(log);
 }
 
 /**
@@ -67,29 +345,58 @@ void RecipeManager::loadIngredientsFromFile(const std::string &filename)
  *
  * After adding one ingredient, the user is asked whether to continue.
  * Input is trimmed and normalized to handle whitespace and case variations.
+ * An ingredient that is already in the pantry has its quantity and unit replaced.
+ *
+ * The additions are collected and published with one pantry copy when the
+ * user stops. If the pantry log is open, they are then queued for the next
+ * group commit; the prompt never waits for the disk.
  *
  * @note This function uses std::ws to skip leading whitespace when reading lines.
  */
 void RecipeManager::manuallyAddIngredients()
 {
+  OutputSink &out = OutputSink::console();
+  std::vector<PantryUpdate> pending;
   bool isAdd = true;
   while (isAdd)
   {
-    std::cout << "Adding a new ingredient." << std::endl;
+    out << "Adding a new ingredient.\n";
 
     std::string name;
-    std::cout << "Ingredient name: ";
+    out << "Ingredient name: ";
+    out.flush();
     std::getline(std::cin >> std::ws, name);
+    name = std::string(trimView(name));
 
-    ingredients.push_back({name});
-    std::cout << "Ingredient " << name << " added successfully!" << std::endl;
+    int quantity;
+    do
+    {
+      out << "Quantity: ";
+    } while (!getIntegerInput(quantity, 0, 1000000));
+
+    Unit unit;
+    std::string unitText;
+    while (true)
+    {
+      out << "Unit (grams, milliliters, units, cloves, slices, pieces, stalks): ";
+      out.flush();
+      std::getline(std::cin >> std::ws, unitText);
+      if (parseUnit(trimView(unitText), unit))
+        break;
+      out << "Unknown unit.\n\n";
+    }
+
+    Ingredient ingredient(name, quantity * Ingredient::quantityScale, unit);
+    bool isNew = !inPantry(pending, ingredient.nameId);
+    pending.push_back({PantryLog::Op::Put, std::move(ingredient)});
+    out << "Ingredient " << name << (isNew ? " added" : " updated") << " successfully!\n";
 
     int choice;
     do
     {
-      std::cout << "1. Yes\n";
-      std::cout << "2. No\n";
-      std::cout << "Want to add another ingredient? (1/2): ";
+      out << "1. Yes\n";
+      out << "2. No\n";
+      out << "Want to add another ingredient? (1/2): ";
     } while (!getIntegerInput(choice, 1, 2));
 
     if (choice == 2)
@@ -97,6 +404,100 @@ void RecipeManager::manuallyAddIngredients()
       isAdd = false;
     }
   }
+  applyPantryUpdates(pending);
+}
+
+/**
+ * @brief Removes consumed ingredients by name until the user stops.
+ *
+ * Unknown names are checked against the dictionary and the pantry filter
+ * first. The removals are collected and published with one pantry copy when
+ * the user stops.
+ */
+void RecipeManager::removeIngredients()
+{
+  OutputSink &out = OutputSink::console();
+  std::vector<PantryUpdate> pending;
+  bool isRemove = true;
+  while (isRemove)
+  {
+    std::string name;
+    out << "Ingredient to remove: ";
+    out.flush();
+    std::getline(std::cin >> std::ws, name);
+    name = std::string(trimView(name));
+
+    std::uint32_t nameId = IngredientDictionary::shared().find(name);
+    bool removed = nameId != IngredientDictionary::npos && inPantry(pending, nameId);
+    if (removed)
+    {
+      pending.push_back({PantryLog::Op::Remove, Ingredient(name, 0, Unit::Unknown)});
+    }
+    out << "Ingredient " << name << (removed ? " removed." : " is not in the pantry.") << '\n';
+
+    int choice;
+    do
+    {
+      out << "1. Yes\n";
+      out << "2. No\n";
+      out << "Want to remove another ingredient? (1/2): ";
+    } while (!getIntegerInput(choice, 1, 2));
+
+    if (choice == 2)
+    {
+      isRemove = false;
+    }
+  }
+  if (!pending.empty())
+  {
+    applyPantryUpdates(pending);
+  }
+}
+
+/**
+ * @brief Applies a batch with one pantry copy and one published snapshot.
+ *
+ * Availability needs no update of its own: the cache is keyed by the pantry
+ * fingerprint, so the next query sees the new pantry's results. The log is
+ * appended under the mutex, so it records updates in the order they were
+ * applied.
+ */
+void RecipeManager::applyPantryUpdates(const std::vector<PantryUpdate> &batch)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  auto pantry = std::make_shared<Pantry>(*latest().pantry);
+  for (const PantryUpdate &update : batch)
+  {
+    if (update.op == PantryLog::Op::Put)
+    {
+      pantry->put(update.ingredient);
+    }
+    else
+    {
+      pantry->remove(update.ingredient.nameId);
+    }
+    if (pantryLog)
+    {
+      pantryLog->append(update.op, update.ingredient);
+    }
+  }
+  swapSnapshot(latest().catalog, std::move(pantry));
+}
+
+/**
+ * @brief Scans the pending edits backwards, so the last one for the name decides.
+ */
+bool RecipeManager::inPantry(const std::vector<PantryUpdate> &pending, std::uint32_t nameId)
+{
+  for (auto update = pending.rbegin(); update != pending.rend(); ++update)
+  {
+    if (update->ingredient.nameId == nameId)
+    {
+      return update->op == PantryLog::Op::Put;
+    }
+  }
+  PinnedSnapshot snapshot = pin();
+  return snapshot.pantry().contains(nameId);
 }
 
 /**
@@ -112,13 +513,85 @@ void RecipeManager::manuallyAddIngredients()
  */
 void RecipeManager::showAllIngredients()
 {
-  std::cout << "\nShowing ALL ingredients on program\n"
-            << std::endl;
-  for (const auto &ingredient : ingredients)
+  OutputSink &out = OutputSink::console();
+  PinnedSnapshot snapshot = pin();
+  out << "\nShowing ALL ingredients on program\n\n";
+  for (const auto &ingredient : snapshot.pantry().items())
+  {
+    out << "- " << ingredient.name() << ": "
+        << formatQuantity(ingredient.quantity) << " " << unitName(ingredient.unit) << '\n';
+  }
+  out << '\n';
+  out.flush();
+}
+
+namespace
+{
+  constexpr size_t loadChunkBytes = 1 << 20; ///< Bytes of a recipe file read per pipeline step
+
+  /**
+   * @brief Builds a recipe from its JSON object; missing fields take default values.
+   */
+  Recipe recipeFromJson(const json &recipeJson)
+  {
+    int id = recipeJson.value("id", 0);
+    std::string recipe_name = recipeJson.value("name", "");
+    std::string instructions = recipeJson.value("instructions", "");
+    std::vector<Ingredient> recipe_ingredients;
+    for (const auto &ingJson : recipeJson["ingredients"])
+    {
+      std::string name = ingJson.value("name", "");
+      std::int32_t quantity = quantityFromDouble(ingJson.value("quantity", 0.0));
+      Unit unit = Unit::Unknown;
+      parseUnit(ingJson.value("unit", ""), unit);
+      recipe_ingredients.emplace_back(name, quantity, unit);
+    }
+    return Recipe(id, recipe_name, recipe_ingredients, instructions);
+  }
+
+  /**
+   * @brief Recipes parsed from one chunk, or why the chunk could not be parsed.
+   */
+  struct ParsedRecipes
   {
-    std::cout << "- " << ingredient.name << std::endl;
+    std::vector<Recipe> recipes;
+    std::string error;
+  };
+
+  /**
+   * @brief Read stage: the next chunk of whole recipe objects, or nothing at the end of the array.
+   */
+  AsyncTask<std::optional<JsonChunk>> readRecipeChunk(JsonArrayReader &reader)
+  {
+    JsonChunk chunk;
+    if (!reader.next(chunk))
+    {
+      co_return std::nullopt;
+    }
+    co_return chunk;
+  }
+
+  /**
+   * @brief Parse stage: JSON objects to recipes, interning ingredient names on the way.
+   */
+  AsyncTask<ParsedRecipes> parseRecipeChunk(JsonChunk chunk)
+  {
+    ParsedRecipes parsed;
+    parsed.recipes.reserve(chunk.elements.size());
+    try
+    {
+      for (const auto &element : chunk.elements)
+      {
+        const char *text = chunk.text.data();
+        parsed.recipes.push_back(recipeFromJson(json::parse(text + element.first, text + element.second)));
+      }
+    }
+    catch (const json::exception &e)
+    {
+      parsed.error = e.what();
+    }
+    co_return parsed;
   }
-  std::cout << std::endl;
 }
 
 /**
@@ -134,133 +607,1443 @@ void RecipeManager::showAllIngredients()
  * and constructed with empty strings or zero quantity if not present.
  *
  * @param [in] filename Path to the JSON file containing recipe data
+ * @param [out] out Parsed recipes, in file order
+ * @return false if the file cannot be opened or is not valid JSON
  */
-void RecipeManager::loadRecipesFromJson(const std::string &filename)
+bool RecipeManager::parseRecipesFile(const std::string &filename, std::vector<Recipe> &out)
 {
   std::ifstream recipesFile(filename);
   if (!recipesFile.is_open())
   {
     std::cerr << "File " << filename << " not found or cannot be opened." << std::endl;
-    return;
+    return false;
   }
   json j;
-  recipesFile >> j;
+  try
+  {
+    recipesFile >> j;
+  }
+  catch (const json::exception &e)
+  {
+    // A file caught mid-save by the watcher is reported and retried on the next change.
+    std::cerr << "File " << filename << " is not valid JSON: " << e.what() << std::endl;
+    return false;
+  }
   for (const auto &recipeJson : j)
   {
-    int id = recipeJson.value("id", 0);
-    std::string recipe_name = recipeJson.value("name", "");
-    std::string instructions = recipeJson.value("instructions", "");
-    std::vector<Ingredient> recipe_ingredients;
-    for (const auto &ingJson : recipeJson["ingredients"])
-    {
-      std::string name = ingJson.value("name", "");
-      int quantity = ingJson.value("quantity", 0);
-      std::string unit = ingJson.value("unit", "");
-      recipe_ingredients.push_back({name, quantity, unit});
-    }
-    recipes.push_back(Recipe(id, recipe_name, recipe_ingredients, instructions));
+    out.push_back(recipeFromJson(recipeJson));
   }
+  return true;
 }
 
 /**
- * @brief Displays the ID and name of every stored recipe.
+ * @brief Appends parsed recipes to the catalog, skipping duplicate ids.
  *
- * Iterates through the internal recipes vector and prints:
- * - ID followed by ". "
- * - Recipe name
- * - Outpud: "1. Spanish Omelette"
+ * @param [in] filename File the recipes were read from
+ * @param [in] parsed Recipes to append
+ * @param [out] catalog Unpublished catalog to append to
+ * @return Number of recipes added
  */
-void RecipeManager::showAllRecipes() const
+size_t RecipeManager::mergeRecipes(const std::string &filename, std::vector<Recipe> &parsed, RecipeCatalog &catalog)
 {
-  std::cout << "\nShowing ALL recipes on database\n"
-            << std::endl;
-  for (const auto &recipe : recipes)
+  auto &owned = fileRecipes[filename];
+  size_t added = 0;
+  for (auto &recipe : parsed)
   {
-    std::cout << recipe.id << ". " << recipe.recipe_name << std::endl;
+    std::uint32_t existing = catalog.recipeIndex.find(recipe.id);
+    if (existing != IdIndex::npos)
+    {
+      std::cerr << "Duplicate recipe id " << recipe.id << " in " << filename
+                << " (already used by \"" << catalog.store.view(existing).name() << "\"), skipped." << std::endl;
+      continue;
+    }
+    recipe.instructions = catalog.codec->encode(recipe.instructions);
+    catalog.add(recipe);
+    owned.insert(recipe.id);
+    ++added;
   }
-  std::cout << "" << std::endl;
+  return added;
 }
 
 /**
- * @brief Shows only recipes that can be made with current ingredients.
+ * @brief Trains the instruction dictionary on the first recipes loaded.
  *
- * For each recipe, checks:
- * - All required ingredients exist in the ingredients list
- * - Quantities match or exceed what's needed
- * - Units of measure are identical
+ * Training happens before those recipes are merged, so every instruction
+ * is encoded exactly once on its way into the store. A catalog that already
+ * stores recipes keeps its codec, trained or not: its instructions were
+ * encoded with it and would not decode with another dictionary.
  *
- * A recipe is shown only if all its ingredients meet these conditions.
+ * @param [in] corpus Raw instructions of the recipes about to be merged
+ * @param [out] catalog Unpublished catalog that receives the trained codec
  */
-void RecipeManager::showAvailableRecipes() const
+void RecipeManager::trainInstructionCodec(const std::vector<std::string_view> &corpus, RecipeCatalog &catalog)
 {
-  std::cout << "\nAvailable recipes with your ingredients are:\n"
-            << std::endl;
-  for (const auto &recipe : recipes)
+  if (catalog.codec->trained() || catalog.store.size() != 0 || corpus.empty())
   {
-    bool isPossible = true;
-    for (const auto &reqIngr : recipe.ingredients)
-    {
-      bool found = false;
-      for (const auto &haveIngr : ingredients)
-      {
-        if (reqIngr.name == haveIngr.name)
-        {
-          found = true;
-          break;
-        }
-      }
-      if (!found)
-      {
-        isPossible = false;
-        break;
-      }
-    }
-    if (isPossible)
-    {
-      std::cout << recipe.id << ". " << recipe.recipe_name << std::endl;
-    }
+    return;
   }
-  std::cout << std::endl;
+  auto codec = std::make_shared<TextCodec>();
+  codec->train(corpus);
+  catalog.codec = std::move(codec);
 }
 
 /**
- * @brief Allows the user to select a recipe and view full details.
+ * @brief Loads recipes from a JSON file and appends them to the catalog.
  *
- * Lists all available recipes and prompts the user to choose one by number.
- * On valid selection, displays:
- * - Recipe name
- * - Required ingredients (name, quantity, unit)
- * - Instructions
+ * Recipes whose id is already loaded are reported and skipped. See
+ * streamRecipes() for how the file is read and published.
  *
- * If no recipes are available or the selection is invalid, appropriate messages are shown.
+ * @param [in] filename Path to the JSON file containing recipe data
  */
-void RecipeManager::selectRecipe()
+void RecipeManager::loadRecipesFromJson(const std::string &filename)
+{
+  startLoadingRecipes(filename);
+  waitForRecipes();
+}
+
+/**
+ * @brief Checks the file and the catalog on the calling thread, then hands the load to the scheduler.
+ *
+ * The file is registered in fileRecipes before the load starts, so a
+ * watcher started meanwhile watches it.
+ */
+void RecipeManager::startLoadingRecipes(const std::string &filename)
 {
-  if (recipes.empty())
+  waitForRecipes();
+  std::error_code ec;
+  if (std::filesystem::is_directory(filename, ec))
   {
-    std::cout << "No recipes available." << std::endl;
+    std::cerr << "File " << filename << " is a directory, not a recipe file." << std::endl;
     return;
   }
-  std::cout << "\nAvailable recipes:\n"
-            << std::endl;
-  for (size_t i = 0; i < recipes.size(); ++i)
-  {
-    std::cout << i + 1 << ". " << recipes[i].recipe_name << std::endl;
-  }
-  int choice;
-  std::cout << "Select a recipe (number): ";
-  if (!getIntegerInput(choice, 1, static_cast<int>(recipes.size())))
+  JsonArrayReader reader(filename, loadChunkBytes);
+  if (!reader.isOpen())
   {
+    std::cerr << "File " << filename << " not found or cannot be opened." << std::endl;
     return;
   }
-  const Recipe &selected = recipes[choice - 1];
-  std::cout << "\n--- " << selected.recipe_name << " ---" << std::endl;
-  std::cout << "Ingredients:" << std::endl;
-  for (const auto &ing : selected.ingredients)
   {
-    std::cout << "- " << ing.name << ": "
-              << ing.quantity << " " << ing.unit << std::endl;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (latest().catalog->store.readOnly())
+    {
+      std::cerr << "The recipe catalog is a read-only shared image, " << filename << " not loaded." << std::endl;
+      return;
+    }
+    fileRecipes[filename];
+  }
+  recipeLoad.start(TaskScheduler::shared(), streamRecipes(filename, std::move(reader)));
+}
+
+/**
+ * @brief Streams a recipe file through three overlapping stages.
+ *
+ * While chunk n is indexed (instructions encoded, recipes appended to the
+ * next catalog under the writer lock), chunk n + 1 is parsed and chunk n + 2
+ * read, each stage a coroutine spawned on the shared TaskScheduler. The
+ * pipeline itself never blocks a worker: it is suspended while it waits for
+ * a stage. The instruction codec is trained on the first chunk.
+ *
+ * The catalog is published after the first chunk, then each time the
+ * number of recipes indexed doubles: queries see the start of the file
+ * early, and the version started after a publish shares its pages, copying
+ * only the last, partly filled one. A malformed file is reported and keeps
+ * the chunks indexed before the error.
+ */
+AsyncTask<> RecipeManager::streamRecipes(std::string filename, JsonArrayReader reader)
+{
+  auto start = std::chrono::steady_clock::now();
+  TaskScheduler &scheduler = TaskScheduler::shared();
+  std::shared_ptr<RecipeCatalog> next; ///< Catalog being indexed, null right after a publish
+  size_t allocations = 0;
+  size_t allocationsBefore = 0;
+  size_t indexed = 0;
+  size_t published = 0;
+  bool failed = false;
+
+  auto publish = [&]()
+  {
+    allocations += next->arenaStats().allocations - allocationsBefore;
+    next->loadAllocations = allocations;
+    next->loadMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    swapSnapshot(std::move(next), latest().pantry);
+    published = indexed;
+  };
+
+  Spawned<std::optional<JsonChunk>> reading = spawn(scheduler, readRecipeChunk(reader));
+  Spawned<ParsedRecipes> parsing;
+  while (reading.valid() || parsing.valid())
+  {
+    std::optional<JsonChunk> chunk;
+    if (reading.valid())
+    {
+      chunk = co_await reading;
+      if (!chunk && !reader.error().empty())
+      {
+        std::cerr << "File " << filename << " is not valid JSON: " << reader.error() << std::endl;
+      }
+    }
+    bool stop = failed || cancelLoad.load();
+    if (chunk && !stop)
+    {
+      reading = spawn(scheduler, readRecipeChunk(reader));
+    }
+    bool haveRecipes = parsing.valid();
+    ParsedRecipes parsed;
+    if (haveRecipes)
+    {
+      parsed = co_await parsing;
+    }
+    if (chunk && !stop)
+    {
+      parsing = spawn(scheduler, parseRecipeChunk(std::move(*chunk)));
+    }
+    if (!haveRecipes || stop)
+    {
+      continue;
+    }
+    if (!parsed.error.empty())
+    {
+      std::cerr << "File " << filename << " is not valid JSON: " << parsed.error << std::endl;
+      failed = true;
+      continue;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!next)
+    {
+      next = copyCatalog();
+      allocationsBefore = next->arenaStats().allocations;
+      std::vector<std::string_view> corpus;
+      for (const auto &recipe : parsed.recipes)
+      {
+        corpus.push_back(recipe.instructions);
+      }
+      trainInstructionCodec(corpus, *next);
+    }
+    indexed += mergeRecipes(filename, parsed.recipes, *next);
+    if (indexed > published && indexed >= 2 * published)
+    {
+      publish();
+    }
+  }
+
+  if (next)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    publish();
+  }
+}
+
+/**
+ * @brief Loads every recipe file listed by a manifest, or found in a directory.
+ *
+ * The files are sorted by size, largest first, and parsed concurrently on
+ * the shared TaskScheduler, one file per task. Starting with the largest
+ * files keeps one big file from being picked up last and leaving the other
+ * workers idle at the end.
+ *
+ * Parsing happens without holding the writer lock. The results are then
+ * merged in manifest order, so duplicate ids are resolved deterministically
+ * (the first file listed wins) regardless of which thread finished first,
+ * and every file becomes visible to queries at once.
+ *
+ * @param [in] path Manifest file or directory
+ */
+void RecipeManager::loadRecipesFromManifest(const std::string &path)
+{
+  waitForRecipes();
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (latest().catalog->store.readOnly())
+    {
+      std::cerr << "The recipe catalog is a read-only shared image, " << path << " not loaded." << std::endl;
+      return;
+    }
+  }
+  namespace fs = std::filesystem;
+  std::vector<std::string> files;
+  std::error_code ec;
+
+  if (fs::is_directory(path, ec))
+  {
+    for (const auto &entry : fs::recursive_directory_iterator(path, ec))
+    {
+      if (entry.is_regular_file() && entry.path().extension() == ".json")
+      {
+        files.push_back(entry.path().string());
+      }
+    }
+    std::sort(files.begin(), files.end());
+  }
+  else
+  {
+    std::ifstream manifest(path);
+    if (!manifest.is_open())
+    {
+      std::cerr << "File " << path << " not found or cannot be opened." << std::endl;
+      return;
+    }
+    fs::path base = fs::path(path).parent_path();
+    std::string line;
+    while (std::getline(manifest, line))
+    {
+      std::string_view entry = trimView(line);
+      if (entry.empty() || entry.front() == '#')
+      {
+        continue;
+      }
+      fs::path file(entry);
+      files.push_back((file.is_relative() ? base / file : file).string());
+    }
+  }
+  if (files.empty())
+  {
+    std::cerr << "No recipe files found in " << path << "." << std::endl;
+    return;
+  }
+
+  struct FileLoad
+  {
+    std::vector<Recipe> recipes;
+    bool ok = false;
+    double milliseconds = 0;
+  };
+  std::vector<FileLoad> loads(files.size());
+
+  std::vector<size_t> order(files.size());
+  std::vector<std::uintmax_t> sizes(files.size());
+  for (size_t i = 0; i < files.size(); ++i)
+  {
+    order[i] = i;
+    sizes[i] = fs::file_size(files[i], ec);
+    if (ec)
+      sizes[i] = 0;
+  }
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+                   { return sizes[a] > sizes[b]; });
+
+  auto start = std::chrono::steady_clock::now();
+  TaskScheduler &scheduler = TaskScheduler::shared();
+  scheduler.parallelFor(
+      0, order.size(), 1,
+      [&](size_t begin, size_t end)
+      {
+        for (size_t i = begin; i < end; ++i)
+        {
+          size_t file = order[i];
+          auto fileStart = std::chrono::steady_clock::now();
+          loads[file].ok = parseRecipesFile(files[file], loads[file].recipes);
+          loads[file].milliseconds = std::chrono::duration<double, std::milli>(
+                                         std::chrono::steady_clock::now() - fileStart)
+                                         .count();
+        }
+      });
+  size_t threadCount = std::min(files.size(), scheduler.workerCount());
+  double parseMilliseconds = std::chrono::duration<double, std::milli>(
+                                 std::chrono::steady_clock::now() - start)
+                                 .count();
+
+  std::vector<std::string_view> corpus;
+  for (const auto &load : loads)
+  {
+    for (const auto &recipe : load.recipes)
+    {
+      corpus.push_back(recipe.instructions);
+    }
+  }
+
+  size_t total = 0;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::shared_ptr<RecipeCatalog> next = copyCatalog();
+    size_t allocationsBefore = next->arenaStats().allocations;
+    trainInstructionCodec(corpus, *next);
+    for (size_t i = 0; i < files.size(); ++i)
+    {
+      if (!loads[i].ok)
+      {
+        continue;
+      }
+      size_t parsed = loads[i].recipes.size();
+      size_t added = mergeRecipes(files[i], loads[i].recipes, *next);
+      total += added;
+      std::cout << "Loaded " << added << "/" << parsed << " recipes from " << files[i]
+                << " (" << sizes[i] << " bytes) in " << loads[i].milliseconds << " ms" << std::endl;
+    }
+    next->loadAllocations = next->arenaStats().allocations - allocationsBefore;
+    next->loadMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    swapSnapshot(std::move(next), latest().pantry);
   }
-  std::cout << "\nInstructions: " << selected.instructions << std::endl;
-  std::cout << std::endl;
-}
\ No newline at end of file
+  std::cout << "Loaded " << total << " recipes from " << files.size() << " files on "
+            << threadCount << " threads in " << parseMilliseconds << " ms\n"
+            << std::endl;
+}
+
+/**
+ * @brief Re-reads a JSON recipe file and applies the difference by recipe id.
+ *
+ * The file is parsed and diffed outside the lock, against the published
+ * catalog and a copy of the ids this file contributed last time. The lock is
+ * held to copy those ids and, if anything changed, to apply the change to a
+ * new version that shares the unchanged pages and index chunks of the
+ * published one, so the swap costs time proportional to the change, plus
+ * one pointer per page and an amortized compaction. If another writer
+ * replaced the catalog while the diff ran, the diff is computed again.
+ * Queries keep reading the old catalog meanwhile. Recipes loaded from other
+ * files are never touched; an id already owned by another file is reported
+ * as a duplicate.
+ *
+ * @param [in] filename Path to the JSON file
+ */
+void RecipeManager::reloadRecipesFromJson(const std::string &filename)
+{
+  waitForRecipes();
+  std::vector<Recipe> parsed;
+  if (!parseRecipesFile(filename, parsed))
+  {
+    return;
+  }
+
+  std::vector<Recipe> added;
+  std::vector<Recipe> changed;
+  std::vector<int> removed;
+  std::vector<int> duplicates;
+  while (true)
+  {
+    std::shared_ptr<const RecipeCatalog> base;
+    std::unordered_set<int> owned;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      base = latest().catalog;
+      if (base->store.readOnly())
+      {
+        std::cerr << "The recipe catalog is a read-only shared image, " << filename << " not reloaded." << std::endl;
+        return;
+      }
+      owned = fileRecipes[filename];
+    }
+
+    std::unordered_set<int> seen;
+    added.clear();
+    changed.clear();
+    removed.clear();
+    duplicates.clear();
+    for (const auto &parsedRecipe : parsed)
+    {
+      if (!seen.insert(parsedRecipe.id).second)
+      {
+        continue;
+      }
+      Recipe recipe = parsedRecipe;
+      recipe.instructions = base->codec->encode(recipe.instructions);
+      std::uint32_t slot = base->recipeIndex.find(recipe.id);
+      if (slot == IdIndex::npos)
+      {
+        added.push_back(std::move(recipe));
+      }
+      else if (owned.count(recipe.id) == 0)
+      {
+        duplicates.push_back(recipe.id);
+        seen.erase(recipe.id);
+      }
+      else if (!base->store.equals(slot, recipe))
+      {
+        changed.push_back(std::move(recipe));
+      }
+    }
+    for (int id : owned)
+    {
+      if (seen.count(id) == 0)
+      {
+        removed.push_back(id);
+      }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (latest().catalog != base)
+    {
+      continue;
+    }
+    if (!added.empty() || !changed.empty() || !removed.empty())
+    {
+      auto &files = fileRecipes[filename];
+      std::shared_ptr<RecipeCatalog> next = copyCatalog();
+      for (int id : removed)
+      {
+        next->erase(next->recipeIndex.find(id));
+        files.erase(id);
+      }
+      for (auto &recipe : changed)
+      {
+        next->store.replace(next->recipeIndex.find(recipe.id), recipe);
+      }
+      for (auto &recipe : added)
+      {
+        next->add(recipe);
+        files.insert(recipe.id);
+      }
+      swapSnapshot(std::move(next), latest().pantry);
+    }
+    break;
+  }
+
+  for (int id : duplicates)
+  {
+    std::cerr << "Duplicate recipe id " << id << " in " << filename << ", skipped." << std::endl;
+  }
+  std::cout << "\n[reload] " << filename << ": +" << added.size() << " -" << removed.size()
+            << " ~" << changed.size() << " recipes" << std::endl;
+}
+
+bool RecipeManager::publishCatalog(const std::string &name) const
+{
+  PinnedSnapshot snapshot = pin();
+  const RecipeCatalog &catalog = snapshot.catalog();
+  if (!CatalogImage::publish(name, catalog.store, *catalog.codec))
+  {
+    return false;
+  }
+  std::cout << "Published " << catalog.store.size() << " recipes as shared catalog " << name << "." << std::endl;
+  return true;
+}
+
+/**
+ * @brief Maps a published image and publishes a catalog attached to it.
+ *
+ * The image's ingredient names are interned first, in id order; this only
+ * gives back the publisher's ids if the dictionary is still empty, which is
+ * why attaching must come before any load. Only recipeIndex is rebuilt
+ * locally, in O(recipes).
+ *
+ * @param [in] name Shared memory object name given to publishCatalog()
+ * @return true if the catalog was attached
+ */
+bool RecipeManager::attachCatalog(const std::string &name)
+{
+  waitForRecipes();
+  auto image = std::make_unique<CatalogImage>();
+  if (!image->attach(name))
+  {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex);
+  if (!latest().catalog->store.empty())
+  {
+    std::cerr << "Recipes are already loaded, shared catalog " << name << " not attached." << std::endl;
+    return false;
+  }
+  IngredientDictionary &dictionary = IngredientDictionary::shared();
+  std::vector<std::string_view> names = image->names();
+  for (std::uint32_t id = 0; id < names.size(); ++id)
+  {
+    if (dictionary.intern(names[id]) != id)
+    {
+      std::cerr << "Ingredient ids of shared catalog " << name
+                << " do not match this process, it must be attached before loading ingredients." << std::endl;
+      return false;
+    }
+  }
+
+  auto next = std::make_shared<RecipeCatalog>(bulkResource);
+  auto codec = std::make_shared<TextCodec>();
+  codec->load(image->phrases());
+  next->codec = std::move(codec);
+  next->store.attach(image->columns());
+  for (std::uint32_t slot = 0; slot < next->store.size(); ++slot)
+  {
+    next->recipeIndex.assign(next->store.view(slot).id(), slot);
+  }
+  next->image = std::move(image);
+  std::cout << "Attached shared catalog " << name << ": " << next->store.size() << " recipes, "
+            << next->image->bytes() << " bytes." << std::endl;
+  swapSnapshot(std::move(next), latest().pantry);
+  return true;
+}
+
+/**
+ * @brief Starts the background watcher for the data files.
+ *
+ * Every recipe file loaded so far is watched and reloaded with
+ * reloadRecipesFromJson(); changes to the ingredients file are applied with
+ * reloadIngredientsFromFile().
+ *
+ * @param [in] ingredientsFile Path to the ingredients file
+ */
+void RecipeManager::startWatching(const std::string &ingredientsFile)
+{
+  std::vector<std::string> paths{ingredientsFile};
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto &entry : fileRecipes)
+    {
+      paths.push_back(entry.first);
+    }
+  }
+  watcher = std::make_unique<FileWatcher>(
+      paths,
+      [this, ingredientsFile](const std::string &path)
+      {
+        if (path == ingredientsFile)
+        {
+          reloadIngredientsFromFile(path);
+        }
+        else
+        {
+          reloadRecipesFromJson(path);
+        }
+      });
+  watcher->start();
+}
+
+/**
+ * @brief Displays the ID and name of every stored recipe.
+ *
+ * Iterates through the internal recipes vector and prints:
+ * - ID followed by ". "
+ * - Recipe name
+ * - Outpud: "1. Spanish Omelette"
+ */
+void RecipeManager::showAllRecipes() const
+{
+  OutputSink &out = OutputSink::console();
+  PinnedSnapshot snapshot = pin();
+  const RecipeStore &store = snapshot.catalog().store;
+  out << "\nShowing ALL recipes on database\n\n";
+  for (std::uint32_t slot = 0; slot < store.size(); ++slot)
+  {
+    RecipeView recipe = store.view(slot);
+    out << recipe.id() << ". " << recipe.name() << '\n';
+  }
+  out << '\n';
+  out.flush();
+}
+
+/**
+ * @brief Shows only recipes that can be made with current ingredients.
+ *
+ * A recipe is shown only if all its ingredients are in the pantry, see
+ * findAvailableRecipes().
+ */
+void RecipeManager::showAvailableRecipes() const
+{
+  OutputSink &out = OutputSink::console();
+  PinnedSnapshot snapshot = pin();
+  const RecipeStore &store = snapshot.catalog().store;
+  std::vector<std::uint32_t> slots;
+  availableRecipes(snapshot.catalog(), snapshot.pantry(), slots);
+  out << "\nAvailable recipes with your ingredients are:\n\n";
+  for (std::uint32_t slot : slots)
+  {
+    RecipeView recipe = store.view(slot);
+    out << recipe.id() << ". " << recipe.name() << '\n';
+  }
+  out << '\n';
+  out.flush();
+}
+
+namespace
+{
+  constexpr size_t scanGrain = 16 * 1024; ///< Slots scanned per task; smaller catalogs are scanned inline
+
+  /**
+   * @brief Collects, in store order, the slots for which a predicate holds.
+   *
+   * Catalogs larger than scanGrain are split across the shared TaskScheduler;
+   * each chunk collects its own slots and the chunks are concatenated in
+   * order, so the result does not depend on the number of workers.
+   *
+   * @param [in] store Catalog to scan
+   * @param [in] matches bool matches(RecipeView), called concurrently
+   * @param [out] slots Matching slots (cleared first)
+   */
+  template <typename Predicate>
+  void scanSlots(const RecipeStore &store, const Predicate &matches, std::vector<std::uint32_t> &slots)
+  {
+    auto scan = [&](size_t begin, size_t end, std::vector<std::uint32_t> &out)
+    {
+      // A page at a time, so the column pointers are loaded once per page.
+      for (std::uint32_t slot = static_cast<std::uint32_t>(begin); slot < end;)
+      {
+        const RecipeStore::Columns &page = store.pageOf(slot);
+        size_t pageEnd = std::min<size_t>(end, slot - slot % RecipeStore::pageSlots + page.size);
+        for (; slot < pageEnd; ++slot)
+        {
+          if (matches(RecipeView(page, slot)))
+          {
+            out.push_back(slot);
+          }
+        }
+      }
+    };
+    slots.clear();
+    if (store.size() <= scanGrain)
+    {
+      scan(0, store.size(), slots);
+      return;
+    }
+    using Slots = std::vector<std::uint32_t>;
+    Slots found = TaskScheduler::shared().parallelReduce<Slots>(
+        0, store.size(), scanGrain,
+        [&](size_t begin, size_t end)
+        {
+          Slots part;
+          scan(begin, end, part);
+          return part;
+        },
+        [](Slots left, Slots right)
+        {
+          left.insert(left.end(), right.begin(), right.end());
+          return left;
+        });
+    slots.assign(found.begin(), found.end());
+  }
+}
+
+namespace
+{
+  /**
+   * @brief Checks every recipe against a pantry with a contains(nameId) test.
+   *
+   * A recipe is available if all its ingredients are in the pantry. The pantry
+   * signature rules most recipes out before their ingredients are read; the
+   * rest are checked one ingredient at a time.
+   */
+  template <typename AnyPantry>
+  void scanAvailable(const RecipeStore &store, const AnyPantry &pantry, std::uint64_t pantrySignature,
+                     std::vector<std::uint32_t> &slots)
+  {
+    auto isPossible = [&](RecipeView recipe)
+    {
+      if (recipe.signature() & ~pantrySignature)
+      {
+        return false;
+      }
+      for (const Ingredient &reqIngr : recipe.ingredients())
+      {
+        if (!pantry.contains(reqIngr.nameId))
+        {
+          return false;
+        }
+      }
+      return true;
+    };
+    scanSlots(store, isPossible, slots);
+  }
+}
+
+void RecipeManager::findAvailableRecipes(const RecipeStore &store, const Pantry &pantry,
+                                         std::vector<std::uint32_t> &slots)
+{
+  std::uint64_t pantrySignature = 0;
+  for (const auto &haveIngr : pantry.items())
+  {
+    pantrySignature |= signatureBit(haveIngr.nameId);
+  }
+  scanAvailable(store, pantry, pantrySignature, slots);
+}
+
+void RecipeManager::findAvailableRecipes(const RecipeStore &store, const TenantPantry &pantry,
+                                         std::vector<std::uint32_t> &slots)
+{
+  std::uint64_t pantrySignature = 0;
+  for (std::uint32_t nameId : pantry.ids())
+  {
+    pantrySignature |= signatureBit(nameId);
+  }
+  scanAvailable(store, pantry, pantrySignature, slots);
+}
+
+/**
+ * @brief Answers from the availability cache, or scans and caches the result.
+ *
+ * The cache key is the pantry fingerprint, which covers the names in the
+ * pantry only: changing a quantity does not change which recipes can be
+ * made. A result is stored as a bitmap over the catalog slots and turned
+ * back into slots on a hit, in store order like a scan. A tenant pantry and
+ * the process pantry with the same names share their entry.
+ */
+template <typename AnyPantry>
+void RecipeManager::availableRecipes(const RecipeCatalog &catalog, const AnyPantry &pantry,
+                                     std::vector<std::uint32_t> &slots) const
+{
+  std::shared_ptr<const AvailabilityCache::Bitmap> cached = availability.find(catalog.version, pantry.fingerprint());
+  if (!cached)
+  {
+    findAvailableRecipes(catalog.store, pantry, slots);
+    auto bitmap = std::make_shared<AvailabilityCache::Bitmap>((catalog.store.size() + 63) / 64);
+    for (std::uint32_t slot : slots)
+    {
+      (*bitmap)[slot / 64] |= std::uint64_t(1) << (slot % 64);
+    }
+    availability.insert(catalog.version, pantry.fingerprint(), std::move(bitmap));
+    return;
+  }
+
+  slots.clear();
+  for (size_t word = 0; word < cached->size(); ++word)
+  {
+    for (std::uint64_t bits = (*cached)[word]; bits != 0; bits &= bits - 1)
+    {
+      slots.push_back(static_cast<std::uint32_t>(word * 64 + static_cast<size_t>(__builtin_ctzll(bits))));
+    }
+  }
+}
+
+/**
+ * @brief Allows the user to select a recipe and view full details.
+ *
+ * Lists all available recipes and prompts the user to choose one by number.
+ * On valid selection, displays:
+ * - Recipe name
+ * - Required ingredients (name, quantity, unit)
+ * - Instructions
+ *
+ * If no recipes are available or the selection is invalid, appropriate messages are shown.
+ */
+void RecipeManager::selectRecipe()
+{
+  OutputSink &out = OutputSink::console();
+  size_t count;
+  {
+    PinnedSnapshot snapshot = pin();
+    const RecipeStore &store = snapshot.catalog().store;
+    if (store.empty())
+    {
+      out << "No recipes available.\n";
+      return;
+    }
+    out << "\nAvailable recipes:\n\n";
+    for (std::uint32_t i = 0; i < store.size(); ++i)
+    {
+      out << i + 1 << ". " << store.view(i).name() << '\n';
+    }
+    count = store.size();
+  }
+  int choice;
+  out << "Select a recipe (number): ";
+  if (!getIntegerInput(choice, 1, static_cast<int>(count)))
+  {
+    return;
+  }
+
+  // The catalog may have been hot reloaded while waiting for input; the
+  // snapshot is not kept pinned meanwhile so old versions can be freed.
+  PinnedSnapshot snapshot = pin();
+  const RecipeCatalog &catalog = snapshot.catalog();
+  if (static_cast<size_t>(choice) > catalog.store.size())
+  {
+    out << "The recipe list changed, please select again.\n";
+    return;
+  }
+  printRecipe(catalog.store.view(static_cast<std::uint32_t>(choice - 1)), *catalog.codec, out);
+}
+
+/**
+ * @brief Displays a recipe.
+ *
+ * Output format:
+ *   --- Name ---
+ *   Ingredients:
+ *   - name: quantity unit
+ *   Instructions: ...
+ *
+ * @param [in] recipe Recipe to print
+ * @param [in] codec Codec of the catalog the recipe belongs to
+ * @param [in] out Sink to print to; it is not flushed
+ */
+void RecipeManager::printRecipe(RecipeView recipe, const TextCodec &codec, OutputSink &out)
+{
+  out << "\n--- " << recipe.name() << " ---\n";
+  out << "Ingredients:\n";
+  for (const Ingredient &ing : recipe.ingredients())
+  {
+    out << "- " << ing.name() << ": "
+        << formatQuantity(ing.quantity) << " " << unitName(ing.unit) << '\n';
+  }
+  out << "\nInstructions: " << codec.decode(recipe.instructions()) << "\n\n";
+}
+
+/**
+ * @brief Looks a recipe up through the id index and copies it out.
+ *
+ * The copy holds decoded instructions, so it stays valid after the snapshot
+ * is unpinned and the catalog changes.
+ *
+ * @param [in] id Recipe id
+ * @return The recipe, or std::nullopt if the id is unknown
+ */
+std::optional<Recipe> RecipeManager::findRecipeById(int id) const
+{
+  PinnedSnapshot snapshot = pin();
+  const RecipeCatalog &catalog = snapshot.catalog();
+  std::uint32_t slot = catalog.recipeIndex.find(id);
+  if (slot == IdIndex::npos)
+  {
+    return std::nullopt;
+  }
+  RecipeView recipe = catalog.store.view(slot);
+  IngredientRange ingredients = recipe.ingredients();
+  return Recipe(recipe.id(),
+                std::string(recipe.name()),
+                std::vector<Ingredient>(ingredients.begin(), ingredients.end()),
+                catalog.codec->decode(recipe.instructions()));
+}
+
+/**
+ * @brief Asks for a recipe id and displays the recipe with that id.
+ *
+ * If no recipe has the id, a message is shown instead.
+ */
+void RecipeManager::selectRecipeById() const
+{
+  OutputSink &out = OutputSink::console();
+  int id;
+  out << "Recipe id: ";
+  if (!getIntegerInput(id, std::numeric_limits<int>::min(), std::numeric_limits<int>::max()))
+  {
+    return;
+  }
+
+  PinnedSnapshot snapshot = pin();
+  const RecipeCatalog &catalog = snapshot.catalog();
+  std::uint32_t slot = catalog.recipeIndex.find(id);
+  if (slot == IdIndex::npos)
+  {
+    out << "No recipe with id " << id << ".\n";
+    return;
+  }
+  printRecipe(catalog.store.view(slot), *catalog.codec, out);
+}
+
+namespace
+{
+  /**
+   * @brief Returns true if text contains the needle, ignoring ASCII case.
+   *
+   * @param [in] text Text to search
+   * @param [in] lowerNeedle Text to find, already lower case
+   */
+  bool containsIgnoreCase(std::string_view text, std::string_view lowerNeedle)
+  {
+    auto match = std::search(text.begin(), text.end(), lowerNeedle.begin(), lowerNeedle.end(),
+                             [](char a, char b)
+                             { return std::tolower(static_cast<unsigned char>(a)) == b; });
+    return match != text.end() || lowerNeedle.empty();
+  }
+}
+
+void RecipeManager::findRecipesByName(const RecipeStore &store, std::string_view text,
+                                      std::vector<std::uint32_t> &slots)
+{
+  std::string needle(text);
+  std::transform(needle.begin(), needle.end(), needle.begin(), [](unsigned char c)
+                 { return static_cast<char>(std::tolower(c)); });
+  auto matches = [&](RecipeView recipe)
+  { return containsIgnoreCase(recipe.name(), needle); };
+  scanSlots(store, matches, slots);
+}
+
+/**
+ * @brief Reads queries until the end of the input and answers each one.
+ *
+ * The line buffer and the slot buffer are reused, so a query allocates
+ * nothing beyond what its reply needs. Replies are formatted straight into
+ * the sink's buffer, which goes to the stream every 64 KiB.
+ *
+ * A run of "add" queries is collected and applied with one pantry copy when
+ * another query, or the end of the input, needs the result, instead of one
+ * copy and one snapshot per line.
+ */
+size_t RecipeManager::runQueries(std::istream &in, std::ostream &out, ResultFormat format)
+{
+  OutputSink sink(out);
+  ResultWriter writer(sink, format);
+  std::string line;
+  std::vector<std::uint32_t> slots;
+  std::vector<PantryUpdate> pending;
+  size_t answered = 0;
+  while (std::getline(in, line))
+  {
+    std::string_view query = trimView(line);
+    if (query.empty() || query.front() == '#')
+    {
+      continue;
+    }
+    size_t space = query.find(' ');
+    std::string_view command = query.substr(0, space);
+    std::string_view argument = space == std::string_view::npos ? std::string_view() : trimView(query.substr(space));
+    if (!pending.empty() && command != "add")
+    {
+      applyPantryUpdates(pending);
+      pending.clear();
+    }
+    answerQuery(command, argument, writer, slots, pending);
+    ++answered;
+  }
+  if (!pending.empty())
+  {
+    applyPantryUpdates(pending);
+  }
+  sink.flush();
+  return answered;
+}
+
+void RecipeManager::answerQuery(std::string_view command, std::string_view argument, ResultWriter &writer,
+                                std::vector<std::uint32_t> &slots, std::vector<PantryUpdate> &pending)
+{
+  if (command == "available")
+  {
+    PinnedSnapshot snapshot = pin();
+    availableRecipes(snapshot.catalog(), snapshot.pantry(), slots);
+    writer.recipes(snapshot.catalog().store, slots);
+  }
+  else if (command == "search")
+  {
+    PinnedSnapshot snapshot = pin();
+    findRecipesByName(snapshot.catalog().store, argument, slots);
+    writer.recipes(snapshot.catalog().store, slots);
+  }
+  else if (command == "recipe")
+  {
+    int id;
+    auto parsed = std::from_chars(argument.data(), argument.data() + argument.size(), id);
+    if (argument.empty() || parsed.ec != std::errc() || parsed.ptr != argument.data() + argument.size())
+    {
+      writer.error("invalid recipe id '" + std::string(argument) + "'");
+      return;
+    }
+    PinnedSnapshot snapshot = pin();
+    const RecipeCatalog &catalog = snapshot.catalog();
+    std::uint32_t slot = catalog.recipeIndex.find(id);
+    if (slot == IdIndex::npos)
+    {
+      writer.error("no recipe with id " + std::to_string(id));
+      return;
+    }
+    writer.recipe(catalog.store.view(slot), *catalog.codec);
+  }
+  else if (command == "pantry")
+  {
+    PinnedSnapshot snapshot = pin();
+    writer.ingredients(snapshot.pantry().items());
+  }
+  else if (command == "add")
+  {
+    Ingredient ingredient;
+    std::string error;
+    if (argument.empty() || !parseIngredientLine(argument, ingredient, error))
+    {
+      writer.error(argument.empty() ? "missing ingredient" : error);
+      return;
+    }
+    pending.push_back({PantryLog::Op::Put, std::move(ingredient)});
+    writer.done();
+  }
+  else if (command == "starter")
+  {
+    size_t space = argument.find(' ');
+    if (argument.empty() || space == std::string_view::npos)
+    {
+      writer.error("usage: starter <name> <ingredient>, ...");
+      return;
+    }
+    std::vector<std::uint32_t> nameIds;
+    std::string_view list = argument.substr(space + 1);
+    while (!list.empty())
+    {
+      size_t comma = list.find(',');
+      std::string_view name = trimView(list.substr(0, comma));
+      if (!name.empty())
+      {
+        nameIds.push_back(IngredientDictionary::shared().intern(name));
+      }
+      list = comma == std::string_view::npos ? std::string_view() : list.substr(comma + 1);
+    }
+    tenants.defineStarter(std::string(argument.substr(0, space)), std::move(nameIds));
+    writer.done();
+  }
+  else if (command == "tenant")
+  {
+    answerTenantQuery(argument, writer, slots);
+  }
+  else
+  {
+    writer.error("unknown command '" + std::string(command) + "'");
+  }
+}
+
+void RecipeManager::answerTenantQuery(std::string_view argument, ResultWriter &writer,
+                                      std::vector<std::uint32_t> &slots)
+{
+  size_t space = argument.find(' ');
+  std::string_view idText = argument.substr(0, space);
+  std::string_view rest = space == std::string_view::npos ? std::string_view() : trimView(argument.substr(space));
+  std::uint64_t tenant;
+  auto parsed = std::from_chars(idText.data(), idText.data() + idText.size(), tenant);
+  if (idText.empty() || parsed.ec != std::errc() || parsed.ptr != idText.data() + idText.size())
+  {
+    writer.error("invalid tenant id '" + std::string(idText) + "'");
+    return;
+  }
+  space = rest.find(' ');
+  std::string_view verb = rest.substr(0, space);
+  std::string_view operand = space == std::string_view::npos ? std::string_view() : trimView(rest.substr(space));
+
+  if (verb == "available")
+  {
+    TenantPantryStore::PantryPtr pantry = tenants.find(tenant);
+    if (!pantry)
+    {
+      writer.error("no tenant " + std::to_string(tenant));
+      return;
+    }
+    PinnedSnapshot snapshot = pin();
+    availableRecipes(snapshot.catalog(), *pantry, slots);
+    writer.recipes(snapshot.catalog().store, slots);
+  }
+  else if (verb == "new")
+  {
+    if (!tenants.createTenant(tenant, operand))
+    {
+      writer.error("no starter pantry '" + std::string(operand) + "'");
+      return;
+    }
+    writer.done();
+  }
+  else if (verb == "add" || verb == "remove")
+  {
+    if (operand.empty())
+    {
+      writer.error("missing ingredient");
+      return;
+    }
+    std::uint32_t nameId = IngredientDictionary::shared().intern(operand);
+    if (verb == "add")
+    {
+      tenants.put(tenant, nameId);
+    }
+    else if (!tenants.remove(tenant, nameId))
+    {
+      writer.error("tenant " + std::to_string(tenant) + " has no " + std::string(operand));
+      return;
+    }
+    writer.done();
+  }
+  else if (verb == "drop")
+  {
+    if (!tenants.eraseTenant(tenant))
+    {
+      writer.error("no tenant " + std::to_string(tenant));
+      return;
+    }
+    writer.done();
+  }
+  else
+  {
+    writer.error("unknown tenant command '" + std::string(verb) + "'");
+  }
+}
+
+/**
+ * @brief Encodes the reply payload of a binary request, see queryProtocol.hpp.
+ *
+ * The slot buffer is per thread, so a worker reuses it across requests.
+ */
+QueryProtocol::Status RecipeManager::answerRequest(std::uint8_t op, std::string_view payload, std::string &out)
+{
+  using namespace QueryProtocol;
+  static thread_local std::vector<std::uint32_t> slots;
+  PinnedSnapshot snapshot = pin();
+  const RecipeCatalog &catalog = snapshot.catalog();
+
+  switch (static_cast<Op>(op))
+  {
+  case Op::Available:
+  case Op::Search:
+  case Op::TenantAvailable:
+    if (static_cast<Op>(op) == Op::Available)
+    {
+      availableRecipes(catalog, snapshot.pantry(), slots);
+    }
+    else if (static_cast<Op>(op) == Op::Search)
+    {
+      findRecipesByName(catalog.store, payload, slots);
+    }
+    else
+    {
+      if (payload.size() != 8)
+      {
+        return Status::BadRequest;
+      }
+      TenantPantryStore::PantryPtr pantry = tenants.find(getU64(payload.data()));
+      if (!pantry)
+      {
+        return Status::NotFound;
+      }
+      availableRecipes(catalog, *pantry, slots);
+    }
+    putU32(out, static_cast<std::uint32_t>(slots.size()));
+    for (std::uint32_t slot : slots)
+    {
+      RecipeView recipe = catalog.store.view(slot);
+      putI32(out, recipe.id());
+      putShortString(out, recipe.name());
+    }
+    return Status::Ok;
+  case Op::Detail:
+  {
+    if (payload.size() != 4)
+    {
+      return Status::BadRequest;
+    }
+    std::uint32_t slot = catalog.recipeIndex.find(getI32(payload.data()));
+    if (slot == IdIndex::npos)
+    {
+      return Status::NotFound;
+    }
+    RecipeView recipe = catalog.store.view(slot);
+    putI32(out, recipe.id());
+    putShortString(out, recipe.name());
+    putU16(out, static_cast<std::uint16_t>(recipe.ingredientCount()));
+    for (const Ingredient &ing : recipe.ingredients())
+    {
+      putShortString(out, ing.name());
+      putI32(out, ing.quantity);
+      out.push_back(static_cast<char>(ing.unit));
+    }
+    std::string instructions = catalog.codec->decode(recipe.instructions());
+    putU32(out, static_cast<std::uint32_t>(instructions.size()));
+    out += instructions;
+    return Status::Ok;
+  }
+  case Op::PantryPut:
+  case Op::PantryRemove:
+  {
+    if (payload.size() < 2 || payload.size() < 2 + size_t(getU16(payload.data())))
+    {
+      return Status::BadRequest;
+    }
+    std::string_view name = trimView(payload.substr(2, getU16(payload.data())));
+    std::string_view rest = payload.substr(2 + getU16(payload.data()));
+    PantryUpdate update;
+    if (static_cast<Op>(op) == Op::PantryPut)
+    {
+      if (name.empty() || rest.size() != 5 || getI32(rest.data()) < 0 ||
+          static_cast<std::uint8_t>(rest[4]) > static_cast<std::uint8_t>(Unit::Stalks))
+      {
+        return Status::BadRequest;
+      }
+      // Known names are free; new ones are interned for good, so they are
+      // counted and capped.
+      std::uint32_t nameId = IngredientDictionary::shared().find(name);
+      if (nameId == IngredientDictionary::npos)
+      {
+        if (requestNames.load(std::memory_order_relaxed) >= maxRequestNames ||
+            !IngredientDictionary::shared().tryIntern(name, nameId))
+        {
+          return Status::BadRequest;
+        }
+        requestNames.fetch_add(1, std::memory_order_relaxed);
+      }
+      update.ingredient.nameId = nameId;
+      update.ingredient.quantity = getI32(rest.data());
+      update.ingredient.unit = static_cast<Unit>(rest[4]);
+    }
+    else
+    {
+      if (name.empty() || !rest.empty())
+      {
+        return Status::BadRequest;
+      }
+      update.op = PantryLog::Op::Remove;
+      update.ingredient.nameId = IngredientDictionary::shared().find(name);
+      if (update.ingredient.nameId == IngredientDictionary::npos)
+      {
+        return Status::NotFound;
+      }
+    }
+    submitPantryUpdate(update);
+    return Status::Ok;
+  }
+  }
+  return Status::BadRequest;
+}
+
+/**
+ * @brief Displays the instruction storage report.
+ *
+ * Memory for raw storage is what one std::string per recipe would use: the
+ * characters plus the terminator, heap allocated once they exceed the small
+ * string buffer. Compressed instructions are stored back to back in the
+ * recipe store's text pool, so they cost only their bytes plus the shared
+ * dictionary. Latency is measured by reading every instruction once in each
+ * mode: a plain copy for raw storage and a decode for compressed storage.
+ */
+void RecipeManager::showStorageReport() const
+{
+  OutputSink &out = OutputSink::console();
+  PinnedSnapshot snapshot = pin();
+  const RecipeCatalog &catalog = snapshot.catalog();
+  const RecipeStore &store = catalog.store;
+  const TextCodec &instructionCodec = *catalog.codec;
+  const size_t smallString = std::string().capacity();
+  size_t rawBytes = 0;
+  size_t rawHeap = 0;
+  size_t compressedBytes = 0;
+  std::vector<std::string> raw;
+  raw.reserve(store.size());
+
+  auto decodeStart = std::chrono::steady_clock::now();
+  for (std::uint32_t slot = 0; slot < store.size(); ++slot)
+  {
+    raw.push_back(instructionCodec.decode(store.view(slot).instructions()));
+  }
+  double decodeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - decodeStart).count();
+
+  size_t checksum = 0;
+  auto copyStart = std::chrono::steady_clock::now();
+  for (const auto &text : raw)
+  {
+    std::string copy(text);
+    checksum += copy.size();
+  }
+  double copyMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - copyStart).count();
+
+  for (std::uint32_t i = 0; i < store.size(); ++i)
+  {
+    rawBytes += raw[i].size();
+    rawHeap += raw[i].size() > smallString ? raw[i].size() + 1 : 0;
+    compressedBytes += store.view(i).instructions().size();
+  }
+  size_t dictionaryBytes = instructionCodec.dictionaryBytes();
+  double perRecipe = store.empty() ? 0.0 : 1e6 / static_cast<double>(store.size());
+
+  out << "\nInstruction storage (" << store.size() << " recipes, "
+      << instructionCodec.size() << " dictionary phrases)\n\n";
+  out << "Raw std::string:  " << rawBytes << " bytes of text, " << rawHeap << " bytes on the heap, "
+      << copyMs * perRecipe << " ns per read\n";
+  out << "Compressed:       " << compressedBytes << " bytes in the text pool, " << dictionaryBytes
+      << " bytes of dictionary, " << decodeMs * perRecipe << " ns per read\n";
+  if (rawBytes > 0 && checksum == rawBytes)
+  {
+    out << "Compression ratio: " << static_cast<double>(compressedBytes + dictionaryBytes) / static_cast<double>(rawBytes)
+        << " (including dictionary)\n";
+  }
+
+  // Without the arena every request below would be its own heap allocation.
+  AllocationStats requests = catalog.arenaStats();
+  AllocationStats blocks = catalog.blockStats();
+  out << "\nCatalog arena\n\n";
+  out << "Last load:        " << catalog.loadMilliseconds << " ms, "
+      << catalog.loadAllocations << " allocations served by the arena\n";
+  out << "Arena requests:   " << requests.allocations << " allocations, "
+      << requests.bytesLive << " bytes live of " << requests.bytesAllocated << " bytes handed out\n";
+  out << "Heap blocks:      " << blocks.allocations - blocks.deallocations << " blocks, "
+      << blocks.bytesLive << " bytes reserved\n";
+  out << "All arenas:       " << catalog.store.arenaBytes() << " bytes reserved, with the earlier versions' arenas its pages share\n";
+  out << '\n';
+}
+
+namespace
+{
+  /**
+   * @brief Estimates the bytes of a node-based unordered container.
+   *
+   * Each element is a heap node holding the value, a next pointer and a
+   * cached hash; the bucket array holds one pointer per bucket.
+   */
+  template <typename Container>
+  MemoryUsage nodeContainerBytes(const Container &container)
+  {
+    size_t node = sizeof(typename Container::value_type) + sizeof(void *) + sizeof(size_t);
+    size_t buckets = container.bucket_count() * sizeof(void *);
+    return {container.size() * sizeof(typename Container::value_type), container.size() * node + buckets};
+  }
+}
+
+/**
+ * @brief Collects the memory held by every component of the manager.
+ *
+ * Only the published snapshot is counted; versions retired but not freed
+ * yet, still pinned by a query, are not. The ingredient dictionary is shared
+ * by the whole process and reported here in full. The writer lock is taken
+ * for the reload bookkeeping only after the snapshot has been measured.
+ */
+MemoryReport RecipeManager::memoryUsage() const
+{
+  MemoryReport report;
+  {
+    PinnedSnapshot snapshot = pin();
+    snapshot.catalog().memoryUsage(report);
+    report.add("ingredient dictionary", IngredientDictionary::shared().memoryUsage());
+    report.add("pantry", snapshot.pantry().memoryUsage());
+  }
+  report.add("availability cache", availability.memoryUsage());
+  report.add("tenant pantries", tenants.memoryUsage());
+
+  std::lock_guard<std::mutex> lock(mutex);
+  MemoryUsage bookkeeping = nodeContainerBytes(fileIngredients);
+  for (const auto &entry : fileIngredients)
+  {
+    bookkeeping += entry.second.memoryUsage();
+    bookkeeping += {entry.first.size(), stringHeapBytes(entry.first)};
+  }
+  bookkeeping += nodeContainerBytes(fileRecipes);
+  for (const auto &entry : fileRecipes)
+  {
+    bookkeeping += nodeContainerBytes(entry.second);
+    bookkeeping += {entry.first.size(), stringHeapBytes(entry.first)};
+  }
+  bookkeeping.reserved = std::max(bookkeeping.reserved, bookkeeping.used);
+  report.add("reload bookkeeping", bookkeeping);
+  return report;
+}
+
+/**
+ * @brief Prints the memory report and, if the user agrees, saves it as JSON.
+ *
+ * @param [in] jsonFile Path the JSON report is written to
+ */
+void RecipeManager::showMemoryUsage(const std::string &jsonFile) const
+{
+  OutputSink &out = OutputSink::console();
+  MemoryReport report = memoryUsage();
+  out << "\nMemory usage (bytes)\n\n";
+  report.print(out);
+  AvailabilityCacheStats cache = availability.stats();
+  out << "\nAvailability cache: " << cache.entries << " results, " << cache.hits << " hits, " << cache.misses
+      << " misses, " << cache.evictions << " evictions\n";
+  TenantPantryStats tenantStats = tenants.stats();
+  out << "Tenant pantries: " << tenantStats.tenants << " tenants sharing " << tenantStats.distinct
+      << " distinct pantries, " << tenantStats.starters << " starters\n";
+  if (bulkResource == &hugePages)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    HugePageStats pages = hugePages.stats();
+    out << "\nHuge pages: " << pages.explicitBytes << " bytes reserved (MAP_HUGETLB), "
+        << pages.transparentBytes << " bytes transparent, " << pages.upstreamBytes << " bytes on normal pages\n";
+  }
+  out << '\n';
+
+  int choice;
+  do
+  {
+    out << "1. Yes\n";
+    out << "2. No\n";
+    out << "Save the report as JSON to " << jsonFile << "? (1/2): ";
+  } while (!getIntegerInput(choice, 1, 2));
+  if (choice == 2)
+  {
+    return;
+  }
+
+  std::ofstream file(jsonFile);
+  if (!file.is_open())
+  {
+    std::cerr << "File " << jsonFile << " cannot be opened for writing." << std::endl;
+    return;
+  }
+  file << report.toJson() << std::endl;
+  out << "Memory report saved to " << jsonFile << ".\n";
+}
@@ -0,0 +1,438 @@
+/**
+ * @file recipeStore.cpp
+ * @brief Implementation of the RecipeStore columnar catalog storage.
+ */
+
+#include "../include/recipeStore.hpp"
+#include <algorithm>
+#include <atomic>
+#include <type_traits>
+
+/**
+ * @struct RecipeStore::Arena
+ * @brief Monotonic arena of one store, with counters on both sides.
+ */
+struct RecipeStore::Arena
+{
+  explicit Arena(std::pmr::memory_resource *upstream)
+      : blocks(upstream),
+        buffer(64 * 1024, &blocks),
+        requests(&buffer)
+  {
+  }
+
+  CountingResource blocks;                    ///< Counts the blocks the arena takes from upstream
+  std::pmr::monotonic_buffer_resource buffer; ///< Arena holding the pages' columns
+  CountingResource requests;                  ///< Counts the allocations served by the arena
+};
+
+namespace
+{
+  IngredientRange ingredientsOf(const Recipe &recipe)
+  {
+    const Ingredient *first = recipe.ingredients.data();
+    return {first, first + recipe.ingredients.size()};
+  }
+}
+
+/**
+ * @brief Creates an empty page; an owned page reserves every slot up front.
+ *
+ * @param [in] arena Arena of the columns, or null for a page of attached columns
+ */
+RecipeStore::Page::Page(std::shared_ptr<Arena> arena)
+    : arena(std::move(arena)),
+      ids(resource()),
+      signatures(resource()),
+      ingredientOffsets(resource()),
+      ingredientCounts(resource()),
+      ingredients(resource()),
+      nameOffsets(resource()),
+      textLengths(resource()),
+      text(resource())
+{
+  if (this->arena)
+  {
+    ids.reserve(pageSlots);
+    signatures.reserve(pageSlots);
+    ingredientOffsets.reserve(pageSlots);
+    ingredientCounts.reserve(pageSlots);
+    nameOffsets.reserve(pageSlots);
+    textLengths.reserve(pageSlots);
+  }
+}
+
+std::pmr::memory_resource *RecipeStore::Page::resource() const
+{
+  return arena ? &arena->requests : std::pmr::new_delete_resource();
+}
+
+void RecipeStore::Page::refresh()
+{
+  cols.size = static_cast<std::uint32_t>(ids.size());
+  cols.ids = ids.data();
+  cols.signatures = signatures.data();
+  cols.nameOffsets = nameOffsets.data();
+  cols.ingredientOffsets = ingredientOffsets.data();
+  cols.ingredientCounts = ingredientCounts.data();
+  cols.textLengths = textLengths.data();
+  cols.ingredients = ingredients.data();
+  cols.ingredientCount = ingredients.size();
+  cols.text = text.data();
+  cols.textBytes = text.size();
+}
+
+/**
+ * @brief Appends the ingredients and text of a recipe and points a slot at them.
+ *
+ * @param [in] at Slot of the page whose columns are updated
+ */
+void RecipeStore::Page::write(std::uint32_t at, int id, IngredientRange recipeIngredients,
+                              std::string_view name, std::string_view instructions)
+{
+  ids[at] = id;
+  ingredientOffsets[at] = static_cast<std::uint32_t>(ingredients.size());
+  ingredientCounts[at] = static_cast<std::uint32_t>(recipeIngredients.size());
+  ingredients.insert(ingredients.end(), recipeIngredients.begin(), recipeIngredients.end());
+  std::uint64_t signature = 0;
+  for (const Ingredient &ingredient : recipeIngredients)
+  {
+    signature |= signatureBit(ingredient.nameId);
+  }
+  signatures[at] = signature;
+
+  nameOffsets[at] = static_cast<std::uint32_t>(text.size());
+  textLengths[at] = {static_cast<std::uint32_t>(name.size()), static_cast<std::uint32_t>(instructions.size())};
+  text.insert(text.end(), name.begin(), name.end());
+  text.insert(text.end(), instructions.begin(), instructions.end());
+  refresh();
+}
+
+void RecipeStore::Page::push(int id, IngredientRange recipeIngredients, std::string_view name,
+                             std::string_view instructions)
+{
+  ids.push_back(0);
+  signatures.push_back(0);
+  nameOffsets.push_back(0);
+  ingredientOffsets.push_back(0);
+  ingredientCounts.push_back(0);
+  textLengths.push_back({0, 0});
+  write(static_cast<std::uint32_t>(ids.size() - 1), id, recipeIngredients, name, instructions);
+}
+
+/**
+ * @brief Drops the last slot of the page; its data stays in the pools.
+ */
+void RecipeStore::Page::pop()
+{
+  ids.pop_back();
+  signatures.pop_back();
+  nameOffsets.pop_back();
+  ingredientOffsets.pop_back();
+  ingredientCounts.pop_back();
+  textLengths.pop_back();
+  refresh();
+}
+
+/**
+ * @brief Returns the bytes of the page's vectors, spare capacity included.
+ */
+size_t RecipeStore::Page::bytes() const
+{
+  return ids.capacity() * sizeof(int) +
+         signatures.capacity() * sizeof(std::uint64_t) +
+         (nameOffsets.capacity() + ingredientOffsets.capacity() + ingredientCounts.capacity()) * sizeof(std::uint32_t) +
+         textLengths.capacity() * sizeof(TextLengths) +
+         ingredients.capacity() * sizeof(Ingredient) +
+         text.capacity();
+}
+
+RecipeStore::RecipeStore(std::pmr::memory_resource *upstream)
+    : arena(std::make_shared<Arena>(upstream))
+{
+}
+
+/**
+ * @brief Copies the live slots of a page into a new page, compacting the pools.
+ *
+ * The source may be an attached page.
+ */
+std::shared_ptr<RecipeStore::Page> RecipeStore::copyPage(const Page &from, const std::shared_ptr<Arena> &arena)
+{
+  const Columns &cols = from.cols;
+  auto page = std::make_shared<Page>(arena);
+  size_t liveIngredients = 0;
+  size_t liveText = 0;
+  for (std::uint32_t at = 0; at < cols.size; ++at)
+  {
+    liveIngredients += cols.ingredientCounts[at];
+    liveText += cols.textLengths[at].name + cols.textLengths[at].instructions;
+  }
+  page->ingredients.reserve(liveIngredients);
+  page->text.reserve(liveText);
+
+  for (std::uint32_t at = 0; at < cols.size; ++at)
+  {
+    const Ingredient *first = cols.ingredients + cols.ingredientOffsets[at];
+    const TextLengths &lengths = cols.textLengths[at];
+    const char *name = cols.text + cols.nameOffsets[at];
+    page->push(cols.ids[at], {first, first + cols.ingredientCounts[at]},
+               std::string_view(name, lengths.name), std::string_view(name + lengths.name, lengths.instructions));
+  }
+  return page;
+}
+
+/**
+ * @brief Returns a page only this store holds, in this store's arena.
+ *
+ * A page no other store holds any more is written in place; the acquire
+ * fence orders those writes after the reads of the stores released on
+ * other threads.
+ */
+RecipeStore::Page &RecipeStore::writablePage(std::uint32_t page)
+{
+  std::shared_ptr<Page> &held = pages[page];
+  if (held.use_count() != 1 || held->arena != arena)
+  {
+    held = copyPage(*held, arena);
+  }
+  else
+  {
+    std::atomic_thread_fence(std::memory_order_acquire);
+  }
+  return *held;
+}
+
+/**
+ * @brief Lets go of the pages and reads from external columns instead, one page view at a time.
+ */
+void RecipeStore::attach(const Columns &external)
+{
+  clear();
+  for (std::uint32_t start = 0; start < external.size; start += pageSlots)
+  {
+    auto page = std::make_shared<Page>(nullptr);
+    Columns &cols = page->cols;
+    cols = external;
+    cols.size = std::min(pageSlots, external.size - start);
+    cols.ids += start;
+    cols.signatures += start;
+    cols.nameOffsets += start;
+    cols.ingredientOffsets += start;
+    cols.ingredientCounts += start;
+    cols.textLengths += start;
+    pages.push_back(std::move(page));
+  }
+  count = external.size;
+  attached = true;
+}
+
+std::uint32_t RecipeStore::append(const Recipe &recipe)
+{
+  std::uint32_t slot = count;
+  if ((slot & pageMask) == 0)
+  {
+    pages.push_back(std::make_shared<Page>(arena));
+  }
+  writablePage(slot >> pageBits).push(recipe.id, ingredientsOf(recipe), recipe.recipe_name, recipe.instructions);
+  ++count;
+  return slot;
+}
+
+/**
+ * @brief Replaces a recipe; its previous data becomes garbage.
+ */
+void RecipeStore::replace(std::uint32_t slot, const Recipe &recipe)
+{
+  Page &page = writablePage(slot >> pageBits);
+  std::uint32_t at = slot & pageMask;
+  page.deadIngredients += page.ingredientCounts[at];
+  page.deadText += page.textLengths[at].name + page.textLengths[at].instructions;
+  page.write(at, recipe.id, ingredientsOf(recipe), recipe.recipe_name, recipe.instructions);
+}
+
+/**
+ * @brief Removes a recipe in O(1); its data becomes garbage.
+ *
+ * Touches at most two pages: the one holding the slot and the last one. A
+ * recipe moved from the last page brings its data along, so pages stay
+ * self-contained.
+ */
+void RecipeStore::remove(std::uint32_t slot)
+{
+  std::uint32_t last = count - 1;
+  Page &hole = writablePage(slot >> pageBits);
+  std::uint32_t at = slot & pageMask;
+  hole.deadIngredients += hole.ingredientCounts[at];
+  hole.deadText += hole.textLengths[at].name + hole.textLengths[at].instructions;
+
+  if ((slot >> pageBits) == (last >> pageBits))
+  {
+    std::uint32_t from = last & pageMask;
+    if (at != from)
+    {
+      hole.ids[at] = hole.ids[from];
+      hole.signatures[at] = hole.signatures[from];
+      hole.nameOffsets[at] = hole.nameOffsets[from];
+      hole.ingredientOffsets[at] = hole.ingredientOffsets[from];
+      hole.ingredientCounts[at] = hole.ingredientCounts[from];
+      hole.textLengths[at] = hole.textLengths[from];
+    }
+    hole.pop();
+  }
+  else
+  {
+    Page &tail = writablePage(last >> pageBits);
+    RecipeView moved = view(last);
+    hole.write(at, moved.id(), moved.ingredients(), moved.name(), moved.instructions());
+    tail.deadIngredients += moved.ingredientCount();
+    tail.deadText += moved.name().size() + moved.instructions().size();
+    tail.pop();
+  }
+  if (pages.back()->cols.size == 0)
+  {
+    pages.pop_back();
+  }
+  --count;
+}
+
+/**
+ * @brief Compares a stored recipe with a Recipe value, cheapest fields first.
+ */
+bool RecipeStore::equals(std::uint32_t slot, const Recipe &recipe) const
+{
+  RecipeView stored = view(slot);
+  if (stored.id() != recipe.id ||
+      stored.ingredientCount() != recipe.ingredients.size() ||
+      stored.name() != recipe.recipe_name ||
+      stored.instructions() != recipe.instructions)
+  {
+    return false;
+  }
+  IngredientRange ingredients = stored.ingredients();
+  return std::equal(ingredients.begin(), ingredients.end(), recipe.ingredients.begin());
+}
+
+/**
+ * @brief Copies every page into another store's arena, compacting the pools.
+ *
+ * Slots keep their order, so indexes keyed by slot remain valid. The source
+ * may be attached; the destination must not be.
+ */
+void RecipeStore::copyTo(RecipeStore &dest) const
+{
+  dest.pages.reserve(pages.size());
+  for (const auto &page : pages)
+  {
+    dest.pages.push_back(copyPage(*page, dest.arena));
+  }
+  dest.count = count;
+}
+
+void RecipeStore::shareTo(RecipeStore &dest) const
+{
+  dest.pages = pages;
+  dest.count = count;
+}
+
+/**
+ * @brief Empties the store; pages no other store holds go back to their arena.
+ */
+void RecipeStore::clear()
+{
+  std::vector<std::shared_ptr<Page>>().swap(pages);
+  count = 0;
+  attached = false;
+}
+
+size_t RecipeStore::garbageBytes() const
+{
+  size_t bytes = 0;
+  for (const auto &page : pages)
+  {
+    bytes += page->deadIngredients * sizeof(Ingredient) + page->deadText;
+  }
+  return bytes;
+}
+
+size_t RecipeStore::pageBytes() const
+{
+  size_t bytes = 0;
+  for (const auto &page : pages)
+  {
+    bytes += page->bytes();
+  }
+  return bytes;
+}
+
+size_t RecipeStore::arenaBytes() const
+{
+  std::vector<const Arena *> arenas{arena.get()};
+  for (const auto &page : pages)
+  {
+    if (page->arena)
+      arenas.push_back(page->arena.get());
+  }
+  std::sort(arenas.begin(), arenas.end());
+  arenas.erase(std::unique(arenas.begin(), arenas.end()), arenas.end());
+  size_t bytes = 0;
+  for (const Arena *held : arenas)
+  {
+    bytes += held->blocks.stats().bytesLive;
+  }
+  return bytes;
+}
+
+AllocationStats RecipeStore::arenaStats() const
+{
+  return arena->requests.stats();
+}
+
+AllocationStats RecipeStore::blockStats() const
+{
+  return arena->blocks.stats();
+}
+
+/**
+ * @brief Reports the owned pages; an attached store owns nothing.
+ */
+void RecipeStore::memoryUsage(MemoryReport &report) const
+{
+  if (attached)
+    return;
+  auto bytes = [](const auto &column)
+  {
+    using Element = typename std::remove_reference_t<decltype(column)>::value_type;
+    return MemoryUsage{column.size() * sizeof(Element), column.capacity() * sizeof(Element)};
+  };
+
+  MemoryUsage columns = bytes(pages);
+  MemoryUsage ingredientArrays;
+  size_t nameBytes = 0;
+  size_t instructionBytes = 0;
+  size_t textReserved = 0;
+  for (const auto &page : pages)
+  {
+    columns += bytes(page->ids);
+    columns += bytes(page->signatures);
+    columns += bytes(page->nameOffsets);
+    columns += bytes(page->ingredientOffsets);
+    columns += bytes(page->ingredientCounts);
+    columns += bytes(page->textLengths);
+
+    MemoryUsage pageIngredients = bytes(page->ingredients);
+    pageIngredients.used -= page->deadIngredients * sizeof(Ingredient);
+    ingredientArrays += pageIngredients;
+
+    for (const TextLengths &lengths : page->textLengths)
+    {
+      nameBytes += lengths.name;
+      instructionBytes += lengths.instructions;
+    }
+    textReserved += page->text.capacity();
+  }
+  report.add("recipe columns", columns);
+  report.add("ingredient arrays", ingredientArrays);
+  report.add("names", {nameBytes, nameBytes});
+  report.add("instructions", {instructionBytes, textReserved - nameBytes});
+}
@@ -0,0 +1,336 @@
+/**
+ * @file resultWriter.cpp
+ * @brief Implementation of the ResultWriter class.
+ */
+
+#include "../include/resultWriter.hpp"
+
+bool parseResultFormat(std::string_view text, ResultFormat &out)
+{
+  if (text == "text")
+    out = ResultFormat::Text;
+  else if (text == "json")
+    out = ResultFormat::Json;
+  else if (text == "csv")
+    out = ResultFormat::Csv;
+  else
+    return false;
+  return true;
+}
+
+void ResultWriter::recipes(const RecipeStore &store, const std::vector<std::uint32_t> &slots)
+{
+  switch (format)
+  {
+  case ResultFormat::Text:
+    out << "OK " << slots.size() << '\n';
+    for (std::uint32_t slot : slots)
+    {
+      RecipeView recipe = store.view(slot);
+      out << recipe.id() << '\t';
+      textField(out, recipe.name());
+      out << '\n';
+    }
+    break;
+  case ResultFormat::Json:
+    out << "{\"ok\":true,\"count\":" << slots.size() << ",\"recipes\":[";
+    for (size_t i = 0; i < slots.size(); ++i)
+    {
+      RecipeView recipe = store.view(slots[i]);
+      out << (i == 0 ? "{\"id\":" : ",{\"id\":") << recipe.id() << ",\"name\":";
+      jsonString(out, recipe.name());
+      out << '}';
+    }
+    out << "]}\n";
+    break;
+  case ResultFormat::Csv:
+    out << "id,name\n";
+    for (std::uint32_t slot : slots)
+    {
+      RecipeView recipe = store.view(slot);
+      out << recipe.id() << ',';
+      csvField(out, recipe.name());
+      out << '\n';
+    }
+    out << '\n';
+    break;
+  }
+}
+
+/**
+ * @brief Writes a recipe; in CSV the id, name and instructions repeat on every ingredient line.
+ */
+void ResultWriter::recipe(RecipeView recipe, const TextCodec &codec)
+{
+  std::string instructions = codec.decode(recipe.instructions());
+  IngredientRange items = recipe.ingredients();
+  switch (format)
+  {
+  case ResultFormat::Text:
+    // Header line, one line per ingredient, instructions line.
+    out << "OK " << items.size() + 2 << '\n';
+    out << recipe.id() << '\t';
+    textField(out, recipe.name());
+    out << '\n';
+    for (const Ingredient &item : items)
+    {
+      ingredient(item);
+    }
+    textField(out, instructions);
+    out << '\n';
+    break;
+  case ResultFormat::Json:
+    out << "{\"ok\":true,\"recipe\":{\"id\":" << recipe.id() << ",\"name\":";
+    jsonString(out, recipe.name());
+    out << ",\"ingredients\":[";
+    for (const Ingredient &item : items)
+    {
+      if (&item != items.begin())
+      {
+        out << ',';
+      }
+      ingredient(item);
+    }
+    out << "],\"instructions\":";
+    jsonString(out, instructions);
+    out << "}}\n";
+    break;
+  case ResultFormat::Csv:
+    out << "id,name,ingredient,quantity,unit,instructions\n";
+    if (items.size() == 0)
+    {
+      out << recipe.id() << ',';
+      csvField(out, recipe.name());
+      out << ",,,,";
+      csvField(out, instructions);
+      out << '\n';
+    }
+    for (const Ingredient &item : items)
+    {
+      out << recipe.id() << ',';
+      csvField(out, recipe.name());
+      out << ',';
+      ingredient(item);
+      out << ',';
+      csvField(out, instructions);
+      out << '\n';
+    }
+    out << '\n';
+    break;
+  }
+}
+
+void ResultWriter::ingredients(const std::vector<Ingredient> &items)
+{
+  switch (format)
+  {
+  case ResultFormat::Text:
+    out << "OK " << items.size() << '\n';
+    for (const Ingredient &item : items)
+    {
+      ingredient(item);
+    }
+    break;
+  case ResultFormat::Json:
+    out << "{\"ok\":true,\"count\":" << items.size() << ",\"ingredients\":[";
+    for (size_t i = 0; i < items.size(); ++i)
+    {
+      if (i > 0)
+      {
+        out << ',';
+      }
+      ingredient(items[i]);
+    }
+    out << "]}\n";
+    break;
+  case ResultFormat::Csv:
+    out << "ingredient,quantity,unit\n";
+    for (const Ingredient &item : items)
+    {
+      ingredient(item);
+      out << '\n';
+    }
+    out << '\n';
+    break;
+  }
+}
+
+void ResultWriter::done()
+{
+  switch (format)
+  {
+  case ResultFormat::Text:
+    out << "OK 0\n";
+    break;
+  case ResultFormat::Json:
+    out << "{\"ok\":true}\n";
+    break;
+  case ResultFormat::Csv:
+    out << "status\nok\n\n";
+    break;
+  }
+}
+
+void ResultWriter::error(std::string_view message)
+{
+  switch (format)
+  {
+  case ResultFormat::Text:
+    out << "ERR ";
+    textField(out, message);
+    out << '\n';
+    break;
+  case ResultFormat::Json:
+    out << "{\"ok\":false,\"error\":";
+    jsonString(out, message);
+    out << "}\n";
+    break;
+  case ResultFormat::Csv:
+    out << "error\n";
+    csvField(out, message);
+    out << "\n\n";
+    break;
+  }
+}
+
+void ResultWriter::ingredient(const Ingredient &item)
+{
+  switch (format)
+  {
+  case ResultFormat::Text:
+    textField(out, item.name());
+    out << '\t';
+    quantity(out, item.quantity);
+    out << '\t' << unitName(item.unit) << '\n';
+    break;
+  case ResultFormat::Json:
+    out << "{\"name\":";
+    jsonString(out, item.name());
+    out << ",\"quantity\":";
+    quantity(out, item.quantity);
+    out << ",\"unit\":\"" << unitName(item.unit) << "\"}";
+    break;
+  case ResultFormat::Csv:
+    csvField(out, item.name());
+    out << ',';
+    quantity(out, item.quantity);
+    out << ',' << unitName(item.unit);
+    break;
+  }
+}
+
+/**
+ * @brief Copies runs of plain characters in one write and escapes the rest.
+ *
+ * Quotes, backslashes and control characters are escaped; everything else,
+ * including UTF-8 sequences, is copied as is.
+ */
+void ResultWriter::jsonString(OutputSink &out, std::string_view text)
+{
+  static constexpr char hex[] = "0123456789abcdef";
+  out << '"';
+  size_t run = 0;
+  for (size_t i = 0; i < text.size(); ++i)
+  {
+    unsigned char c = static_cast<unsigned char>(text[i]);
+    if (c >= 0x20 && c != '"' && c != '\\')
+    {
+      continue;
+    }
+    out.write(text.data() + run, i - run);
+    run = i + 1;
+    switch (c)
+    {
+    case '"':
+      out << "\\\"";
+      break;
+    case '\\':
+      out << "\\\\";
+      break;
+    case '\n':
+      out << "\\n";
+      break;
+    case '\r':
+      out << "\\r";
+      break;
+    case '\t':
+      out << "\\t";
+      break;
+    default:
+      out << "\\u00" << hex[c >> 4] << hex[c & 0xF];
+      break;
+    }
+  }
+  out.write(text.data() + run, text.size() - run);
+  out << '"';
+}
+
+void ResultWriter::textField(OutputSink &out, std::string_view text)
+{
+  size_t run = 0;
+  for (size_t special = text.find_first_of("\\\t\n\r"); special != std::string_view::npos;
+       special = text.find_first_of("\\\t\n\r", special + 1))
+  {
+    out.write(text.data() + run, special - run);
+    switch (text[special])
+    {
+    case '\t':
+      out << "\\t";
+      break;
+    case '\n':
+      out << "\\n";
+      break;
+    case '\r':
+      out << "\\r";
+      break;
+    default:
+      out << "\\\\";
+      break;
+    }
+    run = special + 1;
+  }
+  out.write(text.data() + run, text.size() - run);
+}
+
+/**
+ * @brief Quotes the field if it holds a comma, a quote or a line break, doubling its quotes.
+ */
+void ResultWriter::csvField(OutputSink &out, std::string_view text)
+{
+  if (text.find_first_of(",\"\r\n") == std::string_view::npos)
+  {
+    out << text;
+    return;
+  }
+  out << '"';
+  size_t run = 0;
+  for (size_t quote = text.find('"'); quote != std::string_view::npos; quote = text.find('"', quote + 1))
+  {
+    out.write(text.data() + run, quote + 1 - run);
+    out << '"';
+    run = quote + 1;
+  }
+  out.write(text.data() + run, text.size() - run);
+  out << '"';
+}
+
+void ResultWriter::quantity(OutputSink &out, std::int32_t quantity)
+{
+  // Widened so that negating the smallest int32 cannot overflow.
+  std::int64_t value = quantity;
+  if (value < 0)
+  {
+    out << '-';
+    value = -value;
+  }
+  out << value / Ingredient::quantityScale;
+  std::int64_t hundredths = value % Ingredient::quantityScale;
+  if (hundredths != 0)
+  {
+    out << '.' << static_cast<char>('0' + hundredths / 10);
+    if (hundredths % 10 != 0)
+    {
+      out << static_cast<char>('0' + hundredths % 10);
+    }
+  }
+}
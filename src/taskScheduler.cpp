@@ -0,0 +1,355 @@
+/**
+ * @file taskScheduler.cpp
+ * @brief Implementation of the TaskScheduler class.
+ */
+
+#include "../include/taskScheduler.hpp"
+
+thread_local TaskScheduler::Worker *TaskScheduler::currentWorker = nullptr;
+
+namespace
+{
+  constexpr size_t initialDequeCapacity = 64; ///< Deques hold about log2(range / grain) tasks per nested loop
+  constexpr int searchRounds = 64;            ///< Failed rounds of stealing before a worker goes to sleep
+}
+
+TaskScheduler::WorkDeque::WorkDeque()
+{
+  arrays.push_back(std::make_unique<Array>(initialDequeCapacity));
+  array.store(arrays.back().get(), std::memory_order_relaxed);
+}
+
+void TaskScheduler::WorkDeque::push(Task *task)
+{
+  std::int64_t b = bottom.load(std::memory_order_relaxed);
+  std::int64_t t = top.load(std::memory_order_acquire);
+  Array *a = array.load(std::memory_order_relaxed);
+  if (b - t > static_cast<std::int64_t>(a->mask))
+  {
+    auto grown = std::make_unique<Array>((a->mask + 1) * 2);
+    for (std::int64_t i = t; i < b; ++i)
+    {
+      grown->slots[static_cast<size_t>(i) & grown->mask].store(
+          a->slots[static_cast<size_t>(i) & a->mask].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    a = grown.get();
+    arrays.push_back(std::move(grown));
+    array.store(a, std::memory_order_release);
+  }
+  a->slots[static_cast<size_t>(b) & a->mask].store(task, std::memory_order_relaxed);
+  bottom.store(b + 1, std::memory_order_seq_cst);
+}
+
+TaskScheduler::Task *TaskScheduler::WorkDeque::take()
+{
+  std::int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+  Array *a = array.load(std::memory_order_relaxed);
+  bottom.store(b, std::memory_order_seq_cst);
+  std::int64_t t = top.load(std::memory_order_seq_cst);
+  if (t > b)
+  {
+    bottom.store(b + 1, std::memory_order_release);
+    return nullptr;
+  }
+  Task *task = a->slots[static_cast<size_t>(b) & a->mask].load(std::memory_order_relaxed);
+  if (t == b)
+  {
+    // Last task: race the thieves for it.
+    if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+    {
+      task = nullptr;
+    }
+    bottom.store(b + 1, std::memory_order_release);
+  }
+  return task;
+}
+
+TaskScheduler::Task *TaskScheduler::WorkDeque::steal()
+{
+  std::int64_t t = top.load(std::memory_order_seq_cst);
+  std::int64_t b = bottom.load(std::memory_order_seq_cst);
+  if (t >= b)
+  {
+    return nullptr;
+  }
+  Array *a = array.load(std::memory_order_acquire);
+  Task *task = a->slots[static_cast<size_t>(t) & a->mask].load(std::memory_order_relaxed);
+  if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+  {
+    return nullptr;
+  }
+  return task;
+}
+
+bool TaskScheduler::WorkDeque::empty() const
+{
+  return bottom.load(std::memory_order_seq_cst) <= top.load(std::memory_order_seq_cst);
+}
+
+/**
+ * @brief Starts the workers, all of them looking for work.
+ */
+TaskScheduler::TaskScheduler(size_t workerCount)
+{
+  workerCount = std::max<size_t>(workerCount, 1);
+  for (size_t i = 0; i < workerCount; ++i)
+  {
+    auto worker = std::make_unique<Worker>();
+    worker->owner = this;
+    worker->random = 0x9E3779B97F4A7C15ull * (i + 1);
+    workers.push_back(std::move(worker));
+  }
+  searching.store(workerCount);
+  for (auto &worker : workers)
+  {
+    threads.emplace_back([this, &self = *worker]()
+                         { workerLoop(self); });
+  }
+}
+
+TaskScheduler::~TaskScheduler()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  wake.notify_all();
+  for (auto &thread : threads)
+  {
+    thread.join();
+  }
+}
+
+TaskScheduler &TaskScheduler::shared()
+{
+  static TaskScheduler scheduler(std::max(1u, std::thread::hardware_concurrency()));
+  return scheduler;
+}
+
+/**
+ * @brief Runs tasks until the scheduler stops.
+ *
+ * A worker that finds nothing after searchRounds rounds goes to sleep. The
+ * sleep protocol pairs with push(): the worker stops counting as searching,
+ * counts itself as sleeping, then checks every deque once more, while a
+ * pusher publishes its task, then reads both counters. All of these are
+ * sequentially consistent, so either the worker sees the task or the pusher
+ * sees a sleeper and no one searching, and wakes it.
+ */
+void TaskScheduler::workerLoop(Worker &self)
+{
+  currentWorker = &self;
+  while (true)
+  {
+    Task *task = nullptr;
+    for (int round = 0; round < searchRounds && task == nullptr; ++round)
+    {
+      task = findTask(self);
+      if (task == nullptr)
+      {
+        std::this_thread::yield();
+      }
+    }
+    if (task != nullptr)
+    {
+      // If the last searcher found work there may be more: hand the search over.
+      if (searching.fetch_sub(1) == 1 && sleeping.load() > 0)
+      {
+        wakeOne();
+      }
+      runTask(*task);
+      searching.fetch_add(1);
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    searching.fetch_sub(1);
+    sleeping.fetch_add(1);
+    size_t seen = wakeups;
+    if (!stopping && !haveWork())
+    {
+      wake.wait(lock, [&]()
+                { return wakeups != seen || stopping; });
+    }
+    sleeping.fetch_sub(1);
+    searching.fetch_add(1);
+    if (stopping)
+    {
+      return;
+    }
+  }
+}
+
+/**
+ * @brief Takes from the worker's own deque, then steals, then takes a handed-over task.
+ */
+TaskScheduler::Task *TaskScheduler::findTask(Worker &self)
+{
+  if (Task *task = self.deque.take())
+  {
+    return task;
+  }
+  self.random ^= self.random << 13;
+  self.random ^= self.random >> 7;
+  self.random ^= self.random << 17;
+  size_t count = workers.size();
+  size_t start = static_cast<size_t>(self.random % count);
+  for (size_t i = 0; i < count; ++i)
+  {
+    Worker &victim = *workers[(start + i) % count];
+    if (&victim == &self)
+    {
+      continue;
+    }
+    if (Task *task = victim.deque.steal())
+    {
+      return task;
+    }
+  }
+  if (injectedCount.load(std::memory_order_relaxed) > 0)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!injected.empty())
+    {
+      Task *task = injected.front();
+      injected.pop_front();
+      injectedCount.fetch_sub(1, std::memory_order_relaxed);
+      return task;
+    }
+  }
+  return nullptr;
+}
+
+/**
+ * @brief Returns true if any task is waiting; called with the mutex held.
+ */
+bool TaskScheduler::haveWork() const
+{
+  if (!injected.empty())
+  {
+    return true;
+  }
+  for (const auto &worker : workers)
+  {
+    if (!worker->deque.empty())
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+void TaskScheduler::runTask(Task &task)
+{
+  bool external = task.external;
+  if (task.detached)
+  {
+    task.execute(task); // Frees the task
+    return;
+  }
+  task.execute(task);
+  if (external)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    task.done.store(true, std::memory_order_relaxed);
+    finished.notify_all();
+  }
+  else
+  {
+    // The forking thread may return, destroying the task, as soon as it sees this.
+    task.done.store(true, std::memory_order_release);
+  }
+}
+
+void TaskScheduler::push(Worker &self, Task &task)
+{
+  self.deque.push(&task);
+  if (searching.load() == 0 && sleeping.load() > 0)
+  {
+    wakeOne();
+  }
+}
+
+void TaskScheduler::wakeOne()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    ++wakeups;
+  }
+  wake.notify_one();
+}
+
+/**
+ * @brief Steals until the task is done.
+ *
+ * Tasks handed over by non-worker threads are left alone: they may be whole
+ * operations, and would hold up the join this worker is in.
+ */
+void TaskScheduler::waitFor(Worker &self, const Task &task)
+{
+  int idle = 0;
+  while (!task.done.load(std::memory_order_acquire))
+  {
+    Task *other = self.deque.take();
+    size_t count = workers.size();
+    for (size_t i = 0; other == nullptr && i < count; ++i)
+    {
+      if (workers[i].get() != &self)
+      {
+        other = workers[i]->deque.steal();
+      }
+    }
+    if (other != nullptr)
+    {
+      runTask(*other);
+      idle = 0;
+    }
+    else if (++idle > searchRounds)
+    {
+      std::this_thread::yield();
+    }
+  }
+}
+
+void TaskScheduler::runExternal(Task &task)
+{
+  task.external = true;
+  std::unique_lock<std::mutex> lock(mutex);
+  injected.push_back(&task);
+  injectedCount.fetch_add(1, std::memory_order_relaxed);
+  ++wakeups;
+  wake.notify_one();
+  finished.wait(lock, [&]()
+                { return task.done.load(std::memory_order_relaxed); });
+}
+
+/**
+ * @brief Queues the coroutine on the handover queue.
+ *
+ * The deques are left alone even on a worker: join() expects the bottom of
+ * the caller's deque to hold the task it forked, and a coroutine may be
+ * resumed from inside one.
+ */
+void TaskScheduler::resume(std::coroutine_handle<> handle)
+{
+  struct ResumeTask : Task
+  {
+    std::coroutine_handle<> handle;
+  };
+  auto *task = new ResumeTask();
+  task->handle = handle;
+  task->detached = true;
+  task->execute = [](Task &self)
+  {
+    std::coroutine_handle<> coroutine = static_cast<ResumeTask &>(self).handle;
+    delete &static_cast<ResumeTask &>(self);
+    coroutine.resume();
+  };
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    injected.push_back(task);
+    injectedCount.fetch_add(1, std::memory_order_relaxed);
+    ++wakeups;
+  }
+  wake.notify_one();
+}
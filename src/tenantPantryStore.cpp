@@ -0,0 +1,210 @@
+/**
+ * @file tenantPantryStore.cpp
+ * @brief Implementation of the TenantPantry and TenantPantryStore classes.
+ */
+
+#include "../include/tenantPantryStore.hpp"
+
+TenantPantry::TenantPantry(const std::vector<std::uint32_t> &nameIds) : count(nameIds.size())
+{
+  for (std::uint32_t id : nameIds)
+  {
+    names.add(id);
+  }
+  size_t words = nameIds.empty() ? 0 : nameIds.back() / 64 + 1;
+  if (words * sizeof(std::uint64_t) < nameIds.size() * sizeof(std::uint32_t))
+  {
+    bits.assign(words, 0);
+    for (std::uint32_t id : nameIds)
+    {
+      bits[id / 64] |= std::uint64_t(1) << (id % 64);
+    }
+  }
+  else
+  {
+    sorted = nameIds;
+  }
+}
+
+std::vector<std::uint32_t> TenantPantry::ids() const
+{
+  if (bits.empty())
+  {
+    return sorted;
+  }
+  std::vector<std::uint32_t> out;
+  out.reserve(count);
+  for (size_t word = 0; word < bits.size(); ++word)
+  {
+    for (std::uint64_t set = bits[word]; set != 0; set &= set - 1)
+    {
+      out.push_back(static_cast<std::uint32_t>(word * 64 + static_cast<size_t>(__builtin_ctzll(set))));
+    }
+  }
+  return out;
+}
+
+MemoryUsage TenantPantry::memoryUsage() const
+{
+  MemoryUsage usage{sizeof(TenantPantry), sizeof(TenantPantry)};
+  usage += {sorted.size() * sizeof(std::uint32_t), sorted.capacity() * sizeof(std::uint32_t)};
+  usage += {bits.size() * sizeof(std::uint64_t), bits.capacity() * sizeof(std::uint64_t)};
+  return usage;
+}
+
+TenantPantryStore::TenantPantryStore()
+{
+  empty = intern({});
+}
+
+void TenantPantryStore::defineStarter(const std::string &name, std::vector<std::uint32_t> nameIds)
+{
+  std::sort(nameIds.begin(), nameIds.end());
+  nameIds.erase(std::unique(nameIds.begin(), nameIds.end()), nameIds.end());
+  std::lock_guard<std::mutex> lock(mutex);
+  starters[name] = intern(nameIds);
+}
+
+bool TenantPantryStore::createTenant(std::uint64_t tenant, std::string_view starter)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  PantryPtr pantry = empty;
+  if (!starter.empty())
+  {
+    const PantryPtr *found = starters.find(starter);
+    if (found == nullptr)
+    {
+      return false;
+    }
+    pantry = *found;
+  }
+  assign(tenants[tenant], std::move(pantry));
+  return true;
+}
+
+bool TenantPantryStore::eraseTenant(std::uint64_t tenant)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  PantryPtr *slot = tenants.find(tenant);
+  if (slot == nullptr)
+  {
+    return false;
+  }
+  assign(*slot, nullptr);
+  tenants.erase(tenant);
+  return true;
+}
+
+bool TenantPantryStore::put(std::uint64_t tenant, std::uint32_t nameId)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  PantryPtr &slot = *tenants.tryEmplace(tenant, empty).first;
+  if (slot->contains(nameId))
+  {
+    return false;
+  }
+  std::vector<std::uint32_t> ids = slot->ids();
+  ids.insert(std::lower_bound(ids.begin(), ids.end(), nameId), nameId);
+  assign(slot, intern(ids));
+  return true;
+}
+
+bool TenantPantryStore::remove(std::uint64_t tenant, std::uint32_t nameId)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  PantryPtr *slot = tenants.find(tenant);
+  if (slot == nullptr || !(*slot)->contains(nameId))
+  {
+    return false;
+  }
+  std::vector<std::uint32_t> ids = (*slot)->ids();
+  ids.erase(std::lower_bound(ids.begin(), ids.end(), nameId));
+  assign(*slot, intern(ids));
+  return true;
+}
+
+TenantPantryStore::PantryPtr TenantPantryStore::find(std::uint64_t tenant) const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  const PantryPtr *slot = tenants.find(tenant);
+  return slot == nullptr ? nullptr : *slot;
+}
+
+TenantPantryStats TenantPantryStore::stats() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return {tenants.size(), interned.size(), starters.size()};
+}
+
+/**
+ * @brief Sums the tables and each distinct pantry once.
+ *
+ * A pantry built by make_shared also carries a control block of two
+ * pointers-worth of reference counts, counted with it.
+ */
+MemoryUsage TenantPantryStore::memoryUsage() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  MemoryUsage usage = tenants.memoryUsage();
+  usage += interned.memoryUsage();
+  usage += starters.memoryUsage();
+  interned.forEach([&](std::uint64_t, const PantryPtr &pantry)
+                   {
+                     usage += pantry->memoryUsage();
+                     usage += {2 * sizeof(void *), 2 * sizeof(void *)}; });
+  starters.forEach([&](const std::string &name, const PantryPtr &)
+                   { usage += {name.size(), name.capacity() > std::string().capacity() ? name.capacity() + 1 : 0}; });
+  return usage;
+}
+
+TenantPantryStore::PantryPtr TenantPantryStore::intern(const std::vector<std::uint32_t> &nameIds)
+{
+  auto candidate = std::make_shared<const TenantPantry>(nameIds);
+  auto inserted = interned.tryEmplace(candidate->fingerprint().low, candidate);
+  if (!inserted.second && (*inserted.first)->fingerprint() != candidate->fingerprint())
+  {
+    // Two sets share the low half of their fingerprint: keep this one unshared.
+    return candidate;
+  }
+  if (interned.size() >= sweepAt)
+  {
+    PantryPtr result = *inserted.first;
+    sweep();
+    return result;
+  }
+  return *inserted.first;
+}
+
+void TenantPantryStore::assign(PantryPtr &slot, PantryPtr next)
+{
+  PantryPtr previous = std::move(slot);
+  slot = std::move(next);
+  // Held by the intern table and previous only: no tenant, starter or query uses it.
+  if (previous && previous != empty && previous.use_count() == 2)
+  {
+    const PantryPtr *entry = interned.find(previous->fingerprint().low);
+    if (entry != nullptr && *entry == previous)
+    {
+      interned.erase(previous->fingerprint().low);
+    }
+  }
+}
+
+/**
+ * @brief Drops unused pantries, then waits for the table to double before the next sweep.
+ */
+void TenantPantryStore::sweep()
+{
+  std::vector<std::uint64_t> unused;
+  interned.forEach([&](std::uint64_t key, const PantryPtr &pantry)
+                   {
+                     if (pantry.use_count() == 1 && pantry != empty)
+                     {
+                       unused.push_back(key);
+                     } });
+  for (std::uint64_t key : unused)
+  {
+    interned.erase(key);
+  }
+  sweepAt = std::max<size_t>(64, interned.size() * 2);
+}
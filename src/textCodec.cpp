@@ -0,0 +1,227 @@
+/**
+ * @file textCodec.cpp
+ * @brief Implementation of the TextCodec static-dictionary compressor.
+ */
+
+#include "../include/textCodec.hpp"
+#include <algorithm>
+#include <unordered_map>
+
+namespace
+{
+  constexpr unsigned char firstCode = 0x80;
+  constexpr unsigned char escapeCode = 0xFF;
+  constexpr size_t maxPhraseWords = 5;
+  constexpr size_t minPhraseLength = 3;
+  constexpr size_t maxPhraseLength = 48;
+}
+
+/**
+ * @brief Learns the phrases that save the most bytes across the corpus.
+ *
+ * Candidates are runs of 1 to 5 whole words (with their trailing space)
+ * starting at a word boundary. Each candidate is scored by the bytes it would
+ * save, count * (length - 1), minus its own cost in the dictionary. The best
+ * candidates are picked greedily, skipping phrases that only ever occur inside
+ * an already chosen, longer phrase.
+ *
+ * @param [in] corpus Texts to learn from
+ */
+void TextCodec::train(const std::vector<std::string_view> &corpus)
+{
+  std::unordered_map<std::string_view, size_t> counts;
+  for (std::string_view text : corpus)
+  {
+    for (size_t start = 0; start < text.size(); ++start)
+    {
+      if (text[start] == ' ' || (start > 0 && text[start - 1] != ' '))
+        continue;
+
+      size_t end = start;
+      for (size_t words = 0; words < maxPhraseWords && end < text.size(); ++words)
+      {
+        end = text.find(' ', end);
+        end = (end == std::string_view::npos) ? text.size() : end + 1;
+        size_t length = end - start;
+        if (length > maxPhraseLength)
+          break;
+        if (length >= minPhraseLength)
+          ++counts[text.substr(start, length)];
+      }
+    }
+  }
+
+  struct Candidate
+  {
+    std::string_view phrase;
+    size_t count;
+    long long score;
+  };
+  std::vector<Candidate> candidates;
+  for (const auto &entry : counts)
+  {
+    long long length = static_cast<long long>(entry.first.size());
+    long long score = static_cast<long long>(entry.second) * (length - 1) - length;
+    if (entry.second > 1 && score > 0)
+      candidates.push_back({entry.first, entry.second, score});
+  }
+  std::sort(candidates.begin(), candidates.end(), [](const Candidate &a, const Candidate &b)
+            { return a.score != b.score ? a.score > b.score : a.phrase < b.phrase; });
+
+  std::vector<std::pair<std::string, size_t>> chosen;
+  for (const auto &candidate : candidates)
+  {
+    if (chosen.size() == maxEntries)
+      break;
+    bool shadowed = std::any_of(chosen.begin(), chosen.end(), [&](const auto &c)
+                                { return c.second >= candidate.count &&
+                                         c.first.find(candidate.phrase) != std::string::npos; });
+    if (!shadowed)
+      chosen.emplace_back(std::string(candidate.phrase), candidate.count);
+  }
+
+  entries.clear();
+  for (auto &c : chosen)
+  {
+    entries.push_back(std::move(c.first));
+  }
+  buildLookup();
+}
+
+/**
+ * @brief Replaces the dictionary with phrases saved from another codec.
+ *
+ * @param [in] phrases Phrases in code order, as returned by phrases()
+ */
+void TextCodec::load(const std::vector<std::string_view> &phrases)
+{
+  entries.clear();
+  for (std::string_view phrase : phrases)
+  {
+    if (entries.size() == maxEntries || phrase.empty())
+      break;
+    entries.emplace_back(phrase);
+  }
+  buildLookup();
+}
+
+/**
+ * @brief Rebuilds the first-byte lookup table from the entries.
+ */
+void TextCodec::buildLookup()
+{
+  byFirst.assign(256, {});
+  for (size_t i = 0; i < entries.size(); ++i)
+  {
+    byFirst[static_cast<unsigned char>(entries[i][0])].push_back(static_cast<unsigned char>(i));
+  }
+  for (auto &bucket : byFirst)
+  {
+    std::sort(bucket.begin(), bucket.end(), [&](unsigned char a, unsigned char b)
+              { return entries[a].size() > entries[b].size(); });
+  }
+}
+
+/**
+ * @brief Greedily replaces the longest dictionary phrase at every position.
+ *
+ * @param [in] text Raw text
+ * @return Encoded bytes
+ */
+std::string TextCodec::encode(std::string_view text) const
+{
+  if (!trained())
+    return std::string(text);
+
+  std::string out;
+  out.reserve(text.size());
+  size_t pos = 0;
+  while (pos < text.size())
+  {
+    unsigned char c = static_cast<unsigned char>(text[pos]);
+    bool matched = false;
+    for (unsigned char index : byFirst[c])
+    {
+      const std::string &phrase = entries[index];
+      if (text.compare(pos, phrase.size(), phrase) == 0)
+      {
+        out.push_back(static_cast<char>(firstCode + index));
+        pos += phrase.size();
+        matched = true;
+        break;
+      }
+    }
+    if (matched)
+      continue;
+    if (c >= firstCode)
+      out.push_back(static_cast<char>(escapeCode));
+    out.push_back(static_cast<char>(c));
+    ++pos;
+  }
+  return out;
+}
+
+/**
+ * @brief Expands every code back into its phrase.
+ *
+ * @param [in] data Bytes produced by encode()
+ * @return Decoded text
+ */
+std::string TextCodec::decode(std::string_view data) const
+{
+  if (!trained())
+    return std::string(data);
+
+  std::string out;
+  out.reserve(data.size() * 2);
+  for (size_t i = 0; i < data.size(); ++i)
+  {
+    unsigned char c = static_cast<unsigned char>(data[i]);
+    if (c < firstCode)
+    {
+      out.push_back(static_cast<char>(c));
+    }
+    else if (c == escapeCode)
+    {
+      if (++i < data.size())
+        out.push_back(data[i]);
+    }
+    else if (static_cast<size_t>(c - firstCode) < entries.size())
+    {
+      out += entries[c - firstCode];
+    }
+  }
+  return out;
+}
+
+/**
+ * @brief Returns the number of bytes used by the dictionary phrases.
+ */
+size_t TextCodec::dictionaryBytes() const
+{
+  size_t bytes = 0;
+  for (const auto &entry : entries)
+  {
+    bytes += entry.size();
+  }
+  return bytes;
+}
+
+MemoryUsage TextCodec::memoryUsage() const
+{
+  MemoryUsage usage;
+  usage.used = dictionaryBytes() + entries.size() * sizeof(std::string);
+  usage.reserved = entries.capacity() * sizeof(std::string);
+  for (const auto &entry : entries)
+  {
+    usage.reserved += stringHeapBytes(entry);
+  }
+  usage.reserved = std::max(usage.reserved, usage.used);
+  usage.reserved += byFirst.capacity() * sizeof(byFirst[0]);
+  for (const auto &bucket : byFirst)
+  {
+    usage.used += bucket.size();
+    usage.reserved += bucket.capacity();
+  }
+  return usage;
+}
@@ -7,6 +7,7 @@
  */
 
 #include "../include/utils.hpp"
+#include "../include/outputSink.hpp"
 #include <iostream>
 #include <limits>
 
@@ -31,6 +32,22 @@ std::string trim(const std::string &s)
   return s.substr(first, last - first + 1);
 };
 
+/**
+ * @brief Trims leading and trailing whitespace from a string view.
+ *
+ * @param [in] s Input view to trim
+ * @return A view into s without surrounding whitespace
+ */
+std::string_view trimView(std::string_view s)
+{
+  const char *whitespace = " \t\r\n\f\v";
+  size_t first = s.find_first_not_of(whitespace);
+  if (first == std::string_view::npos)
+    return {};
+  size_t last = s.find_last_not_of(whitespace);
+  return s.substr(first, last - first + 1);
+}
+
 /**
  * @brief Reads and validates integer input within a specified range.
  *
@@ -39,6 +56,7 @@ std::string trim(const std::string &s)
  * - It falls within the given min and max bounds (inclusive).
  *
  * Handles invalid input by clearing error flags and flushing the input buffer.
+ * The console sink is flushed first, so the prompt is on screen before the read.
  *
  * @param [out] outValue Reference to store the validated integer
  * @param [in] min Minimum allowed value (inclusive)
@@ -47,15 +65,16 @@ std::string trim(const std::string &s)
  */
 bool getIntegerInput(int &outValue, int min, int max)
 {
-  // Attempt to extract integer from input stream
+  OutputSink &out = OutputSink::console();
+  out.flush();
 
+  // Attempt to extract integer from input stream
   if (!(std::cin >> outValue))
   {
     // Input extraction failed (e.g., user entered text instead of number)
     std::cin.clear();
     std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-    std::cout << "Invalid input.\n"
-              << std::endl;
+    out << "Invalid input.\n\n";
     return false;
   }
   else
@@ -66,9 +85,8 @@ bool getIntegerInput(int &outValue, int min, int max)
   if (outValue < min || outValue > max)
   {
     // Validate the integer is within the expected range
-    std::cout << "Choice out of range. Input a number between "
-              << min << " and " << max << ".\n"
-              << std::endl;
+    out << "Choice out of range. Input a number between "
+        << min << " and " << max << ".\n\n";
     return false;
   }
 